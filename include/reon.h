@@ -0,0 +1,208 @@
+/**
+\file reon.h
+\brief Declares the in-memory compilation API of libreon.
+\author Radek Vít
+*/
+#ifndef REON
+#define REON
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace reon {
+
+/**
+\brief Version of reon; outputs may differ between versions.
+*/
+constexpr const char *version = "0.1.1";
+
+// error codes
+/**
+Runtime error return value.
+ */
+constexpr int RUNTIME_ERROR = 1;
+/**
+Invalid argument was passed to the application or some function return value.
+ */
+constexpr int INVALID_ARGUMENT = 2;
+/**
+An unspecified error within ctf return value.
+*/
+constexpr int TRANSLATION_ENGINE_ERROR = 3;
+/**
+Lexical analysis error return value.
+*/
+constexpr int LEXICAL_ERROR = 5;
+/**
+A syntax error return value.
+*/
+constexpr int SYNTAX_ERROR = 6;
+/**
+A semantic error return value.
+ */
+constexpr int SEMANTIC_ERROR = 7;
+/**
+Unknown error return value.
+ */
+constexpr int UNKNOWN_EXCEPTION = 666;
+
+/**
+\brief Syntax of a compiled pattern.
+*/
+enum class Target : uint8_t {
+  /**
+  \brief Python 3 re pattern assigned to a variable.
+  */
+  PYTHON,
+  /**
+  \brief RE2 pattern on its own line.
+  */
+  RE2
+};
+
+/**
+\brief Settings of a compilation.
+*/
+struct Options {
+  Target target = Target::PYTHON;
+  /**
+  \brief Name of the assigned Python variable; alphabetical characters only.
+  */
+  std::string variable = "re";
+  /**
+  \brief Names of the rewrite passes that do not run.
+  */
+  std::vector<std::string> disabledPasses{};
+  /**
+  \brief Reports catastrophic backtracking as warnings.
+  */
+  bool redos = false;
+  /**
+  \brief Reports catastrophic backtracking as errors; implies redos.
+  */
+  bool redosStrict = false;
+  /**
+  \brief Computes the bounds of the length of matches. Python patterns are
+  followed by them as the assignments of variable_minlen and variable_maxlen.
+  */
+  bool lengths = false;
+  /**
+  \brief Extracts the prefilter of the pattern. Python patterns are followed
+  by it as variable_required, variable_first and variable_prefilter.
+  */
+  bool prefilter = false;
+};
+
+/**
+\brief Kind of a diagnostic, corresponding to the error codes of reon.
+*/
+enum class DiagnosticKind : uint8_t {
+  LEXICAL,
+  SYNTAX,
+  SEMANTIC,
+  /**
+  \brief Catastrophic backtracking found by the static analysis.
+  */
+  BACKTRACKING,
+  /**
+  \brief Invalid options.
+  */
+  OPTIONS,
+  /**
+  \brief Other failures of the translation.
+  */
+  INTERNAL
+};
+
+/**
+\brief A warning or an error of a compilation.
+*/
+struct Diagnostic {
+  DiagnosticKind kind;
+  bool error;
+  /**
+  \brief Row and column in the input, 0 if unknown.
+  */
+  size_t row = 0;
+  size_t col = 0;
+  std::string message;
+};
+
+/**
+\brief Result of a compilation.
+*/
+struct Result {
+  /**
+  \brief Set if the pattern compiled; warnings do not fail the compilation.
+  */
+  bool ok = false;
+  /**
+  \brief Return value of the reon executable for the same input; 0 if the
+  pattern compiled.
+  */
+  int code = 0;
+  /**
+  \brief The compiled pattern. Empty if the compilation failed.
+  */
+  std::string output;
+  std::vector<Diagnostic> diagnostics;
+  /**
+  \brief Bounds of the length of matches in characters, computed if
+  Options::lengths. maxLength is unused if unboundedLength.
+  */
+  size_t minLength = 0;
+  size_t maxLength = 0;
+  bool unboundedLength = false;
+  /**
+  \brief Literals every match contains, longest first; extracted if
+  Options::prefilter.
+  */
+  std::vector<std::string> requiredLiterals{};
+  /**
+  \brief Bits of the bytes matches may begin with, byte b in bit b % 64 of
+  firstBytes[b / 64]. All bits are set if any byte may begin a match or the
+  match may be empty.
+  */
+  uint64_t firstBytes[4] = {};
+};
+
+/**
+\brief Compiles reon with fixed options and reuses its buffers between
+compilations. Not thread safe; use one compiler per thread.
+*/
+class Compiler {
+ public:
+  explicit Compiler(const Options &options = {});
+  Compiler(Compiler &&) noexcept;
+  Compiler &operator=(Compiler &&) noexcept;
+  ~Compiler();
+
+  /**
+  \brief Compiles reon held in memory. Does not throw on invalid input.
+  \param[in] input The reon input.
+  */
+  Result compile(std::string_view input);
+
+ protected:
+  class State;
+  std::unique_ptr<State> state_;
+};
+
+/**
+\brief Compiles reon held in memory with a temporary Compiler.
+*/
+Result compile(std::string_view input, const Options &options = {});
+
+/**
+\brief Returns true if a name can be used as the assigned variable.
+*/
+bool valid_variable(std::string_view name);
+
+}  // namespace reon
+
+#endif
+/*** End of file reon.h ***/
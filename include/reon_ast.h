@@ -0,0 +1,296 @@
+/**
+\file reon_ast.h
+\brief Declares the abstract syntax tree of reon patterns.
+\author Radek Vít
+*/
+#ifndef REON_AST
+#define REON_AST
+
+#include <reon_output_generator.h>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace reon {
+
+/**
+\brief Kinds of AST nodes.
+*/
+enum class AstKind : uint8_t {
+  /**
+  \brief Children matched one after another.
+  */
+  SEQUENCE,
+  /**
+  \brief One of the children; output as a non-capturing group unless BARE.
+  */
+  ALTERNATION,
+  /**
+  \brief The child repeated; text is the repeat string. The child is output
+  in a non-capturing group unless BARE.
+  */
+  REPEAT,
+  /**
+  \brief A 're' terminal; text is the string as written in reon.
+  */
+  LITERAL,
+  /**
+  \brief Never matches.
+  */
+  NEVER,
+  /**
+  \brief A character set; text is the set string.
+  */
+  SET,
+  /**
+  \brief A capturing group; text is the name of a named group.
+  */
+  GROUP,
+  /**
+  \brief A group reference; text is the name or the number.
+  */
+  REFERENCE,
+  /**
+  \brief A lookahead or lookbehind assertion of the child.
+  */
+  LOOKAROUND,
+  /**
+  \brief A conditional; text is the referenced group, children are the then
+  and the optional else branch.
+  */
+  CONDITIONAL,
+  /**
+  \brief A comment; text is the comment body.
+  */
+  COMMENT
+};
+
+/**
+\brief Flags of AST nodes.
+*/
+enum AstFlag : uint8_t {
+  /**
+  \brief Negated set or lookaround.
+  */
+  NEGATED = 1,
+  /**
+  \brief Non-greedy repeat.
+  */
+  NON_GREEDY = 2,
+  /**
+  \brief Named group or a reference by name.
+  */
+  NAMED = 4,
+  /**
+  \brief Lookbehind instead of lookahead.
+  */
+  BEHIND = 8,
+  /**
+  \brief Conditional with an else branch.
+  */
+  HAS_ELSE = 16,
+  /**
+  \brief Repeat or alternation output without a non-capturing group.
+  */
+  BARE = 32
+};
+
+/**
+\brief A node of the AST. Children form a singly linked list.
+*/
+struct AstNode {
+  AstKind kind;
+  uint8_t flags = 0;
+  /**
+  \brief First and last child and the next sibling; Ast::none if missing.
+  */
+  uint32_t first;
+  uint32_t last;
+  uint32_t next;
+  std::string_view text{};
+};
+
+/**
+\brief AST of a reon pattern. Nodes are stored in an arena and referred to by
+index.
+
+Texts refer to the input of the translation or to strings owned by the tree.
+*/
+class Ast {
+ public:
+  static constexpr uint32_t none = UINT32_MAX;
+
+  /**
+  \brief Removes all nodes and owned strings.
+  */
+  void clear() {
+    nodes_.clear();
+    strings_.clear();
+    root_ = none;
+  }
+
+  /**
+  \brief Creates a node without children.
+  \returns Index of the node.
+  */
+  uint32_t add(AstKind kind, std::string_view text = {}, uint8_t flags = 0) {
+    nodes_.push_back(AstNode{kind, flags, none, none, none, text});
+    return static_cast<uint32_t>(nodes_.size() - 1);
+  }
+
+  /**
+  \brief Appends a child to a node. The child must not be in another list.
+  */
+  void append(uint32_t parent, uint32_t child) {
+    AstNode &p = nodes_[parent];
+    if (p.first == none)
+      p.first = child;
+    else
+      nodes_[p.last].next = child;
+    p.last = child;
+  }
+
+  /**
+  \brief Stores a string created by a pass.
+  \returns View of the stored string, valid until clear.
+  */
+  std::string_view store(std::string s) {
+    strings_.push_back(std::move(s));
+    return strings_.back();
+  }
+
+  AstNode &operator[](uint32_t n) { return nodes_[n]; }
+  const AstNode &operator[](uint32_t n) const { return nodes_[n]; }
+
+  size_t size() const { return nodes_.size(); }
+  uint32_t root() const { return root_; }
+  void set_root(uint32_t root) { root_ = root; }
+
+  /**
+  \brief Returns the number of children of a node.
+  */
+  size_t child_count(uint32_t n) const {
+    size_t count = 0;
+    for (uint32_t c = nodes_[n].first; c != none; c = nodes_[c].next) {
+      ++count;
+    }
+    return count;
+  }
+
+ protected:
+  std::vector<AstNode> nodes_;
+  /**
+  \brief Strings created by passes; a deque keeps them in place.
+  */
+  std::deque<std::string> strings_;
+  uint32_t root_ = none;
+};
+
+/**
+\brief Returns true if a repeat string allows zero repetitions.
+*/
+inline bool optional_repeat(std::string_view repeat) {
+  if (repeat == "*" || repeat == "?")
+    return true;
+  if (repeat == "+")
+    return false;
+  std::string_view min = repeat.substr(0, repeat.find('-'));
+  return min.find_first_not_of('0') == std::string_view::npos;
+}
+
+/**
+\brief Returns true if a repeat string has no upper bound.
+*/
+inline bool unbounded_repeat(std::string_view repeat) {
+  return repeat == "*" || repeat == "+" || repeat.back() == '-';
+}
+
+/**
+\brief Bounds of the number of repetitions of a repeat string.
+*/
+struct RepeatBounds {
+  uint64_t min = 0;
+  uint64_t max = 0;
+  bool unbounded = false;
+};
+
+/**
+\brief Largest repeat count told apart by repeat_bounds; larger counts
+saturate to it.
+*/
+constexpr uint64_t maxRepeatCount = UINT32_MAX;
+
+/**
+\brief Parses a repeat string: *, +, ?, m, m-, -n or m-n.
+*/
+inline RepeatBounds repeat_bounds(std::string_view repeat) {
+  if (repeat == "*")
+    return RepeatBounds{0, 0, true};
+  if (repeat == "+")
+    return RepeatBounds{1, 0, true};
+  if (repeat == "?")
+    return RepeatBounds{0, 1, false};
+  auto count = [](std::string_view digits) {
+    uint64_t x = 0;
+    for (char c : digits) {
+      x = x * 10 + (c - '0');
+      if (x > maxRepeatCount)
+        return maxRepeatCount;
+    }
+    return x;
+  };
+  size_t dash = repeat.find('-');
+  if (dash == std::string_view::npos) {
+    uint64_t m = count(repeat);
+    return RepeatBounds{m, m, false};
+  }
+  std::string_view max = repeat.substr(dash + 1);
+  return RepeatBounds{count(repeat.substr(0, dash)), count(max), max.empty()};
+}
+
+/**
+\brief Maximal nesting of groups in an AST. Python cannot compile patterns
+nested this deep.
+*/
+constexpr size_t maxAstDepth = 1000;
+
+/**
+\brief Builds the AST of output symbols of reonGrammar.
+\param[in] symbols Output symbols of a translation.
+\param[out] ast The tree; cleared first.
+\returns False if the groups are nested deeper than maxAstDepth; the tree is
+not usable then.
+
+The LL translation outputs a flat list of symbols, which the output
+generators consume, so the tree is built from that list after parsing rather
+than by the parser. Passes therefore cost a build and a lowering back to
+symbols on top of the passes themselves, each linear in the symbols;
+--time-passes reports both.
+
+Throws SemanticError if the symbols are not balanced.
+*/
+bool build_ast(const std::vector<ReonSymbol> &symbols, Ast &ast);
+
+/**
+\brief Lowers an AST back to output symbols of reonGrammar.
+\param[in] ast The tree.
+\param[out] symbols The symbols; cleared first.
+
+Lowering the AST of a translation reproduces its symbols.
+*/
+void lower_ast(const Ast &ast, std::vector<ReonSymbol> &symbols);
+
+/**
+\brief Lowers a subtree of an AST to the output symbols of a pattern matching
+the subtree alone.
+*/
+void lower_ast(const Ast &ast, uint32_t root,
+               std::vector<ReonSymbol> &symbols);
+
+}  // namespace reon
+
+#endif
+/*** End of file reon_ast.h ***/
@@ -0,0 +1,62 @@
+/**
+\file reon_batch.h
+\brief Declares batch compilation of multiple reon inputs.
+\author Radek Vít
+*/
+#ifndef REON_BATCH
+#define REON_BATCH
+
+#include <istream>
+#include <string>
+#include <vector>
+
+/**
+\brief A single input of a batch translation.
+*/
+struct BatchJob {
+  /**
+  \brief Path to the input file.
+  */
+  std::string input;
+  /**
+  \brief Path to the output file. Empty if the output should go to the
+  default batch destination.
+  */
+  std::string output;
+};
+
+/**
+\brief Reads batch jobs from a manifest.
+\param[in] is Manifest stream.
+\param[in] name Manifest name for error messages.
+\returns Jobs in order of appearance.
+
+Each nonempty line that does not start with '#' contains an input path,
+optionally followed by whitespace and an output path.
+*/
+std::vector<BatchJob> read_manifest(std::istream &is, const std::string &name);
+
+/**
+\brief Reads batch jobs from newline delimited JSON.
+\param[in] is Input stream.
+\returns Jobs in order of appearance.
+
+Each nonempty line must contain an object with a string member "input" and an
+optional string member "output". Other members are ignored.
+*/
+std::vector<BatchJob> read_ndjson(std::istream &is);
+
+/**
+\brief Derives the output path of an input in an output directory.
+\param[in] directory Output directory.
+\param[in] input Input path.
+\param[in] extension Extension of the output, including the dot.
+\returns Path to a file in directory with the input's base name and the
+extension.
+*/
+std::string output_in_directory(const std::string &directory,
+                                const std::string &input,
+                                const std::string &extension = ".py");
+
+#endif
+/*** End of file reon_batch.h ***/
@@ -0,0 +1,91 @@
+/**
+\file reon_cache.h
+\brief Declares the content-addressed on-disk cache of translations.
+\author Radek Vít
+*/
+#ifndef REON_CACHE
+#define REON_CACHE
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace reon {
+
+/**
+\brief Directory of translations keyed on the hash of their input, their
+options and the reon version.
+
+Entries are written to a temporary file and renamed, so concurrent processes
+may share a directory. Only successful translations are stored. A single cache
+may be used by multiple threads.
+*/
+class Cache {
+ public:
+  /**
+  \brief 128-bit FNV-1a hash of a translation.
+  */
+  struct Key {
+    uint64_t high;
+    uint64_t low;
+
+    /**
+    \brief Returns the key as 32 hexadecimal digits.
+    */
+    std::string hex() const;
+  };
+
+  /**
+  \param[in] directory The cache directory. Created if it does not exist.
+
+  Throws std::invalid_argument if the directory cannot be created.
+  */
+  explicit Cache(std::string directory);
+
+  /**
+  \brief Computes the key of a translation.
+  \param[in] input The translated input.
+  \param[in] options Everything else that changes the output, e.g. the target
+  and the variable name. The reon version is added.
+  */
+  static Key key(std::string_view input, std::string_view options);
+
+  /**
+  \brief Reads a stored translation.
+  \param[out] output Receives the translation on a hit.
+  \returns True on a hit.
+  */
+  bool load(const Key &key, std::string &output);
+
+  /**
+  \brief Stores a translation. Failures to write are ignored.
+  */
+  void store(const Key &key, std::string_view output);
+
+  size_t hits() const { return hits_; }
+  size_t misses() const { return misses_; }
+
+  /**
+  \brief Prints the hit and miss counts.
+  */
+  void report(std::ostream &os) const;
+
+ protected:
+  std::string directory_;
+  std::atomic<size_t> hits_ = 0;
+  std::atomic<size_t> misses_ = 0;
+  /**
+  \brief Entries written by this cache.
+  */
+  std::atomic<size_t> stores_ = 0;
+
+  std::string path(const Key &key) const;
+};
+
+}  // namespace reon
+
+#endif
+/*** End of file reon_cache.h ***/
@@ -0,0 +1,45 @@
+/**
+\file reon_cpp_output.h
+\brief Declares the generation of C++ matchers from reon patterns.
+\author Radek Vít
+*/
+#ifndef REON_CPP_OUTPUT
+#define REON_CPP_OUTPUT
+
+#include <reon_prefilter.h>
+#include <reon_program.h>
+#include <cstddef>
+#include <ostream>
+#include <string_view>
+
+namespace reon {
+
+/**
+\brief Maximal number of DFA states of a generated matcher.
+*/
+constexpr size_t maxGeneratedStates = 4096;
+
+/**
+\brief Generates a self-contained C++ header with matchers of a program.
+\param[in] program The program.
+\param[in] name Namespace of the matchers, also used in the include guard.
+\param[out] output Output stream.
+\param[in] prefilter Prefilter of the pattern, may be nullptr. If given, the
+header also defines a prefilter function and search returns false for texts
+it rejects.
+
+The header defines search, match and full_match functions with the meaning of
+Python's re functions of the same names, returning whether text matches. Each
+function is a DFA encoded as a switch/goto state machine and depends only on
+std::string_view.
+
+Throws SemanticError for programs with word boundaries and for DFAs with more
+than maxGeneratedStates states.
+*/
+void generate_cpp(const Program &program, std::string_view name,
+                  std::ostream &output, const Prefilter *prefilter = nullptr);
+
+}  // namespace reon
+
+#endif
+/*** End of file reon_cpp_output.h ***/
@@ -0,0 +1,239 @@
+/**
+\file reon_dfa.h
+\brief Declares the lazily built DFA for matching reon patterns.
+\author Radek Vít
+*/
+#ifndef REON_DFA
+#define REON_DFA
+
+#include <reon_program.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace reon {
+
+/**
+\brief DFA built from a program on demand.
+
+A state is the ordered list of program threads at a position, so the DFA
+reports the same match ends as the Pike VM. States and their transitions are
+kept in a cache of bounded size, which is flushed when full. If the cache is
+flushed too often, scanning gives up and the caller falls back to the Pike
+VM.
+
+Programs with word boundary assertions are not supported. Not thread safe.
+*/
+class LazyDfa {
+ public:
+  /**
+  \brief Result of a scan.
+  */
+  enum class Result : uint8_t { MATCH, NO_MATCH, GAVE_UP };
+
+  /**
+  \brief Default cache size in bytes.
+  */
+  static constexpr size_t defaultCacheSize = 2 << 20;
+
+  /**
+  \brief Returns true if the program can be matched by a DFA.
+  */
+  static bool supported(const Program &program) {
+    return !program.wordBoundaries;
+  }
+
+  /**
+  \param[in] program The program. Must outlive the DFA.
+  \param[in] anchored Matches begin only where the scan begins.
+  \param[in] longest Finds the longest match instead of the match preferred by
+  the program.
+  \param[in] cacheSize Maximal memory used by states.
+  */
+  LazyDfa(const Program &program, bool anchored, bool longest,
+          size_t cacheSize = defaultCacheSize);
+
+  /**
+  \brief Scans text forward from its beginning.
+  \param[in] text Text to scan.
+  \param[in] earliest Stops at the first match end found.
+  \param[out] end End of the match.
+  */
+  Result forward(std::string_view text, bool earliest, size_t &end);
+
+  /**
+  \brief Scans text backward from a position.
+  \param[in] text Text to scan.
+  \param[in] from Position where the scan begins.
+  \param[out] begin Beginning of the match.
+  */
+  Result reverse(std::string_view text, size_t from, size_t &begin);
+
+  /**
+  \brief DFA with all states computed, used for code generation.
+  */
+  struct Tables {
+    static constexpr uint32_t dead = UINT32_MAX;
+
+    uint16_t byteClass[256];
+    size_t classCount;
+    /**
+    \brief State at the beginning of the text.
+    */
+    uint32_t start;
+    /**
+    \brief Transitions of each state, one per byte class; dead if no thread
+    survives.
+    */
+    std::vector<uint32_t> transitions;
+    /**
+    \brief States that have a match ending at their position.
+    */
+    std::vector<bool> match;
+    /**
+    \brief States that have a match at the end of a nonempty text.
+    */
+    std::vector<bool> matchAtEnd;
+    /**
+    \brief Set if the empty text matches.
+    */
+    bool emptyMatch;
+  };
+
+  /**
+  \brief Computes all states reachable from the beginning of a text.
+  \param[in] maxStates Maximal number of states.
+
+  Throws SemanticError if the DFA would have more than maxStates states or if
+  its states do not fit the cache. Must be called before scanning.
+  */
+  Tables tables(size_t maxStates);
+
+  size_t state_count() const { return states_.size(); }
+  size_t flush_count() const { return flushes_; }
+
+ protected:
+  /**
+  \brief Transition not computed yet.
+  */
+  static constexpr uint32_t unknown = UINT32_MAX;
+  /**
+  \brief State without threads.
+  */
+  static constexpr uint32_t dead = UINT32_MAX - 1;
+  /**
+  \brief Minimal number of bytes scanned per created state between flushes.
+  */
+  static constexpr size_t minBytesPerState = 10;
+
+  struct State {
+    /**
+    \brief Threads in pcs_; pc insts.size() restarts the search.
+    */
+    uint32_t begin;
+    uint32_t size;
+    bool match;
+  };
+
+  const Program &program_;
+  bool anchored_;
+  bool longest_;
+  size_t cacheSize_;
+  /**
+  \brief Pseudo pc restarting the search at the next position.
+  */
+  uint32_t restart_;
+
+  /**
+  \brief Equivalence class of each byte.
+  */
+  uint16_t byteClass_[256] = {};
+  /**
+  \brief A byte of each equivalence class.
+  */
+  std::vector<unsigned char> representative_;
+
+  std::vector<State> states_;
+  std::vector<uint32_t> pcs_;
+  /**
+  \brief Transitions of each state, one per byte class.
+  */
+  std::vector<uint32_t> transitions_;
+  std::unordered_map<std::string, uint32_t> ids_;
+  /**
+  \brief Start states at the beginning of the text and elsewhere.
+  */
+  uint32_t start_[2] = {unknown, unknown};
+  size_t memory_ = 0;
+  size_t flushes_ = 0;
+  /**
+  \brief Bytes scanned since the last flush.
+  */
+  size_t scanned_ = 0;
+
+  /**
+  \brief Work lists for computing states.
+  */
+  std::vector<uint32_t> list_;
+  std::vector<uint32_t> threads_;
+  std::vector<uint32_t> stack_;
+  /**
+  \brief Generation in which each pc was last visited by closure.
+  */
+  std::vector<uint32_t> visited_;
+  uint32_t generation_ = 0;
+
+  void compute_byte_classes();
+
+  /**
+  \brief Starts a new list of threads.
+  */
+  void clear_list();
+
+  /**
+  \brief Appends the threads reachable from pc to list_ in priority order.
+  \param[in] atBegin The position is the beginning of the text.
+  \param[in] atEnd The position is the end of the text.
+  \param[in,out] cut Set when a match cuts off threads with lower priority.
+  */
+  void closure(uint32_t pc, bool atBegin, bool atEnd, bool &cut);
+
+  /**
+  \brief Returns the state of the threads in list_, creating it if needed.
+  \returns The state, dead if list_ is empty, unknown if the cache is full.
+  */
+  uint32_t intern();
+
+  uint32_t start_state(bool atBegin);
+
+  /**
+  \brief Computes the transition of a state on a byte class.
+  \returns The next state, unknown if scanning gave up.
+  */
+  uint32_t transition(uint32_t state, uint16_t byteClass);
+
+  /**
+  \brief Returns true if a state matches at the end of the text.
+  */
+  bool matches_at_end(uint32_t state, bool atBegin);
+
+  /**
+  \brief Clears the cache.
+  \returns False if the cache is flushed too often.
+  */
+  bool flush();
+
+  /**
+  \brief Scans bytes of text from position in direction step.
+  */
+  Result scan(std::string_view text, size_t position, int step, bool earliest,
+              size_t &last);
+};
+
+}  // namespace reon
+
+#endif
+/*** End of file reon_dfa.h ***/
@@ -0,0 +1,234 @@
+/**
+\file reon_incremental.h
+\brief Declares the incremental translation of reon for editors and live
+previews.
+\author Radek Vít
+*/
+#ifndef REON_INCREMENTAL
+#define REON_INCREMENTAL
+
+#include <reon_translation.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace reon {
+
+/**
+\brief Translation of a document that is kept up to date with text edits.
+
+An edit re-lexes and re-parses only the innermost REON value enclosing it and
+splices the regenerated output of the value into the previous output, so
+lexing, parsing and output follow the size of that value rather than the
+size of the document; only the offsets after it are shifted.
+Edits that touch the group numbering, the group names or a lookbehind
+assertion regenerate the whole output from the kept symbols, and edits that
+leave the enclosing value or do not parse on their own translate the whole
+document again.
+
+After each valid edit, the rewrite passes run over the symbols of the whole
+document, so the output is the output of reon with the same passes. Lexing
+and parsing stay proportional to the enclosing value, but the passes and
+their output are linear in the document. With all passes disabled, edits
+only splice the output, which is then the output of reon without passes,
+e.g. (?:x)* instead of x*. ReDoS checks, lengths and prefilters are not run.
+*/
+class IncrementalTranslation : protected ReonTranslation {
+ public:
+  /**
+  \param[in] target Syntax of the generated regular expression.
+  \param[in] variable Name of the Python variable the pattern is assigned to.
+  */
+  explicit IncrementalTranslation(
+      ReonOutput::Target target = ReonOutput::Target::PYTHON,
+      std::string variable = "re");
+
+  /**
+  \brief Replaces the document and translates it.
+  \returns The output.
+
+  Throws LexicalError, TranslationError or SemanticError on errors; the
+  output of the last valid document is kept then.
+  */
+  const std::string &set_text(std::string text);
+
+  /**
+  \brief Replaces a range of the document and updates the translation.
+  \param[in] offset Offset of the replaced range in bytes.
+  \param[in] length Length of the replaced range; cut at the end of the
+  document.
+  \param[in] replacement The new text of the range.
+  \returns The output.
+
+  Throws std::out_of_range if offset is past the end of the document. Errors
+  are reported like in set_text; the edit is applied to the document anyway,
+  so a following edit may fix it.
+  */
+  const std::string &edit(size_t offset, size_t length,
+                          std::string_view replacement);
+
+  /**
+  \brief Returns the document.
+  */
+  const std::string &text() const { return text_; }
+
+  /**
+  \brief Returns the output of the last valid document.
+  */
+  const std::string &output() const {
+    return passManager_.any_enabled() ? result_ : generated_;
+  }
+
+  /**
+  \brief Returns the passes rewriting the output, all enabled by default.
+  Changes apply from the next translation.
+  */
+  reon::PassManager &passes() { return passManager_; }
+
+  /**
+  \brief Returns false if the last translation failed.
+  */
+  bool valid() const { return valid_; }
+
+  /**
+  \brief Returns the number of bytes of the document lexed and parsed by the
+  last edit.
+  */
+  size_t reparsed() const { return reparsed_; }
+
+  using ReonTranslation::lexer;
+
+ protected:
+  /**
+  \brief Output symbol owning its attribute.
+  */
+  struct Symbol {
+    OutputId id;
+    std::string attribute;
+  };
+
+  /**
+  \brief A value of the document, derived from REFULL.
+
+  Values are stored in pre-order, so the descendants of a value follow it and
+  the values are ordered by their beginnings.
+  */
+  struct Value {
+    /**
+    \brief Range of the value in the document.
+    */
+    size_t begin;
+    size_t end;
+    /**
+    \brief Range of the output symbols of the value.
+    */
+    size_t symbolBegin;
+    size_t symbolEnd;
+    /**
+    \brief Index of the enclosing value, noValue for the outermost one.
+    */
+    uint32_t parent;
+    /**
+    \brief Set if the value is output within a lookbehind assertion.
+    */
+    bool inLookbehind;
+    /**
+    \brief Output node of the value while parsing and the node after it.
+    */
+    uint32_t node;
+    uint32_t after;
+  };
+
+  static constexpr uint32_t noValue = UINT32_MAX;
+  /**
+  \brief Id of the LL stack entries that end the value in their node field.
+  */
+  static constexpr uint8_t valueEnd =
+      static_cast<uint8_t>(NonterminalId::COUNT);
+
+  std::string text_;
+  /**
+  \brief Output of the symbols without passes, which edits update, and the
+  output after the passes.
+  */
+  std::string generated_;
+  std::string result_;
+  reon::PassManager passManager_;
+  bool valid_ = false;
+  size_t reparsed_ = 0;
+
+  vector<Symbol> symbols_;
+  vector<Value> values_;
+  /**
+  \brief Offset of the output of each symbol and the size of the output.
+  */
+  vector<size_t> offsets_;
+
+  /**
+  \brief Results of the last parse, which may be a single value.
+  */
+  vector<Symbol> parsedSymbols_;
+  vector<Value> parsedValues_;
+  /**
+  \brief Output of the parsed symbols and their offsets; reused buffers.
+  */
+  std::string fragment_;
+  vector<size_t> fragmentOffsets_;
+  /**
+  \brief Views of symbols passed to the output generator.
+  */
+  vector<ReonSymbol> views_;
+  /**
+  \brief Index of the first symbol output at or after each output node and
+  the number of open lookbehind assertions before it.
+  */
+  vector<uint32_t> nodeSymbols_;
+  vector<uint32_t> nodeChecks_;
+
+  /**
+  \brief Translates all of text_.
+  */
+  void rebuild();
+
+  /**
+  \brief Parses the input of the lexical analyzer from a nonterminal to
+  parsedSymbols_ and parsedValues_.
+  \param[in] start Start nonterminal.
+  \param[in] base Offset of the input of the lexical analyzer in text_.
+  */
+  void parse_input(NonterminalId start, size_t base);
+
+  /**
+  \brief Translates the value enclosing an edit again and splices it.
+  \param[in] begin Start of the edit.
+  \param[in] end End of the replaced range before the edit.
+  \param[in] delta Change of the length of the document.
+  \returns False if the whole document has to be translated again.
+  */
+  bool update(size_t begin, size_t end, std::ptrdiff_t delta);
+
+  /**
+  \brief Runs the passes over all symbols and outputs them to result_.
+  */
+  void rewrite();
+
+  /**
+  \brief Outputs symbols to the output with the offsets of each symbol.
+  */
+  void output_range(const vector<Symbol> &symbols, size_t first, size_t last,
+                    std::string &output, vector<size_t> &offsets);
+
+  /**
+  \brief Returns true if the output of symbols depends on the output of the
+  symbols around them through the semantic checks.
+  */
+  static bool checked(const vector<Symbol> &symbols, size_t first,
+                      size_t last);
+};
+
+}  // namespace reon
+
+#endif
+/*** End of file reon_incremental.h ***/
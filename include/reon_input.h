@@ -0,0 +1,85 @@
+/**
+\file reon_input.h
+\brief Declares contiguous input buffers for reon lexical analysis.
+\author Radek Vít
+*/
+#ifndef REON_INPUT
+#define REON_INPUT
+
+#include <cstddef>
+#include <istream>
+#include <string>
+
+/**
+\brief Contiguous read-only view of the whole input.
+
+Regular files are memory mapped and read in place. Streams, pipes and other
+files that cannot be mapped are read in chunks into a single owned buffer.
+*/
+class InputBuffer {
+ public:
+  InputBuffer() = default;
+  InputBuffer(const InputBuffer &) = delete;
+  InputBuffer &operator=(const InputBuffer &) = delete;
+  ~InputBuffer() { release(); }
+
+  /**
+  \brief Maps or reads a file.
+  \param[in] path Path to the file.
+
+  Throws std::invalid_argument if the file cannot be opened.
+  */
+  void open_file(const std::string &path);
+
+  /**
+  \brief Reads the whole stream.
+  \param[in] is Input stream.
+  */
+  void read_stream(std::istream &is);
+
+  /**
+  \brief Sets the contents to a buffer owned by the caller.
+  \param[in] data First character of the input.
+  \param[in] size Number of characters.
+  */
+  void set_view(const char *data, size_t size);
+
+  /**
+  \brief Releases the current contents.
+  */
+  void release();
+
+  const char *data() const { return data_; }
+  size_t size() const { return size_; }
+
+  /**
+  \brief Returns true if the contents are memory mapped.
+  */
+  bool mapped() const { return mapping_ != nullptr; }
+
+ protected:
+  /**
+  \brief Size of a single read from a stream or a file descriptor.
+  */
+  static constexpr size_t chunkSize = 1 << 16;
+
+  const char *data_ = "";
+  size_t size_ = 0;
+  /**
+  \brief Mapped memory, nullptr if not mapped.
+  */
+  void *mapping_ = nullptr;
+  size_t mappingSize_ = 0;
+  /**
+  \brief Storage for inputs that are not mapped.
+  */
+  std::string storage_;
+
+  /**
+  \brief Points the view to storage_ and trims excess capacity.
+  */
+  void use_storage();
+};
+
+#endif
+/*** End of file reon_input.h ***/
@@ -0,0 +1,55 @@
+/**
+\file reon_length.h
+\brief Declares the analysis of the length of matches of reon patterns.
+\author Radek Vít
+*/
+#ifndef REON_LENGTH
+#define REON_LENGTH
+
+#include <reon_ast.h>
+#include <cstdint>
+#include <vector>
+
+namespace reon {
+
+/**
+\brief Bounds of the length of the matches of a pattern in characters.
+*/
+struct MatchLength {
+  uint64_t min = 0;
+  /**
+  \brief Longest match, unused if unbounded.
+  */
+  uint64_t max = 0;
+  bool unbounded = false;
+};
+
+/**
+\brief Largest length told apart by the analysis. Longer minimums saturate to
+it and longer maximums are unbounded.
+*/
+constexpr uint64_t maxMatchLength = UINT32_MAX;
+
+/**
+\brief Computes the bounds of the length of matches of an AST.
+
+Assertions and comments match no characters, and escapes other than
+assertions match one. Group references may match anything, so a pattern
+with a reference is unbounded. A pattern that never matches has the bounds
+0 and 0.
+*/
+MatchLength match_length(const Ast &ast);
+
+/**
+\brief Computes the bounds of the length of matches of a translation.
+\param[in] symbols Output symbols of the translation.
+\param[out] ast Receives the AST of the symbols; reused between calls.
+
+Patterns nested too deep for an AST are unbounded.
+*/
+MatchLength match_length(const std::vector<ReonSymbol> &symbols, Ast &ast);
+
+}  // namespace reon
+
+#endif
+/*** End of file reon_length.h ***/
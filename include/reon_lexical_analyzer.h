@@ -6,35 +6,78 @@
 #ifndef REON_LEXICAL_ANALYZER
 #define REON_LEXICAL_ANALYZER
 
-#include <cctype>
+#include <reon_input.h>
+#include <reon_structural.h>
+#include <reon_translation_grammar.h>
+#include <algorithm>
+#include <cstring>
 #include <ctf.hpp>
-#include <iterator>
-#include <sstream>
+#include <deque>
+#include <functional>
 #include <string>
+#include <string_view>
+
+/**
+\brief Exception thrown on lexical errors.
+*/
+class LexicalError : public TranslationError {
+ public:
+  using TranslationError::TranslationError;
+  LexicalError(const string &message, size_t row, size_t col)
+      : TranslationError(message), row(row), col(col) {}
+
+  /**
+  \brief Row and column of the error, 0 if unknown.
+  */
+  size_t row = 0;
+  size_t col = 0;
+};
+
+/**
+\brief Token of reon.
+
+The attribute refers to the input of the lexical analyzer, or to a string owned
+by the lexical analyzer when an escape had to be rewritten. It stays valid until
+the next input is assigned.
+*/
+struct ReonToken {
+  reon::TerminalId id = reon::TerminalId::EOI;
+  std::string_view attribute{};
+};
 
 /**
 \brief Recursive descent lexical analyzer for reon. Callable class.
 
-Buffers all of the stream input. Resets on input stream change and on returning
-Symbol::eof().
+Reads directly from a memory mapped file or from a single buffer holding all of
+the stream input. Resets on input change.
+
+The input is indexed by StructuralIndex first. Tokens start at the indexed
+positions and strings end at the following one, so only numbers and literals
+are read character by character. Rows and columns are computed for error
+messages only.
 */
-class ReonLexer : public LexicalAnalyzer {
+class ReonLexer {
  public:
   using uint_type = size_t;
+  using Token = ReonToken;
+
  protected:
-  std::string errorString_;
   /**
-  \brief Stream that is read from.
+  \brief Contiguous input.
   */
-  std::istream *assignedStream_ = nullptr;
+  InputBuffer input_;
   /**
-  \brief Buffer containing all characters from the stream.
+  \brief All characters from the input.
   */
-  std::string buffer_;
+  const char *buffer_ = "";
   /**
-  \brief Attribute string.
+  \brief Attribute of a read string.
   */
-  std::string read_;
+  std::string_view read_;
+  /**
+  \brief Strings with rewritten escapes. Cleared on input change.
+  */
+  std::deque<std::string> unescaped_;
   /**
   \brief Currently read character.
   */
@@ -48,34 +91,44 @@ class ReonLexer : public LexicalAnalyzer {
   \brief Number of characters in buffer.
   */
   uint_type size_ = 0;
+  /**
+  \brief Position of the first character of the current token.
+  */
+  uint_type start_ = 0;
 
   /**
-  \brief Column of current read position.
+  \brief Token starts and closing quotes.
   */
-  uint_type col_ = 1;
+  StructuralIndex index_;
   /**
-  \brief Row of current read position.
+  \brief Next unused position of index_.
   */
-  uint_type row_ = 1;
+  size_t next_ = 0;
+  /**
+  \brief Position of the first character of the last token.
+  */
+  uint_type tokenStart_ = 0;
 
   /**
-  \brief Assigns a stream and fills the buffer from it.
-  \param[in] is Input stream for assignment.
+  \brief Starts reading the contents of input_.
 
-  Sets new buffer size, resets read position, col and row positions.
+  Sets new buffer size, resets read position and indexes the input.
   */
-  void fill_buffer(std::istream &is) {
-    std::stringstream buf;
-    buf << is.rdbuf();
-    buffer_ = buf.str();
-    size_ = buffer_.size();
+  void fill_buffer() {
+    unescaped_.clear();
+    buffer_ = input_.data();
+    size_ = input_.size();
     position_ = 0;
-    col_ = 1;
-    row_ = 1;
+    start_ = 0;
+    tokenStart_ = 0;
+    next_ = 0;
+    if (size_ > StructuralIndex::maxSize)
+      throw LexicalError("Inputs larger than 4 GiB are not supported.\n");
+    index_.build(buffer_, size_);
   }
 
   /**
-  \brief Reads the next character into c. Adjusts positions.
+  \brief Reads the next character into c. Adjusts position.
   \returns False if EOF is encountered, true otherwise.
   */
   bool read() {
@@ -83,78 +136,118 @@ class ReonLexer : public LexicalAnalyzer {
       return false;
 
     c = buffer_[position_++];
-    col_++;
-    if (c == '\n') {
-      col_ = 1;
-      row_++;
-    }
     return true;
   }
 
   /**
-  \brief Appends char to attribute string.
-  \param[in] a Character to append.
+  \brief Moves reading position back.
+  \param[in] i How many characters to roll back.
   */
-  void append(const char &a) { read_ += a; }
+  void roll_back(uint_type i) { position_ -= i; }
 
   /**
-  \brief Appends c to attribute string.
+  \brief Clears attribute string and c before reading new token.
   */
-  void append() { read_ += c; }
+  void clear() {
+    read_ = {};
+    c = '\0';
+  }
 
   /**
-  \brief Reads and appends character to attribute string.
-  \returns False if EOF is encountered. True otherwise.
+  \brief Returns the input from the start of the token to the read position.
   */
-  bool read_append() {
-    if (read()) {
-      append();
-      return true;
-    }
-    return false;
+  std::string_view span() const {
+    return std::string_view(buffer_ + start_, position_ - start_);
   }
 
   /**
-  \brief Moves reading position back.
-  \param[in] i How many characters to roll back.
+  \brief Returns current attribute string.
+  \returns Current attribute string.
   */
-  void roll_back(uint_type i) { position_ -= i; }
+  std::string_view &atr() { return read_; }
 
   /**
-  \brief Clears attribute string and c before reading new token.
+  \brief Creates a token.
   */
-  void clear() {
-    read_ = "";
-    c = '\0';
+  static Token token(reon::TerminalId id, std::string_view attribute = {}) {
+    return Token{id, attribute};
   }
 
   /**
-  \brief Returns current attribute string.
-  \returns Current attribute string.
+  \brief Returns the EOF token.
+  */
+  static Token eof() { return token(reon::TerminalId::EOI); }
+
+  /**
+  \brief Whitespace as defined by std::isspace in the C locale.
+  */
+  static bool is_space(char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+  }
+
+  /**
+  \brief Decimal digit.
   */
-  string &atr() { return read_; }
+  static bool is_digit(char c) { return c >= '0' && c <= '9'; }
 
   /**
-  \brief Resets analyzer. After assigning a stream, it acts as if it was just
-  constructed.
+  \brief Returns the row of an input position.
   */
-  void reset() { assignedStream_ = nullptr; }
+  uint_type row(uint_type position) const {
+    return 1 + std::count(buffer_, buffer_ + position, '\n');
+  }
 
   /**
-  \brief Returns Symbol::eof(), resets lexical analyzer.
-  \returns Symbol::eof().
+  \brief Returns the column of an input position.
   */
-  Symbol eof() {
-    reset();
-    return Symbol::eof();
+  uint_type col(uint_type position) const {
+    uint_type lineStart = position;
+    while (lineStart > 0 && buffer_[lineStart - 1] != '\n')
+      --lineStart;
+    return position - lineStart + 1;
   }
 
   /**
   \brief Throws exception with given message and adds row and col information.
+  \param[in] msg Error message.
+  \param[in] position Position of the error.
+  */
+  [[noreturn]] void throw_exception(const string &msg, uint_type position) {
+    uint_type r = row(position);
+    uint_type c = col(position);
+    throw LexicalError("Lexical error on row " + std::to_string(r) + ", col " +
+                           std::to_string(c) + ": " + msg + "\n",
+                       r, c);
+  }
+
+  /**
+  \brief Throws exception with given message, positioned at the last read
+  character.
   */
-  void throw_exception(const string &msg) {
-    throw TranslationError("Lexical error on row " + std::to_string(row_) +
-                           ", col " + std::to_string(col_) + ": " + msg);
+  [[noreturn]] void throw_exception(const string &msg) {
+    throw_exception(msg, position_ > 0 ? position_ - 1 : 0);
+  }
+
+  /**
+  \brief Moves the read position to the start of the next token.
+  \returns False if there are no more tokens.
+  */
+  bool next_token_start() {
+    const auto &positions = index_.positions();
+    while (next_ < positions.size() && positions[next_] < position_)
+      ++next_;
+    if (position_ < size_ && !is_space(buffer_[position_])) {
+      // directly following a number or a literal, may not be indexed
+      if (next_ < positions.size() && positions[next_] == position_)
+        ++next_;
+      return true;
+    }
+    if (next_ == positions.size()) {
+      position_ = size_;
+      return false;
+    }
+    position_ = positions[next_++];
+    return true;
   }
 
   /**
@@ -169,26 +262,31 @@ class ReonLexer : public LexicalAnalyzer {
   */
   Token state_init() {
     clear();
-    do {
-      if (!read())
-        return eof();
-    } while (std::isspace(c));
+    if (!next_token_start()) {
+      tokenStart_ = size_;
+      return eof();
+    }
+    start_ = tokenStart_ = position_;
+    c = buffer_[position_++];
     /* : is hadled after string because of special identifiers */
     switch (c) {
       case '[':
+        return token(reon::TerminalId::LBRACKET);
       case ']':
+        return token(reon::TerminalId::RBRACKET);
       case '{':
+        return token(reon::TerminalId::LBRACE);
       case '}':
+        return token(reon::TerminalId::RBRACE);
       case ',':
+        return token(reon::TerminalId::COMMA);
       case ':':
-        return Terminal(s(c));
+        return token(reon::TerminalId::COLON);
       case '"':
         return state_string();
       case '-':
-        append();
         return state_number_minus();
       case '0':
-        append();
         return state_number_zero();
       case 't':
         return state_true();
@@ -197,60 +295,62 @@ class ReonLexer : public LexicalAnalyzer {
       case 'n':
         return state_null();
       default:
-        if (std::isdigit(c)) {
-          append();
+        if (is_digit(c)) {
           return state_number();
         }
     }  // switch
     throw_exception("No token beginning with " + s(c) + ".");
-    // to shut compiler up
-    return Symbol::eof();
   }
 
   /**
   \brief Reading string contents. Resolves escapes.
+
+  The string ends at the next indexed position. The attribute refers to the
+  input unless an escaped '"' has to be rewritten.
   \returns Token string or one of the keyword tokens.
   */
   Token state_string() {
-    while (1) {
-      if (!read())
-        throw_exception("Unexpected EOF when reading a REON string.");
-      if (c <= 0x1F)
-        throw_exception("Control characters are forbidden in a REON string.");
-      switch (c) {
-        case '"':
-          // may return keywords if there is a : after
-          return state_string_end();
-        case '\\': {
-          if (!read())
-            throw_exception("Unexpected EOF when reading a REON string.");
-          switch (c) {
-            /* Allow all characters to be escaped
-            case '"':
-            case '\\':
-            case '/':
-            case 'b':
-            case 'n':
-            case 'r':
-            case 't':
-              append('\\');
-              append();
-              break;
-            */
-            case '"':
-              append(c);
-              break;
-            default:
-              append('\\');
-              append();
-          }  // switch
-          break;
-        }  // case escape
-        default:
-          append();
-          break;
+    const auto &positions = index_.positions();
+    uint_type begin = position_;
+    uint_type end = next_ < positions.size() ? positions[next_] : size_;
+    if (index_.first_control() < end)
+      throw_exception("Control characters are forbidden in a REON string.",
+                      index_.first_control());
+    if (end == size_) {
+      position_ = size_;
+      throw_exception("Unexpected EOF when reading a REON string.");
+    }
+    ++next_;
+    position_ = end + 1;
+
+    std::string_view content(buffer_ + begin, end - begin);
+    // all characters may be escaped, only \" is rewritten
+    std::string *unescaped = nullptr;
+    size_t copied = 0;
+    size_t i = 0;
+    while (const void *found =
+               std::memchr(content.data() + i, '\\', content.size() - i)) {
+      // an escaped character always follows, the closing quote is not escaped
+      i = static_cast<const char *>(found) - content.data();
+      if (content[i + 1] == '"') {
+        if (!unescaped) {
+          unescaped_.emplace_back();
+          unescaped = &unescaped_.back();
+        }
+        unescaped->append(content.data() + copied, i - copied);
+        unescaped->push_back('"');
+        copied = i + 2;
       }
-    }  // while 1
+      i += 2;
+    }
+    if (unescaped) {
+      unescaped->append(content.data() + copied, content.size() - copied);
+      read_ = *unescaped;
+    } else {
+      read_ = content;
+    }
+    // may return keywords if there is a : after
+    return state_string_end();
   }
 
   /**
@@ -259,20 +359,11 @@ class ReonLexer : public LexicalAnalyzer {
   \returns Token string or keyword token.
   */
   Token state_string_end() {
-    do {
-      if (!read())
-        return Terminal("string", atr());
-    } while (std::isspace(c));
-
-    // only checking following character, next token begins with it
-    roll_back(1);
-
-    switch (c) {
-      case ':':
-        return check_keywords();
-      default:
-        return Terminal("string", {atr()});
-    }
+    // the next indexed position is the next character other than whitespace
+    const auto &positions = index_.positions();
+    if (next_ < positions.size() && buffer_[positions[next_]] == ':')
+      return check_keywords();
+    return token(reon::TerminalId::STRING, atr());
   }
 
   /**
@@ -280,19 +371,17 @@ class ReonLexer : public LexicalAnalyzer {
   \returns Token number.
   */
   Token state_number_minus() {
-    if (!read_append())
+    if (!read())
       throw_exception("Unexpected EOF when reading a number.");
     switch (c) {
       case '0':
         return state_number_zero();
       default:
-        if (std::isdigit(c)) {
+        if (is_digit(c)) {
           return state_number();
         }
     }
     throw_exception("Unexpected " + s(c) + " when reading a number.");
-    // to shut compiler up
-    return Symbol::eof();
   }
 
   /**
@@ -301,14 +390,13 @@ class ReonLexer : public LexicalAnalyzer {
   */
   Token state_number_zero() {
     if (!read())
-      return Terminal("number", atr());
+      return token(reon::TerminalId::NUMBER, span());
     switch (c) {
       case '.':
-        append();
         return state_number_dec();
       default:
         roll_back(1);
-        return Terminal("number", atr());
+        return token(reon::TerminalId::NUMBER, span());
     }
   }
 
@@ -319,21 +407,17 @@ class ReonLexer : public LexicalAnalyzer {
   Token state_number() {
     while (1) {
       if (!read())
-        return Terminal("number", atr());
+        return token(reon::TerminalId::NUMBER, span());
       switch (c) {
         case '.':
-          append();
           return state_number_dec();
         case 'e':
         case 'E':
-          append();
           return state_number_e();
         default:
-          if (!std::isdigit(c)) {
+          if (!is_digit(c)) {
             roll_back(1);
-            return Terminal("number", atr());
-          } else {
-            append();
+            return token(reon::TerminalId::NUMBER, span());
           }
       }  // switch
     }    // while 1
@@ -346,24 +430,21 @@ class ReonLexer : public LexicalAnalyzer {
   Token state_number_dec() {
     if (!read())
       throw_exception("Unexpected EOF after decimal dot when reading number.");
-    if (!std::isdigit(c))
+    if (!is_digit(c))
       throw_exception("Unexpected " + s(c) +
                       " after decimal dot when reading number.");
-    append();
     while (1) {
       if (!read())
-        return Terminal("number", atr());
+        return token(reon::TerminalId::NUMBER, span());
       switch (c) {
         case 'e':
         case 'E':
-          append();
           return state_number_e();
         default:
-          if (!std::isdigit(c)) {
+          if (!is_digit(c)) {
             roll_back(1);
-            return Terminal("number", atr());
+            return token(reon::TerminalId::NUMBER, span());
           }
-          append();
       }  // switch
     }    // while 1
   }
@@ -373,18 +454,17 @@ class ReonLexer : public LexicalAnalyzer {
   \returns Token number.
   */
   Token state_number_e() {
-    if (!read_append())
+    if (!read())
       throw_exception("Unexpected EOF after e when reading number.");
-    if (c != '+' && c != '-' && !std::isdigit(c))
+    if (c != '+' && c != '-' && !is_digit(c))
       throw_exception("Unexpected " + s(c) + " after e when reading number.");
     while (1) {
       if (!read())
-        return Terminal("number", atr());
-      if (!std::isdigit(c)) {
+        return token(reon::TerminalId::NUMBER, span());
+      if (!is_digit(c)) {
         roll_back(1);
-        return Terminal("number", atr());
+        return token(reon::TerminalId::NUMBER, span());
       }  // if
-      append();
     }  // while 1
   }
 
@@ -401,7 +481,7 @@ class ReonLexer : public LexicalAnalyzer {
         throw_exception("Unexpected " + s(c) + " when reading 'true'.");
       }
     }
-    return Terminal("true");
+    return token(reon::TerminalId::TRUE_LITERAL);
   }
 
   /**
@@ -417,7 +497,7 @@ class ReonLexer : public LexicalAnalyzer {
         throw_exception("Unexpected " + s(c) + " when reading 'false'.");
       }
     }
-    return Terminal("false");
+    return token(reon::TerminalId::FALSE_LITERAL);
   }
 
   /**
@@ -433,77 +513,118 @@ class ReonLexer : public LexicalAnalyzer {
         throw_exception("Unexpected " + s(c) + " when reading 'null'.");
       }
     }
-    return Terminal("null");
+    return token(reon::TerminalId::NULL_LITERAL);
+  }
+
+  /**
+  \brief Checks whether a string starts with a prefix.
+  */
+  static bool starts_with(std::string_view a, std::string_view prefix) {
+    return a.size() >= prefix.size() && !a.compare(0, prefix.size(), prefix);
   }
 
   /**
   \brief Checking for keywords in string.
+
+  Dispatches on the first character, so each string is compared to at most
+  three keywords.
   \returns Token string or one of the keyword tokens.
   */
-  Token check_keywords() {  // TODO: all keywords
-    auto &a = atr();
-    // repetition operators
-    if (!a.compare(0, 7, "repeat ", 0, 7)) {
-      a.erase(0, 7);
-      return keyword_repeat("repeat");
-    }
-    if (!a.compare(0, 18, "non-greedy repeat ", 0, 18)) {
-      a.erase(0, 18);
-      return keyword_repeat("non-greedy repeat");
-    }
-    if (a == "set")
-      return Terminal("set");
-    if (a == "!set" || a == "negated set")
-      return Terminal("!set");
-    if (a == "alternatives")
-      return Terminal("alternatives");
-    if (a == "group")
-      return Terminal("group");
-    if (!a.compare(0, 6, "group ", 0, 6)) {
-      a.erase(0, 6);
-      return Terminal("named group", a);
+  Token check_keywords() {
+    using reon::TerminalId;
+    std::string_view a = atr();
+    if (a.empty())
+      return token(TerminalId::STRING, a);
+    switch (a[0]) {
+      case 'r':
+        // repetition operators
+        if (starts_with(a, "repeat "))
+          return keyword_repeat(TerminalId::REPEAT, a.substr(7));
+        break;
+      case 'n':
+        if (starts_with(a, "non-greedy repeat "))
+          return keyword_repeat(TerminalId::NG_REPEAT, a.substr(18));
+        if (a == "negated set")
+          return token(TerminalId::NSET);
+        if (a == "negative lookahead")
+          return token(TerminalId::NLOOKAHEAD);
+        if (a == "negative lookbehind")
+          return token(TerminalId::NLOOKBEHIND);
+        break;
+      case 's':
+        if (a == "set")
+          return token(TerminalId::SET);
+        break;
+      case '!':
+        if (a == "!set")
+          return token(TerminalId::NSET);
+        if (a == "!lookahead")
+          return token(TerminalId::NLOOKAHEAD);
+        if (a == "!lookbehind")
+          return token(TerminalId::NLOOKBEHIND);
+        break;
+      case 'a':
+        if (a == "alternatives")
+          return token(TerminalId::ALTERNATIVES);
+        break;
+      case 'g':
+        if (a == "group")
+          return token(TerminalId::GROUP);
+        if (starts_with(a, "group "))
+          return token(TerminalId::NAMED_GROUP, a.substr(6));
+        break;
+      case 'm':
+        if (a == "match group")
+          return token(TerminalId::MATCH_GROUP);
+        break;
+      case 'c':
+        if (a == "comment")
+          return token(TerminalId::COMMENT);
+        break;
+      case 'l':
+        if (a == "lookahead")
+          return token(TerminalId::LOOKAHEAD);
+        if (a == "lookbehind")
+          return token(TerminalId::LOOKBEHIND);
+        break;
+      case 'i':
+        if (a == "if")
+          return token(TerminalId::IF);
+        break;
+      case 't':
+        if (a == "then")
+          return token(TerminalId::THEN);
+        break;
+      case 'e':
+        if (a == "else")
+          return token(TerminalId::ELSE);
+        break;
+      default:
+        break;
     }
-    if (a == "match group")
-      return Terminal("match group");
-    if (a == "comment")
-      return Terminal("comment");
-    if (a == "lookahead")
-      return Terminal("lookahead");
-    if (a == "!lookahead" || a == "negative lookahead")
-      return Terminal("!lookahead");
-    if (a == "lookbehind")
-      return Terminal("lookbehind");
-    if (a == "!lookbehind" || a == "negative lookbehind")
-      return Terminal("!lookbehind");
-    if (a == "if")
-      return Terminal("if");
-    if (a == "then")
-      return Terminal("then");
-    if (a == "else")
-      return Terminal("else");
     // no match
-    return Terminal("string", a);
+    return token(TerminalId::STRING, a);
   }
 
   /**
   \brief Reads repeats in keyword 'repeat'.
+  \param[in] id REPEAT or NG_REPEAT.
+  \param[in] a Attribute following the keyword.
   \returns Token repeat, ngrepeat or string.
   */
-  Token keyword_repeat(const string &token) {
+  Token keyword_repeat(reon::TerminalId id, std::string_view a) {
     // checks attribute
     enum class State { INIT, FIRST, SECOND, INVALID } state = State::INIT;
-    auto &a = atr();
     if (a.length() == 0)
-      return Terminal("string", token + " " + a);
+      return token(reon::TerminalId::STRING, atr());
     if (a == "*" || a == "+" || a == "?")
-      return Terminal(token, a);
-    char c = a[0];
-    for (uint_type i = 0; i < a.size(); ++i, c = a[i]) {
+      return token(id, a);
+    for (char c : a) {
       switch (state) {
         case State::INIT:
           if (c == '-') {
             state = State::SECOND;
-          } else if (!std::isdigit(c)) {
+          } else if (!is_digit(c)) {
             state = State::INVALID;
             break;
           }
@@ -514,41 +635,90 @@ class ReonLexer : public LexicalAnalyzer {
             state = State::SECOND;
             break;
           }
+          [[fallthrough]];
         case State::SECOND:
-          if (!std::isdigit(c)) {
+          if (!is_digit(c)) {
             state = State::INVALID;
             break;
           }
+          [[fallthrough]];
         case State::INVALID:
           break;
       }  // switch
     }    // for
     if (state == State::INVALID)
-      return Terminal("string", token + " " + a);
-    if (token == "non-greedy repeat" && state == State::FIRST)
-      return Terminal("repeat", a);
-    return Terminal(token, a);
+      return token(reon::TerminalId::STRING, atr());
+    if (id == reon::TerminalId::NG_REPEAT && state == State::FIRST)
+      return token(reon::TerminalId::REPEAT, a);
+    return token(id, a);
   }
 
  public:
-  virtual void set_stream(std::istream &s, const string &) noexcept {
-    LexicalAnalyzer::set_stream(s);
-    fill_buffer(s);
+  /**
+  \brief Reads all of the stream.
+  \param[in] s Input stream.
+  */
+  void set_stream(std::istream &s) {
+    input_.read_stream(s);
+    fill_buffer();
   }
-  virtual string error_message() { return errorString_; }
   /**
-  \brief Sets stream if changed and gets a token.
+  \brief Reads from a file. Regular files are memory mapped.
+  \param[in] path Path to the file.
   */
-  Token get_token() {
-    try {
-      return state_init();
-    } catch (TranslationError &te) {
-      errorFlag_ = true;
-      errorString_ += string{te.what()} + "\n";
-      return Symbol::eof();
-    }
+  void set_file(const string &path) {
+    input_.open_file(path);
+    fill_buffer();
+  }
+  /**
+  \brief Reads from a string owned by the caller.
+  \param[in] input The input; must outlive the tokens.
+  */
+  void set_string(std::string_view input) {
+    input_.set_view(input.data(), input.size());
+    fill_buffer();
   }
+  /**
+  \brief Returns the row of the last token.
+  */
+  uint_type token_row() const { return row(tokenStart_); }
+  /**
+  \brief Returns the column of the last token.
+  */
+  uint_type token_col() const { return col(tokenStart_); }
+  /**
+  \brief Returns the offset of the first character of the last token.
+  */
+  uint_type token_start() const { return tokenStart_; }
+  /**
+  \brief Returns the offset past the last token.
+  */
+  uint_type token_end() const { return position_; }
+  /**
+  \brief Returns the size of the input in bytes.
+  */
+  uint_type input_size() const { return size_; }
+  /**
+  \brief Finds the row and the column of an attribute read from the input.
+  \returns False if the attribute does not refer to the input, e.g. strings
+  with rewritten escapes.
+  */
+  bool locate(std::string_view attribute, uint_type &r, uint_type &c) const {
+    // unrelated pointers are ordered by std::less only
+    std::less<const char *> less;
+    if (less(attribute.data(), buffer_) ||
+        !less(attribute.data(), buffer_ + size_))
+      return false;
+    uint_type position = attribute.data() - buffer_;
+    r = row(position);
+    c = col(position);
+    return true;
+  }
+  /**
+  \brief Gets the next token. Throws LexicalError on errors.
+  */
+  Token get_token() { return state_init(); }
 };
 
 #endif
-/*** End of file reon_lexical_analyzer.h ***/
\ No newline at end of file
+/*** End of file reon_lexical_analyzer.h ***/
@@ -0,0 +1,184 @@
+/**
+\file reon_output_buffer.h
+\brief Declares the buffered output sink for reon output generation.
+\author Radek Vít
+*/
+#ifndef REON_OUTPUT_BUFFER
+#define REON_OUTPUT_BUFFER
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+/**
+\brief Classification of characters for escaping.
+*/
+enum class EscapeClass : uint8_t {
+  /**
+  \brief Copied as is.
+  */
+  COPY,
+  /**
+  \brief Output with a preceding backslash.
+  */
+  ESCAPE,
+  /**
+  \brief Needs context; escaping stops before this character.
+  */
+  STOP
+};
+
+/**
+\brief 256-entry escape classification table.
+
+Characters that are not copied are also listed in stops, so that runs of
+copied characters can be found with vector compares.
+*/
+struct EscapeTable {
+  /**
+  \brief Maximal number of characters that are not copied.
+  */
+  static constexpr size_t maxStops = 16;
+
+  EscapeClass classes[256] = {};
+  char stops[maxStops] = {};
+  uint8_t stopCount = 0;
+
+  constexpr EscapeClass operator[](char c) const {
+    return classes[static_cast<unsigned char>(c)];
+  }
+};
+
+/**
+\brief Creates an escape table.
+\param[in] escaped Characters output with a preceding backslash.
+\param[in] stop Characters the caller handles.
+*/
+constexpr EscapeTable make_escape_table(std::string_view escaped,
+                                        std::string_view stop) {
+  EscapeTable table{};
+  for (char c : escaped) {
+    table.classes[static_cast<unsigned char>(c)] = EscapeClass::ESCAPE;
+    table.stops[table.stopCount++] = c;
+  }
+  for (char c : stop) {
+    table.classes[static_cast<unsigned char>(c)] = EscapeClass::STOP;
+    table.stops[table.stopCount++] = c;
+  }
+  return table;
+}
+
+/**
+\brief Contiguous growable output buffer. Writes to a stream in large blocks,
+or appends to a string owned by the caller.
+*/
+class OutputBuffer {
+ public:
+  OutputBuffer() { buffer_.reserve(blockSize); }
+  OutputBuffer(const OutputBuffer &) = delete;
+  OutputBuffer &operator=(const OutputBuffer &) = delete;
+  ~OutputBuffer() = default;
+
+  /**
+  \brief Sets the output stream. Flushes the previous one.
+  */
+  void set_stream(std::ostream &os) {
+    flush();
+    os_ = &os;
+    string_ = nullptr;
+  }
+
+  /**
+  \brief Sets the output string. Flushes the previous output.
+  \param[out] s String the output is appended to; must outlive the use of the
+  buffer.
+  */
+  void set_string(std::string &s) {
+    flush();
+    os_ = nullptr;
+    string_ = &s;
+  }
+
+  /**
+  \brief Writes the buffered contents to the output.
+  */
+  void flush();
+
+  /**
+  \brief Appends a single character.
+  */
+  void put(char c) {
+    buffer_.push_back(c);
+    if (buffer_.size() >= blockSize)
+      flush();
+  }
+
+  /**
+  \brief Appends a string.
+  */
+  void write(std::string_view s) {
+    if (buffer_.size() + s.size() > blockSize) {
+      flush();
+      if (s.size() >= blockSize) {
+        sink(s);
+        return;
+      }
+    }
+    buffer_.append(s.data(), s.size());
+  }
+
+  /**
+  \brief Appends a string, escaping characters according to table.
+  \param[in] s String to append.
+  \param[in] table Escape table.
+  \returns Position of the first STOP character, or s.size().
+  */
+  size_t write_escaped(std::string_view s, const EscapeTable &table);
+
+  /**
+  \brief Finds the first character that is not copied as is.
+  \returns Position of the first such character, or s.size().
+  */
+  static size_t find_stop(std::string_view s, const EscapeTable &table);
+
+  /**
+  \brief Returns the number of bytes passed to the outputs so far.
+  */
+  size_t written() const { return written_; }
+
+  /**
+  \brief Returns the number of bytes appended so far, including the buffered
+  ones.
+  */
+  size_t position() const { return written_ + buffer_.size(); }
+
+ protected:
+  /**
+  \brief Size of a single write to the stream.
+  */
+  static constexpr size_t blockSize = 1 << 16;
+
+  std::ostream *os_ = nullptr;
+  /**
+  \brief Output string, nullptr when writing to os_.
+  */
+  std::string *string_ = nullptr;
+  std::string buffer_;
+  size_t written_ = 0;
+
+  /**
+  \brief Passes a block to the output.
+  */
+  void sink(std::string_view s) {
+    written_ += s.size();
+    if (string_)
+      string_->append(s.data(), s.size());
+    else if (os_)
+      os_->write(s.data(), s.size());
+  }
+};
+
+#endif
+/*** End of file reon_output_buffer.h ***/
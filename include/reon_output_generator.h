@@ -6,16 +6,18 @@
 #ifndef REON_OUTPUT_GENERATOR
 #define REON_OUTPUT_GENERATOR
 
+#include <reon_output_buffer.h>
+#include <reon_translation_grammar.h>
 #include <ctf.hpp>
 
+#include <algorithm>
 #include <cctype>
-#include <cstdlib>
-#include <map>
+#include <cstdint>
+#include <ostream>
 #include <set>
-
-namespace globals {
-extern string varname;
-}
+#include <string>
+#include <string_view>
+#include <vector>
 
 /*
 Output terminals with special meaning:
@@ -31,78 +33,122 @@ Output special symbols:
   group       -   group definition for semantic analysis
   fixed_length_check  -   checks lookbehind length
   end_check   -   pops one check
-  variable    -   Python variable with name set in namespace global
+  variable    -   Python variable with the name set in the output generator
+*/
+
+/**
+\brief Output symbol of reonGrammar.
+
+The attribute refers to the input or to a token attribute owned by the lexical
+analyzer.
 */
+struct ReonSymbol {
+  reon::OutputId id;
+  std::string_view attribute{};
+};
 
 /**
 \brief Callable class for reon output generation and semantic checks.
 */
-class ReonOutput: public OutputGenerator {
+class ReonOutput {
  public:
   using uint_type = size_t;
 
+  /**
+  \brief Syntax of the generated regular expression.
+  */
+  enum class Target : uint8_t {
+    /**
+    \brief Python 3 re pattern assigned to a variable.
+    */
+    PYTHON,
+    /**
+    \brief RE2 pattern on its own line. Constructs that cannot be matched in
+    linear time are rejected.
+    */
+    RE2
+  };
+
+  /**
+  \param[in] target Syntax of the generated regular expression.
+  \param[in] variable Name of the Python variable the pattern is assigned to.
+  */
+  explicit ReonOutput(Target target = Target::PYTHON,
+                      std::string variable = "re")
+      : target_(target), variable_(std::move(variable)) {}
+
  protected:
-  string errorString_;
+  Target target_;
+  /**
+  \brief Name of the assigned Python variable.
+  */
+  std::string variable_;
+  /**
+  \brief Buffered output.
+  */
+  OutputBuffer out_;
   /**
   \brief Set of known group names.
   */
-  std::set<string> knownGroups_{};
+  std::set<string, std::less<>> knownGroups_{};
   /**
   \brief Ammount of groups defined thus far.
   */
   uint_type numberGroups_ = 0;
+  /**
+  \brief Set inside a comment, which RE2 does not support; the comment is
+  left out.
+  */
+  bool inComment_ = false;
 
   /**
-  \brief Vector of semantic checks callbacks.
-  */
-  vector<std::function<void(const Symbol &)>> semanticChecks_{};
-
-  /**
-  \brief Object binding in symbolMap_
-   */
-  const ReonOutput *cbinding_ = nullptr;
-
-  /**
-  \brief Substitute for a string switch statement for invoking methods
-  appropriate for incoming symbols.
-  */
-  std::map<Symbol, std::function<void(std::ostream &, const Symbol &)>>
-      symbolMap_;
-
-  /**
-  \brief Binds callbacks to this object.
-  */
-  void bind_callbacks() {
-    cbinding_ = this;
-    symbolMap_ = std::map<Symbol,
-                          std::function<void(std::ostream &, const Symbol &)>>{
-        {"re"_t, std::bind(&ReonOutput::re, this, std::placeholders::_1,
-                           std::placeholders::_2)},
-        {"set"_t, std::bind(&ReonOutput::set, this, std::placeholders::_1,
-                            std::placeholders::_2)},
-        {"ref"_t, std::bind(&ReonOutput::ref, this, std::placeholders::_1,
-                            std::placeholders::_2)},
-        {"nref"_t, std::bind(&ReonOutput::nref, this, std::placeholders::_1,
-                             std::placeholders::_2)},
-        {"comment"_t, std::bind(&ReonOutput::comment, this,
-                                std::placeholders::_1, std::placeholders::_2)},
-        {"repeat"_t, std::bind(&ReonOutput::repeat, this, std::placeholders::_1,
-                               std::placeholders::_2)},
-        {"named group"_t,
-         std::bind(&ReonOutput::named_group, this, std::placeholders::_1,
-                   std::placeholders::_2)},
-        {"group"_s, std::bind(&ReonOutput::group, this, std::placeholders::_1,
-                              std::placeholders::_2)},
-        {"fixed_length_check"_s,
-         std::bind(&ReonOutput::add_fixed_length_check, this,
-                   std::placeholders::_1, std::placeholders::_2)},
-        {"end_check"_s,
-         std::bind(&ReonOutput::end_check, this, std::placeholders::_1,
-                   std::placeholders::_2)},
-        {"variable"_s, std::bind(&ReonOutput::variable, this,
-                                 std::placeholders::_1, std::placeholders::_2)},
-    };
-  }
+  \brief Width of a group output within a lookbehind assertion, in
+  characters.
+  */
+  struct Width {
+    /**
+    \brief Width of the alternatives before the current one, noWidth before
+    the first '|'.
+    */
+    uint64_t alternatives = noWidth;
+    /**
+    \brief Width of the current alternative so far.
+    */
+    uint64_t current = 0;
+    /**
+    \brief Width of the last atom, multiplied by a following repeat.
+    */
+    uint64_t last = 0;
+    /**
+    \brief Set for lookaround assertions, which have no width.
+    */
+    bool zero = false;
+    /**
+    \brief Reason why the width is not fixed, nullptr if it is.
+    */
+    const char *variable = nullptr;
+  };
+
+  static constexpr uint64_t noWidth = UINT64_MAX;
+  /**
+  \brief Largest width of a lookbehind assertion; keeps products of widths
+  and repeat counts from overflowing.
+  */
+  static constexpr uint64_t maxWidth = UINT32_MAX;
+
+  /**
+  \brief Widths of the groups open within lookbehind assertions, innermost
+  last. Empty outside of lookbehind assertions.
+  */
+  vector<Width> widths_{};
+  /**
+  \brief Number of open lookbehind assertions.
+  */
+  uint_type lookbehinds_ = 0;
+  /**
+  \brief Peak number of nested lookbehind assertions during the last output.
+  */
+  size_t peakChecks_ = 0;
 
   /**
   \brief Resets the output generator.
@@ -110,318 +156,697 @@ class ReonOutput: public OutputGenerator {
   void clear_all() {
     knownGroups_.clear();
     numberGroups_ = 0;
+    inComment_ = false;
 
-    semanticChecks_.clear();
+    widths_.clear();
+    lookbehinds_ = 0;
   }
 
   /**
-  \brief Semantic check; checks if this part of the RE has fixed length.
+  \brief Marks the width of a group as variable, keeping the first reason.
   */
-  void fixed_length_check(const Symbol &symbol) {
-    if (symbol.name() == "repeat") {
-      // must be a constant length
-      for (char c : symbol.attribute()) {
-        if (!std::isdigit(c))
-          throw SemanticError(
-              "RE of non-constant length within a lookbehind assertion.");
-      }
-
-    } else if (symbol.name() == "ref" || symbol.name() == "nref") {
-      throw SemanticError(
-          "REON currently does not support group references within lookbehind "
-          "assertions.");
-    } else if (symbol.name() == "|") {
-      throw SemanticError(
-          "REON currently does not support alternatives within lookbehind "
-          "assertions.");
-    }
+  static void set_variable(Width &w, const char *reason) {
+    if (!w.variable)
+      w.variable = reason;
   }
 
   /**
-  \brief Adds fixed_length_check to semantic checks.
+  \brief Adds an atom to the innermost group.
+  \param[in] width Width of the atom.
+  \param[in] last Width of its last part, which a repeat applies to.
   */
-  void add_fixed_length_check(std::ostream &, const Symbol &) {
-    semanticChecks_.push_back(std::bind(&ReonOutput::fixed_length_check, this,
-                                        std::placeholders::_1));
+  void add_width(uint64_t width, uint64_t last) {
+    Width &top = widths_.back();
+    top.current += width;
+    top.last = std::min(last, maxWidth);
+    if (top.current > maxWidth) {
+      top.current = maxWidth;
+      set_variable(top, "Lookbehind assertion is too long.");
+    }
   }
 
   /**
-  \brief Pops the stack of semantic checks.
+  \brief Ends the current alternative of a group; alternatives of a fixed
+  width group have equal widths.
   */
-  void end_check(std::ostream &, const Symbol &) { semanticChecks_.pop_back(); }
+  static void end_alternative(Width &w) {
+    if (w.alternatives == noWidth) {
+      w.alternatives = w.current;
+    } else if (w.alternatives != w.current) {
+      set_variable(w, "Alternatives of different lengths within a lookbehind "
+                      "assertion.");
+    }
+  }
 
   /**
-  \brief Outputs a 're' terminal. Escapes all appropriate characters, unescapes
-  ., $, ^.
-  Checks escapes for validity.
+  \brief Adds a literal of a 're' terminal. Escapes of assertions have no
+  width.
   */
-  void re(std::ostream &out, const Symbol &s) {
-    bool lastEscaped = false;
-    for (char c : s.attribute()) {
-      /* regular character output */
-      if (!lastEscaped) {
-        switch (c) {
-          case '*':
-          case '+':
-          case '?':
-          case '{':
-          case '}':
-          case '[':
-          case ']':
-          case '|':
-          case '(':
-          case ')':
-          case '$':
-          case '^':
-          case '.':
-            out << '\\' << c;
-            break;
-          case '\\':
-            lastEscaped = true;
-            break;
-          default:
-            out << c;
-            break;
-        }
-        /* escaped character output */
-      } else {
-        lastEscaped = false;
-        switch (c) {
+  void literal_width(std::string_view a) {
+    uint64_t width = 0;
+    uint64_t last = 0;
+    for (size_t i = 0; i < a.size(); ++i) {
+      last = 1;
+      if (a[i] == '\\' && i + 1 < a.size()) {
+        switch (a[++i]) {
           case 'A':
           case 'b':
           case 'B':
-          case 'd':
-          case 'D':
-          case 'f':
-          case 'n':
-          case 'r':
-          case 's':
-          case 'S':
-          case 't':
-          case 'v':
-          case 'w':
-          case 'W':
           case 'Z':
-          case '\\':
-            out << '\\' << c;
-            break;
-          case '.':
-            out << c;
-            break;
           case '^':
-            out << "\\A";
-            break;
           case '$':
-            out << "\\Z";
+            last = 0;
             break;
           default:
-            throw SemanticError("Unknown escaped sequence \\" + std::string{c} +
-                                ".");
+            break;
         }
       }
+      width += last;
     }
+    add_width(width, last);
   }
 
   /**
-  \brief Outputs 'set' terminal. Escapes appropriate characters. Checks
-  character ranges.
+  \brief Multiplies the last atom by a repeat. Only constant repeats of atoms
+  with a width keep the width fixed.
   */
-  void set(std::ostream &out, const Symbol &s) {
-    string finalSet;
-    bool escape = false;
-    bool range = false;
-    char last = '\0';
-    for (char c : s.attribute()) {
-      if (escape) {
-        escape = false;
-        finalSet += "\\" + string{c};
-        continue;
+  void repeat_width(std::string_view a) {
+    Width &top = widths_.back();
+    uint64_t count = 0;
+    // non-constant repeats are rejected even if the atom has no width
+    for (char c : a) {
+      if (!std::isdigit(static_cast<unsigned char>(c))) {
+        set_variable(top,
+                     "RE of non-constant length within a lookbehind "
+                     "assertion.");
+        return;
       }
-      if (range) {
-        range = false;
-        if (last >= c)
-          throw SemanticError("Invalid char range " + string{last} + "-" +
-                              string{c} + ".");
-        finalSet += "-";
+      // larger counts make the assertion too long anyway
+      if (count <= maxWidth)
+        count = count * 10 + (c - '0');
+    }
+    if (top.last == 0)
+      return;
+    count = std::min(count, maxWidth + 1);
+    uint64_t last = top.last;
+    top.current -= last;
+    add_width(last * count, last * count);
+  }
+
+  /**
+  \brief Closes the innermost group and adds it to the enclosing one.
+  */
+  void close_width() {
+    Width w = widths_.back();
+    widths_.pop_back();
+    end_alternative(w);
+    if (w.zero) {
+      // a lookaround may contain anything, even variable width patterns
+      add_width(0, 0);
+      return;
+    }
+    if (w.variable)
+      set_variable(widths_.back(), w.variable);
+    add_width(w.current, w.current);
+  }
+
+  /**
+  \brief Semantic check; measures the width of output symbols within
+  lookbehind assertions, which must be fixed. Group references are rejected.
+  */
+  void measure(const ReonSymbol &s) {
+    using reon::OutputId;
+    switch (s.id) {
+      case OutputId::RE:
+        return literal_width(s.attribute);
+      case OutputId::SET_CLOSE:
+        return add_width(1, 1);
+      case OutputId::NEVER:
+        return add_width(0, 0);
+      case OutputId::REPEAT:
+        return repeat_width(s.attribute);
+      case OutputId::ALTERNATIVE: {
+        Width &top = widths_.back();
+        end_alternative(top);
+        top.current = 0;
+        top.last = 0;
+        return;
       }
-      if (c != '-')
-        last = c;
+      case OutputId::REF:
+      case OutputId::NREF:
+        throw SemanticError(
+            "REON currently does not support group references within "
+            "lookbehind assertions.");
+      case OutputId::NC_GROUP_OPEN:
+      case OutputId::GROUP_OPEN:
+      case OutputId::NAMED_GROUP_OPEN:
+      case OutputId::COMMENT_OPEN:
+      case OutputId::CONDITION_OPEN:
+      case OutputId::REF_OPEN:
+        widths_.push_back(Width{});
+        return;
+      case OutputId::LOOKAHEAD_OPEN:
+      case OutputId::NLOOKAHEAD_OPEN:
+      case OutputId::LOOKBEHIND_OPEN:
+      case OutputId::NLOOKBEHIND_OPEN:
+        widths_.push_back(Width{});
+        widths_.back().zero = true;
+        return;
+      case OutputId::GROUP_CLOSE:
+        return close_width();
+      default:
+        return;
+    }
+  }
+
+  /**
+  \brief Starts measuring the body of a lookbehind assertion.
+  */
+  void add_fixed_length_check(const ReonSymbol &) {
+    widths_.push_back(Width{});
+    if (++lookbehinds_ > peakChecks_)
+      peakChecks_ = lookbehinds_;
+  }
+
+  /**
+  \brief Ends the body of a lookbehind assertion. Checks that its width is
+  fixed.
+  */
+  void end_check(const ReonSymbol &) {
+    Width w = widths_.back();
+    widths_.pop_back();
+    --lookbehinds_;
+    end_alternative(w);
+    if (w.variable)
+      throw SemanticError(w.variable);
+  }
+
+  /**
+  \brief Escapes of 're' terminals.
+  */
+  static constexpr EscapeTable reEscapes =
+      make_escape_table("*+?{}[]|()$^.", "\\");
+  /**
+  \brief Escapes of 'set' terminals.
+  */
+  static constexpr EscapeTable setEscapes =
+      make_escape_table("]^\"", "\\-");
+  /**
+  \brief Escapes of 'comment' terminals.
+  */
+  static constexpr EscapeTable commentEscapes = make_escape_table(")", "");
+
+  /**
+  \brief Outputs a 're' terminal. Escapes all appropriate characters, unescapes
+  ., $, ^.
+  Checks escapes for validity.
+  */
+  void re(const ReonSymbol &s) {
+    std::string_view a = s.attribute;
+    size_t i = 0;
+    while ((i += out_.write_escaped(a.substr(i), reEscapes)) < a.size()) {
+      // escaped character output
+      if (++i == a.size())
+        break;
+      char c = a[i++];
       switch (c) {
+        case 'A':
+        case 'b':
+        case 'B':
+        case 'd':
+        case 'D':
+        case 'f':
+        case 'n':
+        case 'r':
+        case 's':
+        case 'S':
+        case 't':
+        case 'v':
+        case 'w':
+        case 'W':
         case '\\':
-          escape = true;
+          out_.put('\\');
+          out_.put(c);
+          break;
+        case 'Z':
+          out_.write(target_ == Target::RE2 ? "\\z" : "\\Z");
           break;
-        case '-':
-          range = true;
+        case '.':
+          out_.put(c);
           break;
-        case ']':
         case '^':
-        case '"':
-          finalSet += "\\" + string{c};
+          out_.write("\\A");
+          break;
+        case '$':
+          out_.write(target_ == Target::RE2 ? "\\z" : "\\Z");
           break;
         default:
-          finalSet += string{c};
-      }  // switch
-    }    // for all characters
-    if (range)
-      finalSet += "-";
-    out << finalSet;
+          throw SemanticError("Unknown escaped sequence \\" + std::string{c} +
+                              ".");
+      }
+    }
+  }
+
+  /**
+  \brief Outputs 'set' terminal. Escapes appropriate characters. Checks
+  character ranges.
+  */
+  void set(const ReonSymbol &s) {
+    std::string_view a = s.attribute;
+    char last = '\0';
+    size_t i = 0;
+    while (i < a.size()) {
+      size_t run = out_.write_escaped(a.substr(i), setEscapes);
+      if (run > 0)
+        last = a[i + run - 1];
+      i += run;
+      if (i == a.size())
+        break;
+      if (a[i++] == '\\') {
+        last = '\\';
+        if (i == a.size())
+          break;
+        out_.put('\\');
+        out_.put(a[i++]);
+        continue;
+      }
+      // range; the upper bound is checked and output here
+      if (i == a.size()) {
+        out_.put('-');
+        break;
+      }
+      char c = a[i];
+      if (last >= c)
+        throw SemanticError("Invalid char range " + string{last} + "-" +
+                            string{c} + ".");
+      out_.put('-');
+      if (c == '-') {
+        // the next character is a range bound again
+        continue;
+      }
+      if (c == '\\') {
+        last = c;
+        if (++i == a.size())
+          break;
+        out_.put('\\');
+        out_.put(a[i++]);
+        continue;
+      }
+      last = c;
+      if (setEscapes[c] == EscapeClass::ESCAPE)
+        out_.put('\\');
+      out_.put(c);
+      ++i;
+    }
   }
 
   /**
   \brief Outputs a 'ref' terminal. Checks if a group with this name exists.
   */
-  void ref(std::ostream &out, const Symbol &s) {
-    if (knownGroups_.count(s.attribute()) == 0)
-      throw SemanticError("No group named " + s.attribute() +
+  void ref(const ReonSymbol &s) {
+    if (knownGroups_.count(s.attribute) == 0)
+      throw SemanticError("No group named " + string(s.attribute) +
                           " is known at this point.");
-    out << s.attribute();
+    out_.write(s.attribute);
   }
   /**
   \brief Outputs a 'nref' terminal. Checks if a group with this number exists.
   */
-  void nref(std::ostream &out, const Symbol &s) {
-    char *endptr;
-    long x = std::strtol(s.attribute().c_str(), &endptr, 10);
-    if (*endptr != '\0' || x < 1)
+  void nref(const ReonSymbol &s) {
+    uint_type x = 0;
+    bool number = !s.attribute.empty();
+    for (char c : s.attribute) {
+      if (!std::isdigit(c)) {
+        number = false;
+        break;
+      }
+      // larger values are rejected anyway
+      if (x < 1000)
+        x = x * 10 + (c - '0');
+    }
+    if (!number || x < 1)
       throw SemanticError(
           "Only positive integers are permitted as references.");
-    if (static_cast<uint_type>(x) > numberGroups_)
-      throw SemanticError("No group with number " + s.attribute() + ".");
+    if (x > numberGroups_)
+      throw SemanticError("No group with number " + string(s.attribute) +
+                          ".");
     if (x > 99)
       throw SemanticError(
           "Python supports numbered references of groups only up to group 99.");
 
-    out << s.attribute();
+    out_.write(s.attribute);
   }
   /**
   \brief Outputs a comment. Escapes ')'.
   */
-  void comment(std::ostream &out, const Symbol &s) {
-    for (char c : s.attribute()) {
-      if (c == ')')
-        out << '\\';
-      out << c;
-    }
+  void comment(const ReonSymbol &s) {
+    if (target_ == Target::RE2)
+      return;
+    out_.write_escaped(s.attribute, commentEscapes);
   }
   /**
-  \brief Outputs a 'repeat' terminal. Checks the repetition validity.
+  \brief Outputs a 'repeat' terminal as {m}, {m,}, {0,n} or {m,n}. Checks
+  the repetition validity.
   */
-  void repeat(std::ostream &out, const Symbol &s) {
+  void repeat(const ReonSymbol &s) {
+    if (target_ == Target::RE2)
+      return re2_repeat(s);
+    std::string_view a = s.attribute;
     // most of validity is assured by lexical analysis
-    // check if m is larger than n
-    if (s.attribute().length() == 1) {
-      switch (s.attribute()[0]) {
-        case '*':
-        case '+':
-        case '?':
-          out << s.attribute();
-          return;
-        default:
-          break;
-      }
+    if (a == "*" || a == "+" || a == "?") {
+      out_.write(a);
+      return;
     }
-    out << "{";
-    if (s.attribute().back() != '-') {
-      uint_type first = 0;
-      uint_type second = 0;
-
-      uint_type *current = &first;
-      for (char c : s.attribute()) {
-        if (c == '-') {
-          current = &second;
-          continue;
+    size_t dash = a.find('-');
+    std::string_view first = a.substr(0, dash);
+    out_.put('{');
+    out_.write(first.empty() ? "0" : first);
+    if (dash != std::string_view::npos) {
+      std::string_view second = a.substr(dash + 1);
+      // check if m is larger than n
+      if (!second.empty()) {
+        uint_type m = 0;
+        uint_type n = 0;
+        for (char c : first) {
+          m = m * 10 + (c - '0');
+        }
+        for (char c : second) {
+          n = n * 10 + (c - '0');
         }
-        *current = *current * 10 + (c - '0');
+        if (m >= n)
+          throw SemanticError(
+              "Maximum repeats are larger than minimum repeats.");
       }
-      if (current == &second && first >= second)
-        throw SemanticError("Maximum repeats are larger than minimum repeats.");
+      out_.put(',');
+      out_.write(second);
     }
-    out << s.attribute();
-    out << "}";
+    out_.put('}');
   }
+  /**
+  \brief Outputs a 'repeat' terminal in RE2 syntax, {m,n}. Checks the
+  repetition validity and the RE2 repeat limit.
+  */
+  void re2_repeat(const ReonSymbol &s) {
+    std::string_view a = s.attribute;
+    if (a == "*" || a == "+" || a == "?") {
+      out_.write(a);
+      return;
+    }
+    size_t dash = a.find('-');
+    std::string_view first = a.substr(0, dash);
+    std::string_view second =
+        dash == std::string_view::npos ? first : a.substr(dash + 1);
+    auto count = [](std::string_view n) {
+      uint_type x = 0;
+      for (char c : n) {
+        // larger values are rejected anyway
+        if (x <= 1000)
+          x = x * 10 + (c - '0');
+      }
+      if (x > 1000)
+        throw SemanticError("RE2 supports repeat counts only up to 1000.");
+      return x;
+    };
+    uint_type m = count(first);
+    if (!second.empty() && dash != std::string_view::npos && m >= count(second))
+      throw SemanticError("Maximum repeats are larger than minimum repeats.");
+    out_.put('{');
+    out_.write(first.empty() ? "0" : first);
+    if (dash != std::string_view::npos) {
+      out_.put(',');
+      out_.write(second);
+    }
+    out_.put('}');
+  }
+
   /**
   \brief Outputs the 'named_group' terminal. Validates the group's name. Adds
   the group name to the set of known group names.
   */
-  void named_group(std::ostream &out, const Symbol &s) {
+  void named_group(const ReonSymbol &s) {
     numberGroups_++;
     // checking validity of identifier
-    if (s.attribute().length() == 0)
+    if (s.attribute.length() == 0)
       throw SemanticError(
           "Identifier of a named group cannot have a length of 0.");
-    char first = s.attribute()[0];
+    char first = s.attribute[0];
     if (!std::isalpha(first) && first != '_') {
       throw SemanticError("Identifier of a named group cannot start with " +
                           string{first} + ".");
     }
-    for (char c : s.attribute()) {
+    for (char c : s.attribute) {
       if (!std::isalnum(c) && c != '_')
         throw SemanticError("Identifier of a named group cannot contain " +
                             string{first} + ".");
     }
-    out << s.attribute();
-    if (knownGroups_.find(s.attribute()) != knownGroups_.end()) {
+    out_.write(s.attribute);
+    if (knownGroups_.find(s.attribute) != knownGroups_.end()) {
       throw SemanticError("Multiple definitions of a group with name " +
-                          s.attribute() + ".");
+                          string(s.attribute) + ".");
     }
-    knownGroups_.insert(s.attribute());
+    knownGroups_.emplace(s.attribute);
   }
   /**
   \brief Marks the presence of a group.
   */
-  void group(std::ostream &, const Symbol &) { numberGroups_++; }
+  void group(const ReonSymbol &) { numberGroups_++; }
+
+  /**
+  \brief Outputs a Python string literal.
+  */
+  void python_string(std::string_view s) {
+    out_.put('\'');
+    for (char c : s) {
+      auto u = static_cast<unsigned char>(c);
+      if (c == '\'' || c == '\\') {
+        out_.put('\\');
+        out_.put(c);
+      } else if (u < 0x20 || u == 0x7F) {
+        const char *digits = "0123456789abcdef";
+        out_.write("\\x");
+        out_.put(digits[u >> 4]);
+        out_.put(digits[u & 15]);
+      } else {
+        out_.put(c);
+      }
+    }
+    out_.put('\'');
+  }
 
   /**
   \brief Outputs the set variable name.
   */
-  void variable(std::ostream &out, const Symbol &) { out << globals::varname; }
+  void variable(const ReonSymbol &) {
+    // RE2 patterns are not assigned
+    if (target_ == Target::PYTHON)
+      out_.write(variable_);
+  }
 
   /**
   \brief Outputs a terminal's name.
   */
-  void symbol(std::ostream &out, const Symbol &s) {
+  void symbol(const ReonSymbol &s) {
     // unknown; putting name to output
-    out << s.name();
+    out_.write(reon::outputNames[static_cast<size_t>(s.id)]);
   }
 
-  void single_terminal(std::ostream &out, const Symbol &s) {
-    if (s == Symbol::eof()) {
-      clear_all();
-      return;
+  /**
+  \brief Outputs a symbol in RE2 syntax. Rejects constructs that RE2 does not
+  support.
+  */
+  void re2_symbol(const ReonSymbol &s) {
+    using reon::OutputId;
+    switch (s.id) {
+      case OutputId::ASSIGNMENT:
+        return out_.write("(?s)");
+      case OutputId::END:
+        return out_.put('\n');
+      case OutputId::NEVER:
+        // an empty class; RE2 has no lookahead
+        return out_.write("[^\\x00-\\x{10FFFF}]");
+      case OutputId::COMMENT_OPEN:
+        inComment_ = true;
+        return;
+      case OutputId::GROUP_CLOSE:
+        if (inComment_) {
+          inComment_ = false;
+          return;
+        }
+        return symbol(s);
+      case OutputId::LOOKAHEAD_OPEN:
+      case OutputId::NLOOKAHEAD_OPEN:
+        throw SemanticError("RE2 does not support lookahead assertions.");
+      case OutputId::LOOKBEHIND_OPEN:
+      case OutputId::NLOOKBEHIND_OPEN:
+        throw SemanticError("RE2 does not support lookbehind assertions.");
+      case OutputId::CONDITION_OPEN:
+        throw SemanticError(
+            "RE2 does not support conditional matching with if.");
+      case OutputId::REF_OPEN:
+      case OutputId::BACKSLASH:
+        throw SemanticError(
+            "RE2 does not support group references with match group.");
+      default:
+        return symbol(s);
     }
-    for (auto check : semanticChecks_) {
-      check(s);
+  }
+
+  void single_terminal(const ReonSymbol &s) {
+    if (!widths_.empty())
+      measure(s);
+    // runs id specific method
+    using reon::OutputId;
+    switch (s.id) {
+      case OutputId::RE:
+        return re(s);
+      case OutputId::SET:
+        return set(s);
+      case OutputId::REF:
+        return ref(s);
+      case OutputId::NREF:
+        return nref(s);
+      case OutputId::COMMENT:
+        return comment(s);
+      case OutputId::REPEAT:
+        return repeat(s);
+      case OutputId::NAMED_GROUP:
+        return named_group(s);
+      case OutputId::GROUP:
+        return group(s);
+      case OutputId::FIXED_LENGTH_CHECK:
+        return add_fixed_length_check(s);
+      case OutputId::END_CHECK:
+        return end_check(s);
+      case OutputId::VARIABLE:
+        return variable(s);
+      default:
+        return target_ == Target::RE2 ? re2_symbol(s) : symbol(s);
     }
-    // runs name specific method
-    auto it = symbolMap_.find(s);
-    if (it == symbolMap_.end())
-      return symbol(out, s);
-    return it->second(out, s);
   }
 
  public:
   /**
-  \brief Outputs the incoming symbol. Resets on receiving Symbol::eof().
-  Performs semantic checks.
-  \param[out] out Output stream.
-  \param[in] s Incoming symbol.
+  \brief Outputs a translation. Performs semantic checks.
+  \param[in] begin First output symbol.
+  \param[in] end Past the last output symbol.
+
+  Throws SemanticError if a semantic check fails.
+  */
+  template <typename Iterator>
+  void output(Iterator begin, Iterator end) {
+    output(begin, end, [](size_t) {});
+  }
+
+  /**
+  \brief Outputs a translation like output(begin, end) and reports where the
+  output of each symbol begins.
+  \param[in] offset Called with the number of bytes output by this call
+  before each symbol and once more after the last one.
   */
-  virtual void output(const tstack<Symbol> &terminals) {
-    if (this != cbinding_)
-      bind_callbacks();
+  template <typename Iterator, typename F>
+  void output(Iterator begin, Iterator end, F offset) {
+    // the generator may be reused after a failed translation
+    clear_all();
+    peakChecks_ = 0;
+    size_t start = out_.position();
     try {
-      for (auto &s : terminals) {
-        single_terminal(*os_, s);
+      for (; begin != end; ++begin) {
+        offset(out_.position() - start);
+        single_terminal(*begin);
       }
-    } catch (SemanticError &se) {
-      errorFlag_ = true;
-      errorString_ += string(se.what()) + "\n";
+      offset(out_.position() - start);
+    } catch (...) {
+      // output produced before the error is kept
+      out_.flush();
+      throw;
+    }
+    out_.flush();
+    clear_all();
+  }
+
+  /**
+  \brief Sets the output stream.
+  */
+  void set_output(std::ostream &o) { out_.set_stream(o); }
+
+  /**
+  \brief Sets the output string the translations are appended to.
+  */
+  void set_output(std::string &o) { out_.set_string(o); }
+
+  /**
+  \brief Outputs the bounds of the length of matches of the last pattern as
+  the Python assignments of variable_minlen and variable_maxlen, which is None
+  if unbounded. RE2 patterns get no bounds.
+  */
+  void lengths(uint64_t min, uint64_t max, bool unbounded) {
+    if (target_ != Target::PYTHON)
       return;
+    out_.write(variable_);
+    out_.write("_minlen = ");
+    out_.write(std::to_string(min));
+    out_.put('\n');
+    out_.write(variable_);
+    out_.write("_maxlen = ");
+    out_.write(unbounded ? "None" : std::to_string(max));
+    out_.put('\n');
+    out_.flush();
+  }
+
+  /**
+  \brief Outputs the prefilter of the last pattern as the Python assignments
+  of variable_required, a tuple of the literals every match contains, and
+  variable_first, a frozenset of the characters matches begin with, followed
+  by variable_prefilter(s), which returns False if s cannot contain a match.
+  RE2 patterns get no prefilter.
+  \param[in] required The required literals.
+  \param[in] first The first characters; None is output if nullptr.
+  */
+  void prefilter(const std::vector<std::string> &required,
+                 const std::string *first) {
+    if (target_ != Target::PYTHON)
+      return;
+    out_.write(variable_);
+    out_.write("_required = (");
+    for (size_t i = 0; i < required.size(); ++i) {
+      if (i > 0)
+        out_.write(", ");
+      python_string(required[i]);
+    }
+    // a tuple of one element needs a comma
+    out_.write(required.size() == 1 ? ",)\n" : ")\n");
+    out_.write(variable_);
+    out_.write("_first = ");
+    if (first) {
+      out_.write("frozenset(");
+      python_string(*first);
+      out_.put(')');
+    } else {
+      out_.write("None");
     }
+    out_.write("\ndef ");
+    out_.write(variable_);
+    out_.write("_prefilter(s):\n    return (all(r in s for r in ");
+    out_.write(variable_);
+    out_.write("_required) and\n            (");
+    out_.write(variable_);
+    out_.write("_first is None or not ");
+    out_.write(variable_);
+    out_.write("_first.isdisjoint(s)))\n");
+    out_.flush();
   }
 
-  virtual string error_message() { return errorString_; }
+  /**
+  \brief Returns the number of bytes output so far.
+  */
+  size_t written() const { return out_.written(); }
+
+  /**
+  \brief Returns the peak depth of nested lookbehind assertions of the last
+  output.
+  */
+  size_t peak_checks() const { return peakChecks_; }
 };
 
 #endif
-/*** End of file reon_output_generator.h ***/
\ No newline at end of file
+/*** End of file reon_output_generator.h ***/
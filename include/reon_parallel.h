@@ -0,0 +1,33 @@
+/**
+\file reon_parallel.h
+\brief Declares the work-stealing thread pool of batch translations.
+\author Radek Vít
+*/
+#ifndef REON_PARALLEL
+#define REON_PARALLEL
+
+#include <cstddef>
+#include <functional>
+
+namespace reon {
+
+/**
+\brief Runs jobs on a work-stealing pool of threads.
+\param[in] count Number of jobs.
+\param[in] threads Number of workers. Jobs run on the calling thread if at
+most 1.
+\param[in] run Called with the index of the worker and of the job. A worker
+runs one job at a time, so per-worker state needs no locking.
+
+Each worker starts with a contiguous block of the jobs and takes them from the
+front. Idle workers steal jobs from the back of other blocks. The first
+exception thrown by run is rethrown after all workers stop; the jobs that did
+not start by then are skipped.
+*/
+void parallel_for(size_t count, size_t threads,
+                  const std::function<void(size_t worker, size_t job)> &run);
+
+}  // namespace reon
+
+#endif
+/*** End of file reon_parallel.h ***/
@@ -0,0 +1,142 @@
+/**
+\file reon_passes.h
+\brief Declares the rewrite passes over reon ASTs and their manager.
+\author Radek Vít
+*/
+#ifndef REON_PASSES
+#define REON_PASSES
+
+#include <reon_ast.h>
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+namespace reon {
+
+/**
+\brief A rewrite pass over an AST.
+*/
+struct Pass {
+  /**
+  \brief Name used on the command line.
+  */
+  const char *name;
+  const char *description;
+  void (*run)(Ast &ast);
+};
+
+/**
+\brief Flattens nested sequences and replaces sequences of a single element
+with the element. Does not change the output.
+*/
+void flatten_pass(Ast &ast);
+
+/**
+\brief Removes alternatives that can never match and contain only literals
+without escapes. Alternatives within lookbehind assertions are kept.
+*/
+void never_pass(Ast &ast);
+
+/**
+\brief Factors common prefixes and suffixes of alternatives made of literals
+into a trie, so that the alternatives are not tried one by one. Alternatives
+may be reordered.
+*/
+void trie_pass(Ast &ast);
+
+/**
+\brief Removes non-capturing groups where precedence does not need them:
+around repeated atoms, around single alternatives and nested alternatives,
+and around alternatives that fill a group or the pattern.
+*/
+void groups_pass(Ast &ast);
+
+/**
+\brief All passes in the order they run.
+*/
+constexpr Pass passes[] = {
+    {"flatten", "flattens nested sequences", flatten_pass},
+    {"never", "removes alternatives that never match", never_pass},
+    {"trie", "factors common prefixes of literal alternatives", trie_pass},
+    {"groups", "removes needless non-capturing groups", groups_pass},
+};
+
+constexpr size_t passCount = sizeof(passes) / sizeof(*passes);
+
+/**
+\brief Runs the enabled passes between parsing and output generation, and
+measures them.
+
+All passes are enabled by default. If none is enabled, the symbols are not
+rewritten at all.
+*/
+class PassManager {
+ public:
+  PassManager();
+
+  /**
+  \brief Enables or disables a pass.
+  \param[in] name Name of the pass.
+
+  Throws std::invalid_argument for unknown passes.
+  */
+  void enable(std::string_view name, bool enabled);
+
+  /**
+  \brief Enables or disables all passes.
+  */
+  void enable_all(bool enabled);
+
+  bool any_enabled() const;
+
+  /**
+  \brief Returns true if the pass with an index into passes is enabled.
+  */
+  bool enabled(size_t pass) const { return enabled_[pass]; }
+
+  /**
+  \brief Rewrites output symbols of a translation: builds their AST, runs
+  the enabled passes and lowers the AST back to symbols.
+  \param[in,out] symbols The symbols, replaced by the rewritten symbols.
+  \param[out] ast The AST of the symbols; owns texts created by passes, so it
+  must outlive the use of the symbols.
+  */
+  void run(std::vector<ReonSymbol> &symbols, Ast &ast);
+
+  /**
+  \brief Prints the time spent building the AST, in each pass and lowering
+  the AST.
+  */
+  void report(std::ostream &os) const;
+
+  /**
+  \brief Adds the measurements of another manager, e.g. of a worker thread.
+  */
+  void merge(const PassManager &other);
+
+  /**
+  \brief Prints the names and descriptions of all passes.
+  */
+  static void list(std::ostream &os);
+
+ protected:
+  using Duration = std::chrono::steady_clock::duration;
+
+  bool enabled_[passCount];
+  Duration passTime_[passCount] = {};
+  Duration buildTime_{};
+  Duration lowerTime_{};
+  size_t runs_ = 0;
+  /**
+  \brief Nodes of the ASTs before and after the passes.
+  */
+  size_t nodesBefore_ = 0;
+  size_t nodesAfter_ = 0;
+};
+
+}  // namespace reon
+
+#endif
+/*** End of file reon_passes.h ***/
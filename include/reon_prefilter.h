@@ -0,0 +1,97 @@
+/**
+\file reon_prefilter.h
+\brief Declares the extraction of prefilters of reon patterns: the literals
+every match contains and the bytes matches begin with.
+\author Radek Vít
+*/
+#ifndef REON_PREFILTER
+#define REON_PREFILTER
+
+#include <reon_ast.h>
+#include <reon_program.h>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace reon {
+
+/**
+\brief Necessary conditions of a text containing a match of a pattern, which
+reject most other texts faster than matching.
+
+The conditions hold for both the native engine and Python re: \\d, \\s and
+\\w may begin with any byte from 0x80, and \\s with 0x1c to 0x1f, which
+Python's Unicode classes match.
+*/
+struct Prefilter {
+  /**
+  \brief Literals every match contains, longest first.
+  */
+  std::vector<std::string> required{};
+  /**
+  \brief Bytes a match may begin with; unused if anyFirst.
+  */
+  ByteSet first{};
+  /**
+  \brief Set if matches may be empty or begin with any byte.
+  */
+  bool anyFirst = true;
+  /**
+  \brief Set if the pattern never matches.
+  */
+  bool never = false;
+
+  /**
+  \brief Returns false if text cannot contain a match.
+  \param[in] anchored Matches must begin at the beginning of text.
+  */
+  bool accepts(std::string_view text, bool anchored = false) const;
+
+  /**
+  \brief Returns true if no text is rejected.
+  */
+  bool empty() const { return !never && anyFirst && required.empty(); }
+
+  /**
+  \brief Stores the characters matches may begin with if all are ASCII.
+  \param[out] chars The characters in ascending order.
+  \returns False if a match may be empty or begin with any other character;
+  chars are unused then.
+  */
+  bool ascii_first(std::string &chars) const;
+};
+
+/**
+\brief Maximal number of required literals of a prefilter; the longest are
+kept.
+*/
+constexpr size_t maxRequiredLiterals = 8;
+/**
+\brief Maximal length of a required literal; longer runs are cut.
+*/
+constexpr size_t maxLiteralLength = 256;
+
+/**
+\brief Extracts the prefilter of an AST.
+
+Group references and negative lookaround require nothing. Positive
+lookaround requires the literals of its subtree but does not join the
+literals around it.
+*/
+Prefilter prefilter(const Ast &ast);
+
+/**
+\brief Extracts the prefilter of a translation.
+\param[in] symbols Output symbols of the translation, before or after the
+passes.
+\param[out] ast Receives the AST of the symbols; reused between calls.
+
+Patterns nested too deep for an AST get an empty prefilter.
+*/
+Prefilter prefilter(const std::vector<ReonSymbol> &symbols, Ast &ast);
+
+}  // namespace reon
+
+#endif
+/*** End of file reon_prefilter.h ***/
@@ -0,0 +1,194 @@
+/**
+\file reon_program.h
+\brief Declares the instruction program compiled from reon for native
+matching.
+\author Radek Vít
+*/
+#ifndef REON_PROGRAM
+#define REON_PROGRAM
+
+#include <reon_output_generator.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace reon {
+
+/**
+\brief Set of bytes.
+*/
+struct ByteSet {
+  uint64_t bits[4] = {};
+
+  bool test(unsigned char c) const { return bits[c >> 6] >> (c & 63) & 1; }
+  void set(unsigned char c) { bits[c >> 6] |= uint64_t{1} << (c & 63); }
+  void set_range(unsigned char lo, unsigned char hi) {
+    for (unsigned c = lo; c <= hi; ++c) {
+      set(static_cast<unsigned char>(c));
+    }
+  }
+  void merge(const ByteSet &other) {
+    for (size_t i = 0; i < 4; ++i) {
+      bits[i] |= other.bits[i];
+    }
+  }
+  void invert() {
+    for (auto &b : bits) {
+      b = ~b;
+    }
+  }
+  size_t count() const {
+    size_t n = 0;
+    for (uint64_t b : bits) {
+      for (; b; b &= b - 1) {
+        ++n;
+      }
+    }
+    return n;
+  }
+  bool operator==(const ByteSet &other) const {
+    for (size_t i = 0; i < 4; ++i) {
+      if (bits[i] != other.bits[i])
+        return false;
+    }
+    return true;
+  }
+};
+
+/**
+\brief Returns true for bytes matched by \\w.
+*/
+inline bool is_word_byte(unsigned char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+         (c >= '0' && c <= '9') || c == '_';
+}
+
+/**
+\brief Instruction operations.
+*/
+enum class Op : uint8_t {
+  /**
+  \brief Matches the byte arg.
+  */
+  BYTE,
+  /**
+  \brief Matches a byte from the set classes[arg].
+  */
+  CLASS,
+  /**
+  \brief Matches any byte.
+  */
+  ANY,
+  /**
+  \brief Continues at arg.
+  */
+  JUMP,
+  /**
+  \brief Continues at arg, then at alt with lower priority.
+  */
+  SPLIT,
+  /**
+  \brief Stores the position to capture slot arg.
+  */
+  SAVE,
+  /**
+  \brief Continues only if the assertion arg holds.
+  */
+  ASSERT,
+  /**
+  \brief Never continues.
+  */
+  FAIL,
+  /**
+  \brief Reports a match.
+  */
+  MATCH
+};
+
+/**
+\brief Zero width assertions.
+*/
+enum class Assertion : uint8_t {
+  BEGIN_TEXT,
+  END_TEXT,
+  WORD_BOUNDARY,
+  NOT_WORD_BOUNDARY
+};
+
+/**
+\brief Checks an assertion at a position of the text.
+*/
+bool assertion_holds(Assertion a, std::string_view text, size_t position);
+
+/**
+\brief A single instruction. Instructions other than JUMP and SPLIT continue
+with the following instruction.
+*/
+struct Inst {
+  Op op;
+  uint32_t arg = 0;
+  uint32_t alt = 0;
+};
+
+/**
+\brief Compiled program of a reon pattern, a Thompson NFA with captures.
+
+Captures are stored in slots; group i begins in slot 2i and ends in slot
+2i + 1. Group 0 is the whole match.
+*/
+struct Program {
+  std::vector<Inst> insts;
+  std::vector<ByteSet> classes;
+  /**
+  \brief Number of groups, including group 0.
+  */
+  size_t groupCount = 1;
+  /**
+  \brief Names of named groups with their numbers.
+  */
+  std::vector<std::pair<std::string, size_t>> groupNames;
+  /**
+  \brief Set if the program matches only at the beginning of the text.
+  */
+  bool anchored = false;
+  /**
+  \brief Set if the program uses assertions other than the anchors.
+  */
+  bool wordBoundaries = false;
+};
+
+/**
+\brief Maximal number of instructions of a compiled program.
+*/
+constexpr size_t maxProgramSize = 1 << 20;
+/**
+\brief Maximal repeat count supported by the compiler.
+*/
+constexpr size_t maxRepeat = 1000;
+
+/**
+\brief Returns the bytes of a 'set' terminal; \\d, \\s and \\w are ASCII
+classes.
+
+Throws SemanticError for invalid ranges and unknown escaped sequences.
+*/
+ByteSet set_bytes(std::string_view set);
+
+/**
+\brief Compiles output symbols of reonGrammar to a program.
+\param[in] symbols Output symbols of a translation.
+\param[in] reversed Compiles a program matching the reversed texts, used to
+find the beginnings of matches.
+
+Throws SemanticError for invalid patterns and for constructs that cannot be
+matched in linear time: group references, conditionals and lookaround.
+*/
+Program compile(const std::vector<ReonSymbol> &symbols, bool reversed = false);
+
+}  // namespace reon
+
+#endif
+/*** End of file reon_program.h ***/
@@ -0,0 +1,137 @@
+/**
+\file reon_redos.h
+\brief Declares the static analysis of catastrophic backtracking in reon
+patterns.
+\author Radek Vít
+*/
+#ifndef REON_REDOS
+#define REON_REDOS
+
+#include <reon_ast.h>
+#include <reon_lexical_analyzer.h>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace reon {
+
+/**
+\brief A subexpression that can make backtracking engines such as Python re
+take exponential or polynomial time.
+*/
+struct RedosIssue {
+  /**
+  \brief Set for exponential backtracking, polynomial otherwise.
+  */
+  bool exponential;
+  /**
+  \brief Repeat string of the offending repeat, refers to the input.
+  */
+  std::string_view at;
+  /**
+  \brief Repeat string of the repeat the offending one interacts with. Empty
+  if there is none.
+  */
+  std::string_view other;
+  std::string message;
+};
+
+/**
+\brief Finds subexpressions of an AST that can backtrack catastrophically:
+- nested unbounded repeats, where the inner repeat can match the text of
+  several iterations of the outer one,
+- alternatives within an unbounded repeat that can match the same text,
+- unbounded repeats following each other that can match the same text.
+
+The languages of subexpressions are compared by the Thompson NFAs of their
+compiled programs. Subexpressions that cannot be compiled, e.g. with group
+references, are assumed to be distinct.
+*/
+std::vector<RedosIssue> find_redos(const Ast &ast);
+
+/**
+\brief A located issue reported by RedosChecker.
+*/
+struct RedosWarning {
+  /**
+  \brief Row and column of the offending repeat, 0 if unknown.
+  */
+  size_t row = 0;
+  size_t col = 0;
+  std::string message;
+};
+
+/**
+\brief Checks translated patterns for catastrophic backtracking and reports
+the issues with their rows and columns.
+*/
+class RedosChecker {
+ public:
+  /**
+  \param[out] warnings Stream receiving the warnings.
+  \param[in] strict Throws a SemanticError on the first issue instead of
+  warning.
+  */
+  explicit RedosChecker(std::ostream &warnings, bool strict = false)
+      : stream_(&warnings), strict_(strict) {}
+  /**
+  \brief Creates a checker that only collects the warnings.
+  */
+  explicit RedosChecker(bool strict = false) : strict_(strict) {}
+
+  /**
+  \brief Checks the output symbols of a translation.
+  \param[in] symbols Output symbols, before any rewriting.
+  \param[in] lexer The lexical analyzer that read the input; locates the
+  issues.
+  \param[in] source Name of the input, may be empty.
+  */
+  void check(const std::vector<ReonSymbol> &symbols, const ReonLexer &lexer,
+             std::string_view source);
+
+  /**
+  \brief Returns the number of issues reported so far.
+  */
+  size_t issues() const { return issues_; }
+
+  bool strict() const { return strict_; }
+
+  /**
+  \brief Returns the issues of the last check. In strict mode, the issue that
+  failed the check is the last one.
+  */
+  const std::vector<RedosWarning> &warnings() const { return warnings_; }
+
+  /**
+  \brief Forgets the issues of the last check.
+  */
+  void clear() { warnings_.clear(); }
+
+  /**
+  \brief Prints a warning the way checkers with a stream do.
+  \param[in] source Name of the input, may be empty.
+  */
+  static void print(std::ostream &os, const RedosWarning &warning,
+                    std::string_view source);
+
+ protected:
+  /**
+  \brief Stream receiving the warnings, nullptr if they are only collected.
+  */
+  std::ostream *stream_ = nullptr;
+  bool strict_;
+  size_t issues_ = 0;
+  std::vector<RedosWarning> warnings_;
+  /**
+  \brief AST of the checked pattern, reused between checks.
+  */
+  Ast ast_;
+
+  static std::string location(std::string_view at, const ReonLexer &lexer);
+};
+
+}  // namespace reon
+
+#endif
+/*** End of file reon_redos.h ***/
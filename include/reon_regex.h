@@ -0,0 +1,161 @@
+/**
+\file reon_regex.h
+\brief Declares native matching of reon patterns.
+\author Radek Vít
+*/
+#ifndef REON_REGEX
+#define REON_REGEX
+
+#include <reon_prefilter.h>
+#include <reon_program.h>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace reon {
+
+/**
+\brief Result of a successful match.
+*/
+struct Match {
+  static constexpr size_t npos = std::string_view::npos;
+
+  /**
+  \brief The matched text.
+  */
+  std::string_view subject{};
+  /**
+  \brief Beginning and end of each group; npos for groups that did not
+  participate in the match.
+  */
+  std::vector<size_t> offsets{};
+
+  /**
+  \brief Returns the number of groups, including group 0.
+  */
+  size_t size() const { return offsets.size() / 2; }
+  bool matched(size_t group) const { return offsets[2 * group] != npos; }
+  size_t begin(size_t group) const { return offsets[2 * group]; }
+  size_t end(size_t group) const { return offsets[2 * group + 1]; }
+  /**
+  \brief Returns the text matched by a group. Empty if the group did not
+  participate in the match.
+  */
+  std::string_view group(size_t group = 0) const {
+    if (!matched(group))
+      return {};
+    return subject.substr(begin(group), end(group) - begin(group));
+  }
+};
+
+/**
+\brief A reon pattern compiled for matching in time linear in the text.
+
+Searches run a lazily built DFA to find where matches end and a DFA of the
+reversed pattern to find where they begin. Groups are then captured by a Pike
+VM over the match only. Texts rejected by the prefilter of the pattern are
+not matched at all. Patterns with word boundaries and DFAs whose cache is
+flushed too often fall back to the Pike VM. Matches and groups are the same
+as those of Python re with the emitted pattern, except in loops whose body
+may match the empty string: Python ends a loop at an iteration that matches
+empty and keeps its groups, while the native engine, like RE2, never iterates
+without consuming and tries the following alternatives of the body instead.
+So {"repeat *": {"group": {"alternatives": ["", "a"]}}} searched in "aa"
+matches "aa" with group 1 at 1-2 natively, but "" with group 1 at 0-0 in
+Python. Characters are bytes, \\d, \\s and \\w are ASCII classes. Group
+references, conditionals and lookaround are rejected when compiling.
+
+A Regex may be used from multiple threads at once; concurrent searches build
+their DFA states in separate caches.
+*/
+class Regex {
+ public:
+  /**
+  \brief Compiles output symbols of reonGrammar.
+
+  Throws SemanticError.
+  */
+  explicit Regex(const std::vector<ReonSymbol> &symbols);
+  Regex(Regex &&) noexcept;
+  Regex &operator=(Regex &&) noexcept;
+  ~Regex();
+
+  /**
+  \brief Compiles a reon document.
+  \param[in] source The reon document.
+
+  Throws LexicalError, TranslationError or SemanticError.
+  */
+  static Regex compile(std::string_view source);
+
+  /**
+  \brief Compiles a reon file.
+  \param[in] path Path to the file.
+  */
+  static Regex compile_file(const std::string &path);
+
+  /**
+  \brief Finds the leftmost match in text, like Python's re.search.
+  \param[in] text Text to search.
+  \param[out] match The match, may be nullptr.
+  \returns True if a match was found.
+  */
+  bool search(std::string_view text, Match *match = nullptr) const;
+
+  /**
+  \brief Matches at the beginning of text, like Python's re.match.
+  */
+  bool match(std::string_view text, Match *match = nullptr) const;
+
+  /**
+  \brief Matches all of text, like Python's re.fullmatch.
+  */
+  bool full_match(std::string_view text, Match *match = nullptr) const;
+
+  /**
+  \brief Returns the number of groups, including group 0.
+  */
+  size_t group_count() const { return program_.groupCount; }
+
+  /**
+  \brief Returns the number of a named group, or Match::npos.
+  */
+  size_t group_index(std::string_view name) const;
+
+  const Program &program() const { return program_; }
+  const Prefilter &prefilter() const { return prefilter_; }
+
+ protected:
+  struct Dfas;
+
+  Program program_;
+  /**
+  \brief DFAs of the program; nullptr if the program is not supported.
+  */
+  std::unique_ptr<Dfas> dfas_;
+  Prefilter prefilter_;
+
+  /**
+  \brief Finds a match with the DFAs, falls back to the Pike VM.
+  \param[in] anchorBegin Matches must begin at the beginning of text.
+  */
+  bool find(std::string_view text, Match *match, bool anchorBegin) const;
+
+  /**
+  \brief Runs the Pike VM.
+  \param[in] anchorBegin Matches must begin at from.
+  \param[in] anchorEnd Matches must end at to.
+  \param[in] from Position where the search begins.
+  \param[in] to Position where the search ends.
+  */
+  bool run(std::string_view text, Match *match, bool anchorBegin,
+           bool anchorEnd, size_t from = 0,
+           size_t to = std::string_view::npos) const;
+};
+
+}  // namespace reon
+
+#endif
+/*** End of file reon_regex.h ***/
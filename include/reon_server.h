@@ -0,0 +1,43 @@
+/**
+\file reon_server.h
+\brief Declares the compile server of reon.
+\author Radek Vít
+*/
+#ifndef REON_SERVER
+#define REON_SERVER
+
+#include <reon.h>
+#include <ostream>
+#include <string>
+
+namespace reon {
+
+/**
+\brief Serves compile requests on a Unix domain socket until SIGINT or
+SIGTERM.
+\param[in] path Path of the socket. A stale socket at the path is replaced.
+\param[in] options Options of all compilations.
+\param[out] log Stream receiving errors of the connections.
+\returns 0 after a signal.
+
+Requests and responses are framed by 32-bit big-endian lengths. A request is
+the reon input:
+
+    u32 length, input
+
+A response carries the return value reon would exit with, the output and the
+messages of the diagnostics, one per line:
+
+    u32 code, u32 length, output, u32 length, messages
+
+Each connection may send any number of requests; responses come in the order
+of the requests. All connections are served by a single warm Compiler.
+
+Throws std::runtime_error if the socket cannot be created.
+*/
+int serve(const std::string &path, const Options &options, std::ostream &log);
+
+}  // namespace reon
+
+#endif
+/*** End of file reon_server.h ***/
@@ -0,0 +1,175 @@
+/**
+\file reon_stats.h
+\brief Declares the per-phase statistics and the trace of translations.
+\author Radek Vít
+*/
+#ifndef REON_STATS
+#define REON_STATS
+
+#include <reon_translation_grammar.h>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace reon {
+
+/**
+\brief Phases of a translation.
+*/
+enum class Phase : uint8_t {
+  /**
+  \brief Reading the input and building its structural index.
+  */
+  READ,
+  LEX,
+  /**
+  \brief LL parsing without the lexical analysis it drives.
+  */
+  PARSE,
+  REDOS,
+  PASSES,
+  /**
+  \brief Output generation with the semantic checks done along the way.
+  */
+  OUTPUT,
+  COUNT
+};
+
+constexpr size_t phaseCount = static_cast<size_t>(Phase::COUNT);
+
+/**
+\brief Names of phases, indexed by Phase.
+*/
+constexpr const char *phaseNames[] = {"read",   "lex",    "parse",
+                                      "redos",  "passes", "output"};
+
+static_assert(sizeof(phaseNames) / sizeof(*phaseNames) == phaseCount,
+              "Every phase must have a name.");
+
+/**
+\brief Timings and counters of translations, and optionally their trace.
+
+A translation only collects statistics when given a Stats, so runs without
+them pay nothing. A single Stats must not be used by multiple threads; each
+worker collects its own and they are merged.
+*/
+class Stats {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  /**
+  \param[in] trace Records an event of each phase of each input.
+  \param[in] thread Thread id of the recorded events.
+  */
+  explicit Stats(bool trace = false, uint32_t thread = 0)
+      : trace_(trace), thread_(thread), epoch_(Clock::now()) {}
+
+  bool tracing() const { return trace_; }
+
+  /**
+  \brief Adds the time spent in a phase without recording an event.
+  */
+  void add(Phase phase, Clock::duration time) {
+    time_[static_cast<size_t>(phase)] += time;
+  }
+
+  /**
+  \brief Adds the time spent in a phase and records its event if tracing.
+  \param[in] input Name of the translated input, may be empty.
+  */
+  void phase(Phase phase, Clock::time_point start, Clock::time_point end,
+             std::string_view input) {
+    add(phase, end - start);
+    event(phaseNames[static_cast<size_t>(phase)], start, end, input);
+  }
+
+  /**
+  \brief Records an event if tracing.
+  \param[in] name Name of the event; must be a string literal.
+  */
+  void event(const char *name, Clock::time_point start,
+             Clock::time_point end, std::string_view input) {
+    if (trace_)
+      events_.push_back(Event{name, thread_, start, end, std::string{input}});
+  }
+
+  void count_token(TerminalId id) { ++tokens_[static_cast<size_t>(id)]; }
+  void count_rule(uint8_t rule) { ++rules_[rule]; }
+
+  /**
+  \brief Counts a translated input and its size.
+  */
+  void count_input(size_t bytes) {
+    ++inputs_;
+    bytesIn_ += bytes;
+  }
+
+  void count_output(size_t bytes) { bytesOut_ += bytes; }
+
+  /**
+  \brief Notes the nesting of lookbehind assertions of an output, whose width
+  is checked.
+  */
+  void note_check_depth(size_t depth) {
+    if (depth > checkDepth_)
+      checkDepth_ = depth;
+  }
+
+  /**
+  \brief Adds the statistics and the events of another collector, e.g. of a
+  worker thread.
+  */
+  void merge(const Stats &other);
+
+  /**
+  \brief Prints the time of each phase, the counters and the peak resident
+  set size of the process.
+  \param[in] wall Wall time of the whole run.
+  */
+  void report(std::ostream &os, Clock::duration wall) const;
+
+  /**
+  \brief Writes the recorded events in the Chrome trace event format, with
+  times relative to the creation of this collector.
+  */
+  void write_trace(std::ostream &os) const;
+
+ protected:
+  struct Event {
+    const char *name;
+    uint32_t thread;
+    Clock::time_point start;
+    Clock::time_point end;
+    std::string input;
+  };
+
+  bool trace_;
+  uint32_t thread_;
+  Clock::time_point epoch_;
+  Clock::duration time_[phaseCount] = {};
+  size_t tokens_[terminalCount] = {};
+  size_t rules_[ruleCount] = {};
+  size_t inputs_ = 0;
+  size_t bytesIn_ = 0;
+  size_t bytesOut_ = 0;
+  /**
+  \brief Peak nesting of lookbehind assertions.
+  */
+  size_t checkDepth_ = 0;
+  std::vector<Event> events_;
+};
+
+/**
+\brief Returns the peak resident set size of the process in bytes, or 0 if it
+is not known.
+*/
+size_t peak_rss();
+
+}  // namespace reon
+
+#endif
+/*** End of file reon_stats.h ***/
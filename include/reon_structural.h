@@ -0,0 +1,73 @@
+/**
+\file reon_structural.h
+\brief Declares the structural index of reon input.
+\author Radek Vít
+*/
+#ifndef REON_STRUCTURAL
+#define REON_STRUCTURAL
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+\brief Positions of all token starts in the input.
+
+Built in a single pass over 64 byte blocks. Contains the positions of
+structural characters and quotes outside strings, of closing quotes and of the
+first characters of numbers and literals. Characters within strings are never
+indexed.
+*/
+class StructuralIndex {
+ public:
+  /**
+  \brief Largest supported input.
+  */
+  static constexpr size_t maxSize = UINT32_MAX;
+
+  /**
+  \brief Indexes the input.
+  \param[in] data First character of the input.
+  \param[in] size Number of characters, at most maxSize.
+  */
+  void build(const char *data, size_t size);
+
+  /**
+  \brief Returns the positions of token starts and closing quotes.
+  */
+  const std::vector<uint32_t> &positions() const { return positions_; }
+
+  /**
+  \brief Returns the position of the first unescaped control character in a
+  string, or the input size if there is none.
+  */
+  size_t first_control() const { return firstControl_; }
+
+ protected:
+  /**
+  \brief Size of a single block.
+  */
+  static constexpr size_t blockSize = 64;
+
+  /**
+  \brief Character classes of a block; bit i represents character i.
+  */
+  struct Masks {
+    uint64_t quote = 0;
+    uint64_t backslash = 0;
+    uint64_t structural = 0;
+    uint64_t space = 0;
+    uint64_t control = 0;
+  };
+
+  /**
+  \brief Classifies 64 characters.
+  */
+  static Masks classify(const char *block);
+
+  std::vector<uint32_t> positions_;
+  size_t firstControl_ = 0;
+};
+
+#endif
+/*** End of file reon_structural.h ***/
@@ -0,0 +1,255 @@
+/**
+\file reon_translation.h
+\brief Implements the table driven translation of reon.
+\author Radek Vít
+*/
+#ifndef REON_TRANSLATION
+#define REON_TRANSLATION
+
+#include <reon_length.h>
+#include <reon_prefilter.h>
+#include <reon_lexical_analyzer.h>
+#include <reon_output_generator.h>
+#include <reon_passes.h>
+#include <reon_redos.h>
+#include <reon_stats.h>
+#include <reon_translation_grammar.h>
+#include <cstdint>
+#include <memory>
+
+/**
+\brief LL translation of reon driven by the precomputed reon::reonTable.
+
+The lexical analyzer and the output generator are kept between runs.
+*/
+class ReonTranslation {
+ public:
+  ReonTranslation(std::unique_ptr<ReonLexer> lexer,
+                  std::unique_ptr<ReonOutput> output)
+      : lexer_(std::move(lexer)), output_(std::move(output)) {}
+  /**
+  \brief Creates a translation without an output generator, which can only
+  parse.
+  */
+  explicit ReonTranslation(std::unique_ptr<ReonLexer> lexer)
+      : lexer_(std::move(lexer)) {}
+
+  /**
+  \brief Sets the passes rewriting the output symbols of each run.
+  \param[in] passes The passes, must outlive the translation. No passes run
+  if nullptr.
+  */
+  void set_passes(reon::PassManager *passes) { passes_ = passes; }
+
+  /**
+  \brief Sets the checker of catastrophic backtracking run on each pattern
+  before the passes.
+  \param[in] redos The checker, must outlive the translation. No check runs
+  if nullptr.
+  */
+  void set_redos(reon::RedosChecker *redos) { redos_ = redos; }
+
+  /**
+  \brief Sets the collector of the statistics of each run.
+  \param[in] stats The collector, must outlive the translation. Nothing is
+  measured or counted if nullptr.
+  */
+  void set_stats(reon::Stats *stats) { stats_ = stats; }
+
+  /**
+  \brief Computes the bounds of the length of matches of each run and outputs
+  them after the pattern.
+  */
+  void set_lengths(bool lengths) { lengths_ = lengths; }
+
+  /**
+  \brief Returns the bounds of the length of matches of the last run; only
+  computed if set_lengths was set.
+  */
+  const reon::MatchLength &length() const { return length_; }
+
+  /**
+  \brief Extracts the prefilter of each run and outputs it after the pattern.
+  */
+  void set_prefilter(bool prefilter) { prefilters_ = prefilter; }
+
+  /**
+  \brief Returns the prefilter of the last run; only extracted if
+  set_prefilter was set.
+  */
+  const reon::Prefilter &prefilter() const { return prefilter_; }
+
+  /**
+  \brief Translates the input to the output.
+  \param[in] input Input stream.
+  \param[out] output Output stream.
+
+  Throws LexicalError, TranslationError or SemanticError on errors.
+  */
+  void run(std::istream &input, std::ostream &output);
+
+  /**
+  \brief Translates a file to the output. Regular files are memory mapped.
+  \param[in] path Input file.
+  \param[out] output Output stream.
+  */
+  void run_file(const string &path, std::ostream &output);
+  void run_file(const string &path, std::string &output);
+
+  /**
+  \brief Translates a string without going through streams.
+  \param[in] input The input.
+  \param[out] output String the translation is appended to. Output produced
+  before an error is kept.
+  \param[in] source Name of the input for warnings, may be empty.
+  */
+  void run_string(std::string_view input, std::string &output,
+                  std::string_view source = {});
+
+  /**
+  \brief Parses the input without generating output.
+  \param[in] input Input stream.
+  \returns Output symbols of the translation, rewritten by the passes. Valid
+  until the next run; the attributes refer to the input.
+
+  Throws LexicalError or TranslationError on errors. Semantic checks are left
+  to the consumer of the symbols.
+  */
+  const vector<ReonSymbol> &parse(std::istream &input);
+
+  /**
+  \brief Parses a file without generating output.
+  */
+  const vector<ReonSymbol> &parse_file(const string &path);
+
+  /**
+  \brief Parses a string without generating output. The string must outlive
+  the use of the returned symbols.
+  */
+  const vector<ReonSymbol> &parse_string(std::string_view input);
+
+  /**
+  \brief Returns the lexical analyzer; locates errors of the last run.
+  */
+  const ReonLexer &lexer() const { return *lexer_; }
+
+ protected:
+  /**
+  \brief Marks the end of the output list.
+  */
+  static constexpr uint32_t noNode = UINT32_MAX;
+
+  /**
+  \brief A node of the singly linked output list.
+  */
+  struct OutputNode {
+    /**
+    \brief Output symbol or nonterminal waiting for expansion.
+    */
+    reon::RuleSymbol symbol;
+    /**
+    \brief Set when a nonterminal was expanded to nothing.
+    */
+    bool empty;
+    std::string_view attribute;
+    uint32_t next;
+  };
+
+  /**
+  \brief An entry of the LL stack.
+  */
+  struct StackEntry {
+    reon::RuleSymbol symbol;
+    /**
+    \brief Output node of a nonterminal.
+    */
+    uint32_t node;
+    /**
+    \brief Output nodes receiving the attribute of a terminal.
+    */
+    uint32_t targets[reon::Rule::maxActions];
+    uint8_t targetCount;
+  };
+
+  std::unique_ptr<ReonLexer> lexer_;
+  std::unique_ptr<ReonOutput> output_;
+  reon::PassManager *passes_ = nullptr;
+  reon::RedosChecker *redos_ = nullptr;
+  reon::Stats *stats_ = nullptr;
+  bool lengths_ = false;
+  reon::MatchLength length_;
+  bool prefilters_ = false;
+  reon::Prefilter prefilter_;
+  /**
+  \brief AST of the length analysis and the prefilter extraction; separate
+  from ast_, which owns texts of the symbols.
+  */
+  reon::Ast analysisAst_;
+  /**
+  \brief AST of the last run; owns texts created by the passes.
+  */
+  reon::Ast ast_;
+
+  /**
+  \brief Storage of the output list, reused between runs.
+  */
+  vector<OutputNode> nodes_;
+  /**
+  \brief LL stack, reused between runs.
+  */
+  vector<StackEntry> stack_;
+  /**
+  \brief Output symbols passed to the output generator.
+  */
+  vector<ReonSymbol> terminals_;
+
+  /**
+  \brief Translates the input assigned to the lexical analyzer to terminals_.
+  \param[in] source Name of the input for warnings, may be empty.
+  */
+  void translate(std::string_view source = {});
+
+  /**
+  \brief Implements translate; measures the phases and counts tokens and rule
+  expansions if collect is set.
+  */
+  template <bool collect>
+  void translate_input(std::string_view source);
+
+  /**
+  \brief Assigns the input to the lexical analyzer, measured as the read
+  phase.
+  \param[in] source Name of the input for the trace, may be empty.
+  \param[in] set Assigns the input.
+  */
+  template <typename F>
+  void read(std::string_view source, F set);
+
+  /**
+  \brief Replaces a nonterminal on top of the stack with a rule.
+  */
+  void expand(const StackEntry &top, const reon::Rule &rule);
+
+  /**
+  \brief Throws a syntax error for the current token.
+  \param[in] id Terminal id of the unexpected token.
+  \param[in] top Expected symbol.
+  */
+  [[noreturn]] void syntax_error(reon::TerminalId id, const StackEntry &top);
+
+  /**
+  \brief Passes terminals_ to the output generator.
+  \param[in] source Name of the input for the trace, may be empty.
+  */
+  void generate(std::ostream &output, std::string_view source = {});
+  void generate(std::string &output, std::string_view source = {});
+
+  /**
+  \brief Outputs terminals_ to the output already set; measures the output
+  phase if collecting statistics.
+  */
+  void output_symbols(std::string_view source);
+};
+
+#endif
+/*** End of file reon_translation.h ***/
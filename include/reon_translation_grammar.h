@@ -1,14 +1,414 @@
 /**
 \file reon_translation_grammar.h
-\brief Declares reonGrammar.
+\brief Declares reonGrammar and its LL table.
 \author Radek Vít
 */
 #ifndef REON_TRANSLATION_GRAMMAR
 #define REON_TRANSLATION_GRAMMAR
 
-#include <ctf.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <stdexcept>
 
-extern const TranslationGrammar reonGrammar;
+namespace reon {
+
+/**
+\brief Input terminals of reonGrammar.
+*/
+enum class TerminalId : uint8_t {
+  STRING,
+  NUMBER,
+  TRUE_LITERAL,
+  FALSE_LITERAL,
+  NULL_LITERAL,
+  LBRACKET,
+  RBRACKET,
+  LBRACE,
+  RBRACE,
+  COMMA,
+  COLON,
+  REPEAT,
+  NG_REPEAT,
+  SET,
+  NSET,
+  ALTERNATIVES,
+  GROUP,
+  NAMED_GROUP,
+  MATCH_GROUP,
+  COMMENT,
+  LOOKAHEAD,
+  NLOOKAHEAD,
+  LOOKBEHIND,
+  NLOOKBEHIND,
+  IF,
+  THEN,
+  ELSE,
+  EOI,
+  COUNT
+};
+
+/**
+\brief Names of input terminals, indexed by TerminalId.
+*/
+constexpr const char *terminalNames[] = {
+    "string",     "number",      "true",       "false",
+    "null",       "[",           "]",          "{",
+    "}",          ",",           ":",          "repeat",
+    "non-greedy repeat",         "set",        "!set",
+    "alternatives",              "group",      "named group",
+    "match group",               "comment",    "lookahead",
+    "!lookahead", "lookbehind",  "!lookbehind", "if",
+    "then",       "else",        "EOF",
+};
+
+/**
+\brief Nonterminals of reonGrammar.
+*/
+enum class NonterminalId : uint8_t {
+  E,
+  RE,
+  REFULL,
+  OBJ,
+  REF,
+  IF_REF,
+  ELSE,
+  RE_LIST_E,
+  RE_LIST,
+  RE_LIST_COMMA,
+  RE_ALIST_E,
+  RE_ALIST,
+  RE_ALIST_COMMA,
+  COUNT
+};
+
+/**
+\brief Names of nonterminals, indexed by NonterminalId.
+*/
+constexpr const char *nonterminalNames[] = {
+    "E",        "RE",      "REFULL",        "OBJ",       "Ref",
+    "IfRef",    "Else",    "RE-listE",      "RE-list",   "RE-list-comma",
+    "RE-AlistE", "RE-Alist", "RE-Alist-comma",
+};
+
+/**
+\brief Output symbols of reonGrammar.
+
+Symbols up to NAMED_GROUP are terminals with special meaning, symbols from
+GROUP to VARIABLE are special symbols and the remaining symbols are output as
+their names.
+*/
+enum class OutputId : uint8_t {
+  RE,
+  SET,
+  REF,
+  NREF,
+  COMMENT,
+  REPEAT,
+  NAMED_GROUP,
+  GROUP,
+  FIXED_LENGTH_CHECK,
+  END_CHECK,
+  VARIABLE,
+  ASSIGNMENT,
+  END,
+  NEVER,
+  NC_GROUP_OPEN,
+  GROUP_CLOSE,
+  NON_GREEDY,
+  SET_OPEN,
+  SET_CLOSE,
+  NSET_OPEN,
+  GROUP_OPEN,
+  NAMED_GROUP_OPEN,
+  NAMED_GROUP_NAME_END,
+  COMMENT_OPEN,
+  LOOKAHEAD_OPEN,
+  NLOOKAHEAD_OPEN,
+  LOOKBEHIND_OPEN,
+  NLOOKBEHIND_OPEN,
+  CONDITION_OPEN,
+  ALTERNATIVE,
+  BACKSLASH,
+  REF_OPEN,
+  COUNT
+};
+
+/**
+\brief Names of output symbols, indexed by OutputId.
+*/
+constexpr const char *outputNames[] = {
+    "re",         "set",        "ref",    "nref",
+    "comment",    "repeat",     "named group",
+    "group",      "fixed_length_check", "end_check",
+    "variable",   " = r\"(?s)", "\"\n",   "(?!)",
+    "(?:",        ")",          "?",      "[",
+    "]",          "[^",         "(",      "(?P<",
+    ">",          "(?#",        "(?=",    "(?!",
+    "(?<=",       "(?<!",       "(?(",    "|",
+    "\\",         "(?P=",
+};
+
+static_assert(sizeof(terminalNames) / sizeof(*terminalNames) ==
+                  static_cast<size_t>(TerminalId::COUNT),
+              "Every terminal must have a name.");
+static_assert(sizeof(nonterminalNames) / sizeof(*nonterminalNames) ==
+                  static_cast<size_t>(NonterminalId::COUNT),
+              "Every nonterminal must have a name.");
+static_assert(sizeof(outputNames) / sizeof(*outputNames) ==
+                  static_cast<size_t>(OutputId::COUNT),
+              "Every output symbol must have a name.");
+
+/**
+\brief Number of input terminals.
+*/
+constexpr size_t terminalCount = static_cast<size_t>(TerminalId::COUNT);
+/**
+\brief Number of nonterminals.
+*/
+constexpr size_t nonterminalCount = static_cast<size_t>(NonterminalId::COUNT);
+
+/**
+\brief Compares a null-terminated name to a string of given length.
+*/
+constexpr bool name_equals(const char *name, const char *s, size_t length) {
+  for (size_t i = 0; i < length; ++i) {
+    if (name[i] != s[i])
+      return false;
+  }
+  return name[length] == '\0';
+}
+
+/**
+\brief Finds the index of a name in a table of names.
+\returns Index of the name. Fails to compile in a constant expression if the
+name is not in the table.
+*/
+template <size_t N>
+constexpr uint8_t name_index(const char *const (&names)[N], const char *s,
+                             size_t length) {
+  for (size_t i = 0; i < N; ++i) {
+    if (name_equals(names[i], s, length))
+      return static_cast<uint8_t>(i);
+  }
+  throw std::logic_error("Unknown grammar symbol.");
+}
+
+namespace grammar {
+
+/**
+\brief Kind of a symbol in a rule definition.
+*/
+enum class Kind : uint8_t { TERMINAL, NONTERMINAL, SPECIAL };
+
+/**
+\brief A symbol of a translation rule, referenced by name.
+*/
+struct NamedSymbol {
+  Kind kind;
+  const char *name;
+  size_t length;
+};
+
+constexpr NamedSymbol operator""_t(const char *s, size_t length) {
+  return {Kind::TERMINAL, s, length};
+}
+constexpr NamedSymbol operator""_nt(const char *s, size_t length) {
+  return {Kind::NONTERMINAL, s, length};
+}
+constexpr NamedSymbol operator""_s(const char *s, size_t length) {
+  return {Kind::SPECIAL, s, length};
+}
+
+}  // namespace grammar
+
+/**
+\brief A resolved symbol of a translation rule.
+
+id is a TerminalId or an OutputId for terminals, depending on the side of the
+rule, and a NonterminalId for nonterminals.
+*/
+struct RuleSymbol {
+  bool nonterminal = false;
+  uint8_t id = 0;
+};
+
+/**
+\brief Translation rule with a fixed maximal length of both sides.
+*/
+struct Rule {
+  /**
+  \brief Maximal number of symbols on either side of a rule.
+  */
+  static constexpr size_t maxSymbols = 8;
+  /**
+  \brief Maximal number of attribute targets of a rule.
+  */
+  static constexpr size_t maxActions = 4;
+  /**
+  \brief Attribute action; copies the attribute of an input terminal to an
+  output symbol.
+  */
+  struct Action {
+    uint8_t terminal = 0;
+    uint8_t target = 0;
+  };
+
+  NonterminalId nonterminal = NonterminalId::E;
+  RuleSymbol input[maxSymbols] = {};
+  uint8_t inputSize = 0;
+  RuleSymbol output[maxSymbols] = {};
+  uint8_t outputSize = 0;
+  /**
+  \brief Attribute actions; terminal is the index among input terminals,
+  target is the index in output.
+  */
+  Action actions[maxActions] = {};
+  uint8_t actionsSize = 0;
+
+  /**
+  \brief Constructs a rule in the same notation as ctf's translation rules.
+  \param[in] nt Left side nonterminal.
+  \param[in] in Input side of the rule.
+  \param[in] out Output side of the rule. Only nonterminals are copied from
+  the input side if omitted.
+  \param[in] targets For each input terminal, the output positions its
+  attribute is copied to.
+  */
+  constexpr Rule(grammar::NamedSymbol nt,
+                 std::initializer_list<grammar::NamedSymbol> in,
+                 std::initializer_list<grammar::NamedSymbol> out,
+                 std::initializer_list<std::initializer_list<uint8_t>> targets)
+      : Rule(nt, in, out, targets, false) {}
+  constexpr Rule(grammar::NamedSymbol nt,
+                 std::initializer_list<grammar::NamedSymbol> in,
+                 std::initializer_list<grammar::NamedSymbol> out)
+      : Rule(nt, in, out, {}, false) {}
+  constexpr Rule(grammar::NamedSymbol nt,
+                 std::initializer_list<grammar::NamedSymbol> in)
+      : Rule(nt, in, {}, {}, true) {}
+
+ private:
+  constexpr Rule(grammar::NamedSymbol nt,
+                 std::initializer_list<grammar::NamedSymbol> in,
+                 std::initializer_list<grammar::NamedSymbol> out,
+                 std::initializer_list<std::initializer_list<uint8_t>> targets,
+                 bool copyNonterminals)
+      : nonterminal(static_cast<NonterminalId>(
+            name_index(nonterminalNames, nt.name, nt.length))) {
+    if (in.size() > maxSymbols || out.size() > maxSymbols)
+      throw std::logic_error("Rule too long.");
+    for (auto &s : in) {
+      input[inputSize++] = resolve_input(s);
+    }
+    for (auto &s : out) {
+      output[outputSize++] = resolve_output(s);
+    }
+    if (copyNonterminals) {
+      for (uint8_t i = 0; i < inputSize; ++i) {
+        if (input[i].nonterminal)
+          output[outputSize++] = input[i];
+      }
+    }
+    uint8_t terminal = 0;
+    for (auto &t : targets) {
+      for (uint8_t target : t) {
+        if (actionsSize == maxActions || target >= outputSize ||
+            output[target].nonterminal)
+          throw std::logic_error("Invalid attribute target.");
+        actions[actionsSize++] = Action{terminal, target};
+      }
+      ++terminal;
+    }
+    // nonterminals must appear in the same order on both sides
+    uint8_t o = 0;
+    for (uint8_t i = 0; i < inputSize; ++i) {
+      if (!input[i].nonterminal)
+        continue;
+      while (o < outputSize && !output[o].nonterminal)
+        ++o;
+      if (o == outputSize || output[o].id != input[i].id)
+        throw std::logic_error("Mismatched nonterminals in a rule.");
+      ++o;
+    }
+    while (o < outputSize) {
+      if (output[o++].nonterminal)
+        throw std::logic_error("Mismatched nonterminals in a rule.");
+    }
+  }
+
+  static constexpr RuleSymbol resolve_input(grammar::NamedSymbol s) {
+    switch (s.kind) {
+      case grammar::Kind::NONTERMINAL:
+        return {true, name_index(nonterminalNames, s.name, s.length)};
+      case grammar::Kind::TERMINAL:
+        return {false, name_index(terminalNames, s.name, s.length)};
+      default:
+        throw std::logic_error("Special symbol on the input side.");
+    }
+  }
+  static constexpr RuleSymbol resolve_output(grammar::NamedSymbol s) {
+    switch (s.kind) {
+      case grammar::Kind::NONTERMINAL:
+        return {true, name_index(nonterminalNames, s.name, s.length)};
+      default: {
+        uint8_t id = name_index(outputNames, s.name, s.length);
+        bool special = id >= static_cast<uint8_t>(OutputId::GROUP) &&
+                       id <= static_cast<uint8_t>(OutputId::VARIABLE);
+        if (special != (s.kind == grammar::Kind::SPECIAL))
+          throw std::logic_error("Special symbol used as a terminal.");
+        return {false, id};
+      }
+    }
+  }
+};
+
+/**
+\brief Number of rules in reonGrammar.
+*/
+constexpr size_t ruleCount = 41;
+
+/**
+\brief Predictive LL(1) table for reonGrammar.
+*/
+struct LLTable {
+  /**
+  \brief Marks a missing table entry.
+  */
+  static constexpr uint8_t noRule = 0xFF;
+  /**
+  \brief Rule index for each nonterminal and lookahead terminal.
+  */
+  uint8_t rules[nonterminalCount][terminalCount] = {};
+  /**
+  \brief Number of conflicting entries; the grammar is LL(1) if zero.
+  */
+  size_t conflicts = 0;
+
+  /**
+  \brief Returns the rule index for a nonterminal and a lookahead terminal.
+  */
+  constexpr uint8_t rule(NonterminalId nt, TerminalId t) const {
+    return rules[static_cast<size_t>(nt)][static_cast<size_t>(t)];
+  }
+};
+
+/**
+\brief Defines the translation from reon to Python 3 RE.
+*/
+extern const Rule reonGrammar[ruleCount];
+
+/**
+\brief The predictive table of reonGrammar, computed during compilation.
+*/
+extern const LLTable reonTable;
+
+/**
+\brief The starting nonterminal of reonGrammar.
+*/
+constexpr NonterminalId reonStart = NonterminalId::E;
+
+}  // namespace reon
 
 #endif
-/*** End of file reon_translation_grammar.h ***/
\ No newline at end of file
+/*** End of file reon_translation_grammar.h ***/
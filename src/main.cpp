@@ -1,10 +1,23 @@
-#include <reon_lexical_analyzer.h>
-#include <reon_output_generator.h>
-#include <reon_translation_grammar.h>
+#include <reon.h>
+#include <reon_batch.h>
+#include <reon_cache.h>
+#include <reon_cpp_output.h>
+#include <reon_input.h>
+#include <reon_parallel.h>
+#include <reon_regex.h>
+#include <reon_server.h>
+#include <reon_stats.h>
+#include <reon_translation.h>
+#include <algorithm>
+#include <cstring>
 #include <exception>
+#include <filesystem>
 #include <fstream>
 #include <functional>
 #include <iostream>
+#include <optional>
+#include <thread>
+#include <unordered_map>
 
 // using declarations
 using std::cin;
@@ -12,82 +25,531 @@ using std::cout;
 using std::cerr;
 
 // error codes
+using reon::INVALID_ARGUMENT;
+using reon::LEXICAL_ERROR;
+using reon::RUNTIME_ERROR;
+using reon::SEMANTIC_ERROR;
+using reon::SYNTAX_ERROR;
+using reon::TRANSLATION_ENGINE_ERROR;
+using reon::UNKNOWN_EXCEPTION;
+
+void print_help();
+
 /**
-Runtime error return value.
- */
-const int RUNTIME_ERROR = 1;
+\brief Settings shared by the translations of all modes.
+*/
+struct Settings {
+  /**
+  \brief Name of the assigned Python variable, namespace of C++ matchers.
+  */
+  string variable = "re";
+  reon::PassManager passes;
+  /**
+  \brief Checker of catastrophic backtracking, empty if not requested.
+  */
+  std::optional<reon::RedosChecker> redos;
+  /**
+  \brief Cache of translations, empty if not requested.
+  */
+  std::optional<reon::Cache> cache;
+  /**
+  \brief Statistics of the translations, empty if not requested.
+  */
+  std::optional<reon::Stats> stats;
+  /**
+  \brief Outputs the bounds of the length of matches after each pattern.
+  */
+  bool lengths = false;
+  /**
+  \brief Outputs the prefilter after each pattern.
+  */
+  bool prefilter = false;
+
+  /**
+  \brief Applies the settings to a translation.
+  */
+  void apply(ReonTranslation &t) {
+    t.set_passes(&passes);
+    t.set_redos(redos ? &*redos : nullptr);
+    t.set_stats(stats ? &*stats : nullptr);
+    t.set_lengths(lengths);
+    t.set_prefilter(prefilter);
+  }
+
+  /**
+  \brief Returns the settings that change the output of a translation, for
+  cache keys.
+  */
+  string cache_options(ReonOutput::Target target) const {
+    string options = target == ReonOutput::Target::RE2 ? "re2" : "python";
+    options += '\0' + variable + '\0';
+    for (size_t i = 0; i < reon::passCount; ++i) {
+      options += passes.enabled(i) ? '1' : '0';
+    }
+    // strict checks fail instead of translating
+    options += redos ? (redos->strict() ? 's' : 'w') : '-';
+    options += lengths ? 'l' : '-';
+    options += prefilter ? 'p' : '-';
+    return options;
+  }
+
+  /**
+  \brief Returns the settings as options of the reon library.
+  */
+  reon::Options library_options(ReonOutput::Target target) const {
+    reon::Options options;
+    options.target = target == ReonOutput::Target::RE2 ? reon::Target::RE2
+                                                       : reon::Target::PYTHON;
+    options.variable = variable;
+    for (size_t i = 0; i < reon::passCount; ++i) {
+      if (!passes.enabled(i))
+        options.disabledPasses.push_back(reon::passes[i].name);
+    }
+    options.redos = redos.has_value();
+    options.redosStrict = redos && redos->strict();
+    options.lengths = lengths;
+    options.prefilter = prefilter;
+    return options;
+  }
+};
+
 /**
-Invalid argument was passed to the application or some function return value.
- */
-const int INVALID_ARGUMENT = 2;
+\brief Translates an input through a cache.
+\param[in] t The translation.
+\param[in] inputPath Input file. Reads from cin if empty.
+\param[out] output Receives the translation, or the output produced before
+an error.
+\param[in] cache The cache.
+\param[in] options Settings::cache_options of the translation.
+\param[in] redos Checker of the translation, may be nullptr.
+
+Only translations without warnings are stored, so that hits have none to
+report.
+*/
+void cached_translation(ReonTranslation &t, const string &inputPath,
+                        string &output, reon::Cache &cache,
+                        const string &options,
+                        const reon::RedosChecker *redos) {
+  InputBuffer input;
+  if (inputPath.empty())
+    input.read_stream(cin);
+  else
+    input.open_file(inputPath);
+  std::string_view contents{input.data(), input.size()};
+  auto key = reon::Cache::key(contents, options);
+  if (cache.load(key, output))
+    return;
+  t.run_string(contents, output, inputPath);
+  if (!redos || redos->warnings().empty())
+    cache.store(key, output);
+}
+
 /**
-An unspecified error within ctf return value.
+\brief Translates a single input.
+\param[in] inputPath Input file. Reads from cin if empty.
+\param[out] output Output stream.
+\param[in] target Syntax of the output.
+\param[in] settings Passes and checks of the pattern.
 */
-const int TRANSLATION_ENGINE_ERROR = 3;
+void translation(const string &inputPath, std::ostream &output,
+                 ReonOutput::Target target, Settings &settings) {
+  // reon translation unit, LL table driven translation
+  ReonTranslation t{std::make_unique<ReonLexer>(),
+                    std::make_unique<ReonOutput>(target, settings.variable)};
+  settings.apply(t);
+  if (settings.cache) {
+    string translated;
+    try {
+      cached_translation(t, inputPath, translated, *settings.cache,
+                         settings.cache_options(target),
+                         settings.redos ? &*settings.redos : nullptr);
+    } catch (...) {
+      output << translated;
+      throw;
+    }
+    output << translated;
+    return;
+  }
+  if (inputPath.empty())
+    t.run(cin, output);
+  else
+    t.run_file(inputPath, output);
+}
+
 /**
-Lexical analysis error return value.
+\brief Generates a C++ header with matchers of the pattern.
+\param[in] inputPath Input file. Reads from cin if empty.
+\param[out] output Output stream.
+\param[in] settings Passes and checks of the pattern.
 */
-const int LEXICAL_ERROR = 5;
+void cpp_generation(const string &inputPath, std::ostream &output,
+                    Settings &settings) {
+  ReonTranslation t{std::make_unique<ReonLexer>()};
+  settings.apply(t);
+  reon::Program program = reon::compile(
+      inputPath.empty() ? t.parse(cin) : t.parse_file(inputPath));
+  reon::generate_cpp(program, settings.variable, output,
+                     settings.prefilter ? &t.prefilter() : nullptr);
+}
+
 /**
-A syntax error return value.
+\brief Searches a subject with the native matching engine. Prints the groups
+of the match, one "group: begin-end text" line per group.
+\param[in] inputPath Input file. Reads from cin if empty.
+\param[in] subject Searched text.
+\param[out] output Output stream.
+\param[in] settings Passes and checks of the pattern.
 */
-const int SYNTAX_ERROR = 6;
+void native_search(const string &inputPath, const string &subject,
+                   std::ostream &output, Settings &settings) {
+  ReonTranslation t{std::make_unique<ReonLexer>()};
+  settings.apply(t);
+  reon::Regex regex{inputPath.empty() ? t.parse(cin)
+                                      : t.parse_file(inputPath)};
+  reon::Match match;
+  if (!regex.search(subject, &match)) {
+    output << "no match\n";
+    return;
+  }
+  for (size_t g = 0; g < match.size(); ++g) {
+    output << g << ": ";
+    if (match.matched(g))
+      output << match.begin(g) << "-" << match.end(g) << " " << match.group(g);
+    else
+      output << "-";
+    output << "\n";
+  }
+}
+
 /**
-A semantic error return value.
- */
-const int SEMANTIC_ERROR = 7;
+\brief Prints the lines of a file that contain a match of the pattern.
+\param[in] inputPath Input file. Reads from cin if empty.
+\param[in] linesPath The searched file.
+\param[out] output Output stream.
+\param[in] settings Passes and checks of the pattern.
+*/
+void native_grep(const string &inputPath, const string &linesPath,
+                 std::ostream &output, Settings &settings) {
+  ReonTranslation t{std::make_unique<ReonLexer>()};
+  settings.apply(t);
+  reon::Regex regex{inputPath.empty() ? t.parse(cin)
+                                      : t.parse_file(inputPath)};
+  InputBuffer lines;
+  lines.open_file(linesPath);
+  const char *begin = lines.data();
+  const char *end = begin + lines.size();
+  const reon::Prefilter &prefilter = regex.prefilter();
+  while (begin != end) {
+    if (!prefilter.required.empty()) {
+      // lines before the next occurrence of a required literal cannot match
+      std::string_view rest{begin, static_cast<size_t>(end - begin)};
+      size_t hit = rest.find(prefilter.required.front());
+      if (hit == std::string_view::npos)
+        break;
+      size_t newline = rest.rfind('\n', hit);
+      if (newline != std::string_view::npos)
+        begin += newline + 1;
+    }
+    auto newline = static_cast<const char *>(memchr(begin, '\n', end - begin));
+    const char *lineEnd = newline ? newline : end;
+    std::string_view line{begin, static_cast<size_t>(lineEnd - begin)};
+    if (regex.search(line))
+      output << line << "\n";
+    begin = newline ? newline + 1 : end;
+  }
+}
+
 /**
-Unknown error return value.
- */
-const int UNKNOWN_EXCEPTION = 666;
+\brief Translation pipeline of a batch worker.
+*/
+struct BatchWorker {
+  /**
+  \param[in] thread Index of the worker, the thread of its trace events.
+  */
+  BatchWorker(ReonOutput::Target target, const Settings &settings,
+              uint32_t thread = 0)
+      : t{std::make_unique<ReonLexer>(),
+          std::make_unique<ReonOutput>(target, settings.variable)},
+        passes(settings.passes) {
+    // warnings are collected and printed in the order of the jobs
+    if (settings.redos)
+      redos.emplace(settings.redos->strict());
+    if (settings.stats)
+      stats.emplace(settings.stats->tracing(), thread);
+    t.set_passes(&passes);
+    t.set_redos(redos ? &*redos : nullptr);
+    t.set_stats(stats ? &*stats : nullptr);
+    t.set_lengths(settings.lengths);
+    t.set_prefilter(settings.prefilter);
+  }
+  BatchWorker(const BatchWorker &) = delete;
+  BatchWorker &operator=(const BatchWorker &) = delete;
 
-namespace globals {
-string varname = "re";
-}  // namespace globals
+  ReonTranslation t;
+  reon::PassManager passes;
+  std::optional<reon::RedosChecker> redos;
+  std::optional<reon::Stats> stats;
 
-void print_help();
+  /**
+  \brief Adds the measurements of the worker to the settings.
+  */
+  void merge_into(Settings &settings) const {
+    settings.passes.merge(passes);
+    if (stats)
+      settings.stats->merge(*stats);
+  }
+};
 
-void translation(std::istream &input, std::ostream &output) {
-  // reon translation unit, LL table driven translation
-  Translation t{std::make_unique<ReonLexer>(), "ll", reonGrammar, std::make_unique<ReonOutput>()};
-  t.run(input, output);
-}
+/**
+\brief Outcome of a batch job.
+*/
+struct BatchResult {
+  /**
+  \brief Translation for the combined output. Empty if written to a file.
+  */
+  string output;
+  std::vector<reon::RedosWarning> warnings;
+  std::exception_ptr error;
+};
 
-void run_with_arguments(int argc, char **argv);
+/**
+\brief Translates all batch jobs with one translation unit per thread.
+\param[in] jobs Inputs to translate.
+\param[out] combined Output for jobs without their own output.
+\param[in] directory Output directory for jobs without their own output. If
+empty, combined is used instead.
+\param[in] target Syntax of the outputs.
+\param[in] settings Passes and checks of the patterns.
+\param[in] threads Number of threads translating the jobs.
+\returns 0 if all jobs succeeded, the error code of the first failed job
+otherwise.
+
+A failed job is reported and does not stop the translation of other jobs.
+A job whose output file is the output file of an earlier job fails.
+Outputs, warnings and errors are reported in the order of the jobs
+regardless of the threads.
+*/
+int translation_batch(const std::vector<BatchJob> &jobs,
+                      std::ostream &combined, const string &directory,
+                      ReonOutput::Target target, Settings &settings,
+                      size_t threads);
+
+/**
+\brief Reports an exception to cerr.
+\param[in] e Exception to report.
+\param[in] source Name of the translated input. May be empty.
+\returns The error code appropriate for the exception.
+*/
+int report_exception(std::exception_ptr e, const string &source);
+
+int run_with_arguments(int argc, char **argv);
 
 // main
 int main(int argc, char **argv) {
   try {
-    run_with_arguments(argc, argv);
+    return run_with_arguments(argc, argv);
+  } catch (...) {
+    return report_exception(std::current_exception(), "");
+  }
+}
+
+int report_exception(std::exception_ptr e, const string &source) {
+  string prefix = source.empty() ? "\n" : "\n" + source + ": ";
+  try {
+    std::rethrow_exception(e);
+  } catch (LexicalError &le) {
+    cerr << prefix << "Translation error:\n" << le.what();
+    return LEXICAL_ERROR;
   } catch (TranslationError &le) {
-    cerr << "\nTranslation error:\n" << le.what();
+    cerr << prefix << "Translation error:\n" << le.what();
     return SYNTAX_ERROR;
   } catch (SemanticError &se) {
-    cerr << "\nSemantic Error: " << se.what() << "\n";
+    cerr << prefix << "Semantic Error: " << se.what() << "\n";
     return SEMANTIC_ERROR;
   } catch (TranslationException &te) {
-    cerr << "\nTranslation Error: " << te.what() << "\n";
+    cerr << prefix << "Translation Error: " << te.what() << "\n";
     return TRANSLATION_ENGINE_ERROR;
   } catch (std::invalid_argument &ia) {
-    cerr << "\nInvalid argument: " << ia.what() << "\n";
+    cerr << prefix << "Invalid argument: " << ia.what() << "\n";
     return INVALID_ARGUMENT;
   } catch (std::exception &e) {
-    cerr << "\nRuntime Error: " << e.what() << "\n";
+    cerr << prefix << "Runtime Error: " << e.what() << "\n";
     return RUNTIME_ERROR;
   } catch (...) {
-    cerr << "\nAn unknown exception was thrown.\n";
+    cerr << prefix << "An unknown exception was thrown.\n";
     return UNKNOWN_EXCEPTION;
   }
-  return 0;
 }
 
-void run_with_arguments(int argc, char **argv) {
-  std::ifstream fileIn;
+int translation_batch(const std::vector<BatchJob> &jobs,
+                      std::ostream &combined, const string &directory,
+                      ReonOutput::Target target, Settings &settings,
+                      size_t threads) {
+  string extension = target == ReonOutput::Target::RE2 ? ".re2" : ".py";
+  string cacheOptions = settings.cache ? settings.cache_options(target) : "";
+  // a job writing the output file of an earlier job fails instead
+  std::vector<string> outputPaths(jobs.size());
+  std::vector<size_t> overwritten(jobs.size(), jobs.size());
+  std::unordered_map<string, size_t> writers;
+  for (size_t j = 0; j < jobs.size(); ++j) {
+    string &path = outputPaths[j];
+    path = jobs[j].output;
+    if (path.empty() && !directory.empty())
+      path = output_in_directory(directory, jobs[j].input, extension);
+    if (path.empty())
+      continue;
+    auto written = writers.emplace(
+        std::filesystem::path(path).lexically_normal().string(), j);
+    if (!written.second)
+      overwritten[j] = written.first->second;
+  }
+  auto translate = [&](BatchWorker &w, size_t j) {
+    const BatchJob &job = jobs[j];
+    BatchResult result;
+    if (w.redos)
+      w.redos->clear();
+    auto start = reon::Stats::Clock::now();
+    try {
+      if (overwritten[j] != jobs.size()) {
+        throw std::invalid_argument("Output file " + outputPaths[j] +
+                                    " is also the output of " +
+                                    jobs[overwritten[j]].input + ".");
+      }
+      // failed translations must not leave partial output
+      string translated;
+      if (settings.cache) {
+        cached_translation(w.t, job.input, translated, *settings.cache,
+                           cacheOptions, w.redos ? &*w.redos : nullptr);
+      } else {
+        w.t.run_file(job.input, translated);
+      }
+
+      const string &outputPath = outputPaths[j];
+      if (outputPath.empty()) {
+        result.output = std::move(translated);
+      } else {
+        std::ofstream fileOut{outputPath};
+        if (fileOut.fail()) {
+          throw std::invalid_argument("Could not open file " + outputPath +
+                                      " for output.");
+        }
+        fileOut << translated;
+      }
+    } catch (...) {
+      result.error = std::current_exception();
+    }
+    if (w.stats)
+      w.stats->event("input", start, reon::Stats::Clock::now(), job.input);
+    // strict checks report their issue as the error
+    if (w.redos && !w.redos->strict())
+      result.warnings = w.redos->warnings();
+    return result;
+  };
+
+  int code = 0;
+  auto report = [&](const BatchJob &job, const BatchResult &result) {
+    for (auto &warning : result.warnings) {
+      reon::RedosChecker::print(cerr, warning, job.input);
+    }
+    if (!result.error) {
+      combined << result.output;
+      return;
+    }
+    int error = report_exception(result.error, job.input);
+    if (code == 0)
+      code = error;
+  };
+
+  if (threads <= 1 || jobs.size() <= 1) {
+    // one translation unit for all inputs, reported as they finish
+    BatchWorker worker{target, settings};
+    for (size_t j = 0; j < jobs.size(); ++j) {
+      report(jobs[j], translate(worker, j));
+    }
+    worker.merge_into(settings);
+    return code;
+  }
+
+  std::vector<std::unique_ptr<BatchWorker>> workers;
+  for (size_t w = 0; w < threads; ++w) {
+    workers.push_back(std::make_unique<BatchWorker>(
+        target, settings, static_cast<uint32_t>(w)));
+  }
+  std::vector<BatchResult> results(jobs.size());
+  reon::parallel_for(jobs.size(), threads, [&](size_t w, size_t j) {
+    results[j] = translate(*workers[w], j);
+  });
+  for (size_t j = 0; j < jobs.size(); ++j) {
+    report(jobs[j], results[j]);
+  }
+  for (auto &worker : workers) {
+    worker->merge_into(settings);
+  }
+  return code;
+}
+
+/**
+\brief Runs the translation or the search selected by the arguments.
+*/
+int run(int argc, char **argv, Settings &settings);
+
+int run_with_arguments(int argc, char **argv) {
+  auto start = reon::Stats::Clock::now();
+  Settings settings;
+  bool timePasses = false;
+  bool cacheStats = false;
+  bool printStats = false;
+  string tracePath;
+  for (int i = 1; i < argc; i++) {
+    if (string{argv[i]} == "--time-passes")
+      timePasses = true;
+    else if (string{argv[i]} == "--cache-stats")
+      cacheStats = true;
+    else if (string{argv[i]} == "--stats")
+      printStats = true;
+    else if (string{argv[i]} == "--trace" && i + 1 < argc)
+      tracePath = argv[++i];
+  }
+  std::ofstream traceOut;
+  if (!tracePath.empty()) {
+    traceOut.open(tracePath);
+    if (traceOut.fail()) {
+      throw std::invalid_argument("Could not open file " + tracePath +
+                                  " for the trace.");
+    }
+  }
+  if (printStats || !tracePath.empty())
+    settings.stats.emplace(!tracePath.empty());
+  int result = run(argc, argv, settings);
+  if (timePasses)
+    settings.passes.report(cerr);
+  if (cacheStats && settings.cache)
+    settings.cache->report(cerr);
+  if (printStats)
+    settings.stats->report(cerr, reon::Stats::Clock::now() - start);
+  if (!tracePath.empty())
+    settings.stats->write_trace(traceOut);
+  return result;
+}
+
+int run(int argc, char **argv, Settings &settings) {
   std::ofstream fileOut;
 
-  std::istream *input = &cin;
+  string inputPath;
   std::ostream *output = &cout;
 
+  std::vector<BatchJob> jobs;
+  string directory;
+  string subject;
+  string linesPath;
+  string target = "python";
+  bool search = false;
+  bool batch = false;
+  bool ndjson = false;
+  string socketPath;
+  size_t threads = 1;
+  bool threadsDefined = false;
+
   bool inputDefined = false;
   bool outputDefined = false;
   bool varDefined = false;
@@ -101,12 +563,10 @@ void run_with_arguments(int argc, char **argv) {
       if (++i == argc) {
         throw std::invalid_argument("No input file given after -i.");
       }
-      fileIn.open(argv[i]);
-      if (fileIn.fail()) {
-        throw std::invalid_argument("Could not open file " +
-                                    std::string{argv[i]} + " for input.");
+      inputPath = argv[i];
+      if (inputPath.empty()) {
+        throw std::invalid_argument("No input file given after -i.");
       }
-      input = &fileIn;
     } else if (arg == "-o") {
       if (outputDefined) {
         throw std::invalid_argument("Multiple output definitions.");
@@ -121,6 +581,45 @@ void run_with_arguments(int argc, char **argv) {
                                     std::string{argv[i]} + " for output.");
       }
       output = &fileOut;
+    } else if (arg == "-d") {
+      if (!directory.empty()) {
+        throw std::invalid_argument("Multiple output directory definitions.");
+      }
+      if (++i == argc || argv[i][0] == '\0') {
+        throw std::invalid_argument("No output directory given after -d.");
+      }
+      directory = argv[i];
+    } else if (arg == "-m") {
+      if (++i == argc) {
+        throw std::invalid_argument("No manifest file given after -m.");
+      }
+      std::ifstream manifest{argv[i]};
+      if (manifest.fail()) {
+        throw std::invalid_argument("Could not open manifest " +
+                                    std::string{argv[i]} + ".");
+      }
+      auto manifestJobs = read_manifest(manifest, argv[i]);
+      jobs.insert(jobs.end(), manifestJobs.begin(), manifestJobs.end());
+      batch = true;
+    } else if (arg == "-j") {
+      if (threadsDefined) {
+        throw std::invalid_argument("Multiple thread count definitions.");
+      }
+      threadsDefined = true;
+      if (++i == argc) {
+        throw std::invalid_argument("No thread count given after -j.");
+      }
+      string count{argv[i]};
+      if (count.empty() || count.size() > 4 ||
+          count.find_first_not_of("0123456789") != string::npos) {
+        throw std::invalid_argument("Invalid thread count " + count + ".");
+      }
+      threads = std::stoul(count);
+      if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    } else if (arg == "--ndjson") {
+      ndjson = true;
+      batch = true;
     } else if (arg == "-v") {
       if (varDefined) {
         throw std::invalid_argument("Multiple variable name definitions.");
@@ -129,36 +628,224 @@ void run_with_arguments(int argc, char **argv) {
       if (++i == argc) {
         throw std::invalid_argument("No variable name given after -v.");
       }
-      globals::varname = string(argv[i]);
-      if (globals::varname.size() == 0) {
+      settings.variable = string(argv[i]);
+      if (settings.variable.size() == 0) {
         throw std::invalid_argument(
             "Variable name must be at least 1 character long.");
       }
-      for (char c : globals::varname) {
-        if (!std::isalpha(c)) {
-          throw std::invalid_argument(
-              "Variable name must contain only alphabetical characters.");
-        }
+      if (!reon::valid_variable(settings.variable)) {
+        throw std::invalid_argument(
+            "Variable name must contain only alphabetical characters.");
+      }
+    } else if (arg == "-t") {
+      if (++i == argc) {
+        throw std::invalid_argument("No target given after -t.");
+      }
+      target = argv[i];
+      if (target != "python" && target != "re2" && target != "cpp") {
+        throw std::invalid_argument("Unknown target " + target + ".");
+      }
+    } else if (arg == "-s") {
+      if (search) {
+        throw std::invalid_argument("Multiple subject definitions.");
+      }
+      search = true;
+      if (++i == argc) {
+        throw std::invalid_argument("No subject given after -s.");
+      }
+      subject = argv[i];
+    } else if (arg == "-g") {
+      if (search) {
+        throw std::invalid_argument("Multiple subject definitions.");
+      }
+      search = true;
+      if (++i == argc || argv[i][0] == '\0') {
+        throw std::invalid_argument("No file given after -g.");
+      }
+      linesPath = argv[i];
+    } else if (arg == "--enable-pass" || arg == "--disable-pass") {
+      if (++i == argc) {
+        throw std::invalid_argument("No pass given after " + arg + ".");
+      }
+      bool enable = arg == "--enable-pass";
+      if (string{argv[i]} == "all")
+        settings.passes.enable_all(enable);
+      else
+        settings.passes.enable(argv[i], enable);
+    } else if (arg == "--redos" || arg == "--redos-strict") {
+      settings.redos.emplace(cerr, arg == "--redos-strict");
+    } else if (arg == "--lengths") {
+      settings.lengths = true;
+    } else if (arg == "--prefilter") {
+      settings.prefilter = true;
+    } else if (arg == "--cache") {
+      if (settings.cache) {
+        throw std::invalid_argument("Multiple cache definitions.");
+      }
+      if (++i == argc || argv[i][0] == '\0') {
+        throw std::invalid_argument("No cache directory given after --cache.");
+      }
+      settings.cache.emplace(argv[i]);
+    } else if (arg == "--serve") {
+      if (++i == argc || argv[i][0] == '\0') {
+        throw std::invalid_argument("No socket given after --serve.");
       }
+      socketPath = argv[i];
+    } else if (arg == "--time-passes" || arg == "--cache-stats" ||
+               arg == "--stats") {
+      // handled by run_with_arguments
+    } else if (arg == "--trace") {
+      if (++i == argc || argv[i][0] == '\0') {
+        throw std::invalid_argument("No file given after --trace.");
+      }
+      // handled by run_with_arguments
+    } else if (arg == "--list-passes") {
+      reon::PassManager::list(cout);
+      return 0;
     } else if (arg == "-h" || arg == "--help") {
       print_help();
-      return;
-    } else {
+      return 0;
+    } else if (arg.size() > 1 && arg[0] == '-') {
       throw std::invalid_argument("Unknown argument " + arg +
                                   ". Run with -h for help.");
+    } else {
+      jobs.push_back(BatchJob{arg, ""});
+      batch = true;
     }
   }
 
-  translation(*input, *output);
+  auto outputTarget = target == "re2" ? ReonOutput::Target::RE2
+                                      : ReonOutput::Target::PYTHON;
+  if (target != "python" && search) {
+    throw std::invalid_argument("Cannot combine -t with -s or -g.");
+  }
+  if (settings.lengths && (target != "python" || search)) {
+    throw std::invalid_argument(
+        "--lengths can only be combined with -t python.");
+  }
+  if (settings.prefilter && (target == "re2" || search)) {
+    throw std::invalid_argument(
+        "--prefilter can only be combined with -t python or -t cpp.");
+  }
+  if (!socketPath.empty()) {
+    if (batch || search || inputDefined || outputDefined || target == "cpp") {
+      throw std::invalid_argument(
+          "--serve can only be combined with -t python, -t re2, -v, passes, "
+          "--redos, --lengths and --prefilter.");
+    }
+    return reon::serve(socketPath, settings.library_options(outputTarget),
+                       cerr);
+  }
+  if (!batch) {
+    if (!directory.empty()) {
+      throw std::invalid_argument("Output directory requires batch input.");
+    }
+    if (threadsDefined) {
+      throw std::invalid_argument("Thread count requires batch input.");
+    }
+    if (target == "cpp") {
+      cpp_generation(inputPath, *output, settings);
+      return 0;
+    }
+    if (search && !linesPath.empty()) {
+      native_grep(inputPath, linesPath, *output, settings);
+      return 0;
+    }
+    if (search) {
+      native_search(inputPath, subject, *output, settings);
+      return 0;
+    }
+    translation(inputPath, *output, outputTarget, settings);
+    return 0;
+  }
+  if (inputDefined) {
+    throw std::invalid_argument("Cannot combine -i with batch input.");
+  }
+  if (search) {
+    throw std::invalid_argument("Cannot combine -s or -g with batch input.");
+  }
+  if (target == "cpp") {
+    throw std::invalid_argument("Cannot combine -t cpp with batch input.");
+  }
+  if (outputDefined && !directory.empty()) {
+    throw std::invalid_argument("Cannot combine -o with -d.");
+  }
+  if (ndjson) {
+    auto ndjsonJobs = read_ndjson(cin);
+    jobs.insert(jobs.end(), ndjsonJobs.begin(), ndjsonJobs.end());
+  }
+  return translation_batch(jobs, *output, directory, outputTarget, settings,
+                           threads);
 }
 
 void print_help() {
   cout << "reon - translates reon to Python 3 RE.\n\n";
-  cout << "usage: ./reon [-i input] [-o output] [-v variable]\n";
+  cout << "usage: ./reon [-i input] [-o output] [-t target] [-v variable]\n";
+  cout << "       ./reon [-i input] [-o output] [-s subject | -g file]\n";
+  cout << "       ./reon [-o output | -d directory] [-v variable] [-j threads] "
+          "[-m manifest]\n              [--ndjson] [input...]\n";
+  cout << "       ./reon --serve socket [-t target] [-v variable]\n";
   cout << "\n";
   cout << "-i input: Sets input to the input file. Default input is stdin.\n";
   cout << "-o output: Sets output to the output file. Default output is "
           "stdout.\n";
   cout << "-v variable: Sets the variable name set in the input. Default "
           "variable name is \"re\".\n";
+  cout << "-t target: Sets the output target:\n"
+          "  python: a Python 3 RE assigned to the variable (default),\n"
+          "  re2: a RE2 pattern on a single line; references, conditions and "
+          "lookaround\n    are rejected,\n"
+          "  cpp: a C++ header with search, match and full_match functions in "
+          "the\n    namespace named by -v.\n";
+  cout << "-s subject: Searches the subject with the native matching engine "
+          "and prints the\n  groups of the match instead of translating.\n";
+  cout << "-g file: Prints the lines of the file that contain a match, "
+          "using the native\n  matching engine instead of translating.\n";
+  cout << "\nBatch mode is used when inputs are given as arguments, with -m or "
+          "with --ndjson.\n";
+  cout << "-d directory: Writes each output to directory/input.py "
+          "(directory/input.re2\n  for re2) instead of one combined "
+          "output. Inputs with the same name fail\n  after the first one.\n";
+  cout << "-m manifest: Reads inputs from the manifest, one \"input [output]\" "
+          "per line.\n";
+  cout << "--ndjson: Reads inputs from stdin, one {\"input\": ..., "
+          "\"output\": ...} object per line.\n";
+  cout << "-j threads: Translates the inputs on the number of threads, or on "
+          "all cores\n  with 0. Outputs and errors keep the order of the "
+          "inputs.\n";
+  cout << "Failed inputs are reported and the remaining inputs are still "
+          "translated.\n";
+  cout << "\nPatterns are rewritten by passes before output; all passes are "
+          "enabled by default.\n";
+  cout << "--enable-pass pass, --disable-pass pass: Enables or disables a "
+          "pass, or all\n  passes with \"all\".\n";
+  cout << "--list-passes: Prints the available passes.\n";
+  cout << "--time-passes: Prints the time spent in each pass to stderr.\n";
+  cout << "\n--redos: Warns on stderr about subexpressions that can backtrack "
+          "exponentially\n  or polynomially in Python re, with their rows "
+          "and columns.\n";
+  cout << "--redos-strict: Fails with a semantic error instead of warning.\n";
+  cout << "--lengths: Follows each pattern with the shortest and the longest "
+          "match in\n  characters, assigned to variable_minlen and "
+          "variable_maxlen (None if\n  unbounded).\n";
+  cout << "--prefilter: Follows each pattern with the literals every match "
+          "contains and the\n  characters matches begin with, assigned to "
+          "variable_required and\n  variable_first, and a "
+          "variable_prefilter(s) function rejecting strings\n  without a "
+          "match. With -t cpp, search runs the prefilter first. Searches\n"
+          "  with -s and -g always use it.\n";
+  cout << "\n--cache directory: Reuses python and re2 translations stored in "
+          "the directory,\n  keyed on the input, the options and the reon "
+          "version. Concurrent runs may\n  share a directory.\n";
+  cout << "--cache-stats: Prints the cache hit and miss counts to stderr.\n";
+  cout << "\n--stats: Prints the time of each phase, token counts by kind, "
+          "rule expansions,\n  the peak nesting of lookbehind assertions, "
+          "bytes in and out and the peak RSS\n  to stderr.\n";
+  cout << "--trace file: Writes the phases of each input to the file in the "
+          "Chrome trace\n  event format, one thread per batch worker.\n";
+  cout << "\n--serve socket: Serves compile requests on the Unix domain socket "
+          "until\n  interrupted. A request is a 32-bit big-endian length and "
+          "the input; a\n  response is the 32-bit return value, the "
+          "length-prefixed output and the\n  length-prefixed error "
+          "messages.\n";
 }
\ No newline at end of file
@@ -0,0 +1,159 @@
+/**
+\file reon.cpp
+\brief Implements the in-memory compilation API of libreon.
+\author Radek Vít
+*/
+#include <reon.h>
+#include <reon_translation.h>
+#include <cctype>
+#include <optional>
+
+namespace reon {
+
+/**
+\brief Translation and settings of a Compiler.
+*/
+class Compiler::State {
+ public:
+  explicit State(const Options &options)
+      : translation_(std::make_unique<ReonLexer>(),
+                     std::make_unique<ReonOutput>(
+                         options.target == Target::RE2
+                             ? ReonOutput::Target::RE2
+                             : ReonOutput::Target::PYTHON,
+                         options.variable)) {
+    if (!valid_variable(options.variable)) {
+      invalid_.push_back(Diagnostic{
+          DiagnosticKind::OPTIONS, true, 0, 0,
+          "Variable name must contain only alphabetical characters."});
+    }
+    for (auto &pass : options.disabledPasses) {
+      try {
+        passes_.enable(pass, false);
+      } catch (std::invalid_argument &e) {
+        invalid_.push_back(
+            Diagnostic{DiagnosticKind::OPTIONS, true, 0, 0, e.what()});
+      }
+    }
+    if (options.redos || options.redosStrict)
+      redos_.emplace(options.redosStrict);
+    translation_.set_passes(&passes_);
+    translation_.set_redos(redos_ ? &*redos_ : nullptr);
+    translation_.set_lengths(options.lengths);
+    lengths_ = options.lengths;
+    translation_.set_prefilter(options.prefilter);
+    prefilter_ = options.prefilter;
+  }
+
+  Result compile(std::string_view input) {
+    Result result;
+    if (!invalid_.empty()) {
+      result.code = INVALID_ARGUMENT;
+      result.diagnostics = invalid_;
+      return result;
+    }
+    if (redos_)
+      redos_->clear();
+    try {
+      translation_.run_string(input, result.output);
+      result.ok = true;
+      if (lengths_) {
+        const MatchLength &length = translation_.length();
+        result.minLength = length.min;
+        result.maxLength = length.max;
+        result.unboundedLength = length.unbounded;
+      }
+      if (prefilter_) {
+        const Prefilter &prefilter = translation_.prefilter();
+        result.requiredLiterals = prefilter.required;
+        for (size_t i = 0; i < 4; ++i) {
+          result.firstBytes[i] = prefilter.anyFirst ? UINT64_MAX
+                                                    : prefilter.first.bits[i];
+        }
+      }
+    } catch (LexicalError &e) {
+      fail(result, DiagnosticKind::LEXICAL, LEXICAL_ERROR, e.row, e.col,
+           e.what());
+    } catch (TranslationError &e) {
+      const ReonLexer &lexer = translation_.lexer();
+      fail(result, DiagnosticKind::SYNTAX, SYNTAX_ERROR, lexer.token_row(),
+           lexer.token_col(), e.what());
+    } catch (SemanticError &e) {
+      // a strict check fails on its last warning
+      if (redos_ && redos_->strict() && !redos_->warnings().empty()) {
+        const RedosWarning &w = redos_->warnings().back();
+        fail(result, DiagnosticKind::BACKTRACKING, SEMANTIC_ERROR, w.row, w.col,
+             w.message);
+        return result;
+      }
+      fail(result, DiagnosticKind::SEMANTIC, SEMANTIC_ERROR, 0, 0, e.what());
+    } catch (TranslationException &e) {
+      fail(result, DiagnosticKind::INTERNAL, TRANSLATION_ENGINE_ERROR, 0, 0,
+           e.what());
+    } catch (std::exception &e) {
+      fail(result, DiagnosticKind::INTERNAL, RUNTIME_ERROR, 0, 0, e.what());
+    }
+    if (redos_ && !redos_->strict()) {
+      for (auto &w : redos_->warnings()) {
+        result.diagnostics.push_back(Diagnostic{
+            DiagnosticKind::BACKTRACKING, false, w.row, w.col, w.message});
+      }
+    }
+    return result;
+  }
+
+ protected:
+  reon::PassManager passes_;
+  std::optional<RedosChecker> redos_;
+  ReonTranslation translation_;
+  bool lengths_ = false;
+  bool prefilter_ = false;
+  /**
+  \brief Errors of invalid options, reported by every compilation.
+  */
+  std::vector<Diagnostic> invalid_;
+
+  /**
+  \brief Records an error and drops the partial output.
+  */
+  static void fail(Result &result, DiagnosticKind kind, int code, size_t row,
+                   size_t col, std::string message) {
+    // messages of the translation end with a new line
+    while (!message.empty() && message.back() == '\n')
+      message.pop_back();
+    result.ok = false;
+    result.code = code;
+    result.output.clear();
+    result.diagnostics.push_back(
+        Diagnostic{kind, true, row, col, std::move(message)});
+  }
+};
+
+Compiler::Compiler(const Options &options)
+    : state_(std::make_unique<State>(options)) {}
+
+Compiler::Compiler(Compiler &&) noexcept = default;
+Compiler &Compiler::operator=(Compiler &&) noexcept = default;
+Compiler::~Compiler() = default;
+
+Result Compiler::compile(std::string_view input) {
+  return state_->compile(input);
+}
+
+Result compile(std::string_view input, const Options &options) {
+  return Compiler(options).compile(input);
+}
+
+bool valid_variable(std::string_view name) {
+  if (name.empty())
+    return false;
+  for (char c : name) {
+    if (!std::isalpha(static_cast<unsigned char>(c)))
+      return false;
+  }
+  return true;
+}
+
+}  // namespace reon
+
+/*** End of file reon.cpp ***/
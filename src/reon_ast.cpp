@@ -0,0 +1,381 @@
+/**
+\file reon_ast.cpp
+\brief Implements building and lowering of reon ASTs.
+\author Radek Vít
+*/
+#include <reon_ast.h>
+
+namespace reon {
+
+namespace {
+
+/**
+\brief Recursive descent builder of ASTs from output symbols.
+
+Follows the structure reonGrammar produces: every RE is a sequence and every
+non-capturing group is either the operand of a repeat or an alternation. The
+bare repeats and alternations of the groups pass are read as well.
+*/
+class Builder {
+ public:
+  Builder(const std::vector<ReonSymbol> &symbols, Ast &ast)
+      : symbols_(symbols), ast_(ast) {}
+
+  /**
+  \brief Thrown when the groups are nested too deep.
+  */
+  struct TooDeep {};
+
+  bool build() {
+    try {
+      build_root();
+    } catch (TooDeep &) {
+      return false;
+    }
+    return true;
+  }
+
+ protected:
+  const std::vector<ReonSymbol> &symbols_;
+  Ast &ast_;
+  size_t position_ = 0;
+  size_t depth_ = 0;
+
+  void build_root() {
+    expect(OutputId::VARIABLE);
+    expect(OutputId::ASSIGNMENT);
+    ast_.set_root(alternatives());
+    expect(OutputId::END);
+    if (position_ != symbols_.size())
+      unbalanced();
+  }
+
+  [[noreturn]] static void unbalanced() {
+    throw SemanticError("Unbalanced groups in a pattern.");
+  }
+
+  bool at(OutputId id) const {
+    return position_ < symbols_.size() && symbols_[position_].id == id;
+  }
+
+  void expect(OutputId id) {
+    if (!at(id))
+      unbalanced();
+    ++position_;
+  }
+
+  /**
+  \brief Returns the attribute of an optional terminal.
+  */
+  std::string_view optional(OutputId id) {
+    return at(id) ? symbols_[position_++].attribute : std::string_view{};
+  }
+
+  uint32_t sequence() {
+    if (++depth_ > maxAstDepth)
+      throw TooDeep{};
+    uint32_t n = ast_.add(AstKind::SEQUENCE);
+    while (position_ < symbols_.size() && !at(OutputId::ALTERNATIVE) &&
+           !at(OutputId::GROUP_CLOSE) && !at(OutputId::END_CHECK) &&
+           !at(OutputId::END)) {
+      uint32_t e = element();
+      // a repeat applies to the preceding element without a group
+      if (at(OutputId::REPEAT))
+        e = repeat(e, BARE);
+      ast_.append(n, e);
+    }
+    --depth_;
+    return n;
+  }
+
+  /**
+  \brief Parses a sequence, or alternatives without a group.
+  */
+  uint32_t alternatives() {
+    uint32_t first = sequence();
+    if (!at(OutputId::ALTERNATIVE))
+      return first;
+    uint32_t n = ast_.add(AstKind::ALTERNATION, {}, BARE);
+    ast_.append(n, first);
+    while (at(OutputId::ALTERNATIVE)) {
+      ++position_;
+      ast_.append(n, sequence());
+    }
+    return n;
+  }
+
+  /**
+  \brief Parses the repeat string of a child and an optional non-greedy flag.
+  */
+  uint32_t repeat(uint32_t child, uint8_t flags) {
+    uint32_t n =
+        ast_.add(AstKind::REPEAT, symbols_[position_++].attribute, flags);
+    if (at(OutputId::NON_GREEDY)) {
+      ++position_;
+      ast_[n].flags |= NON_GREEDY;
+    }
+    ast_.append(n, child);
+    return n;
+  }
+
+  uint32_t element() {
+    const ReonSymbol &s = symbols_[position_++];
+    switch (s.id) {
+      case OutputId::RE:
+        return ast_.add(AstKind::LITERAL, s.attribute);
+      case OutputId::NEVER:
+        return ast_.add(AstKind::NEVER);
+      case OutputId::NC_GROUP_OPEN:
+        return non_capturing();
+      case OutputId::SET_OPEN:
+      case OutputId::NSET_OPEN: {
+        uint32_t n = ast_.add(AstKind::SET, optional(OutputId::SET),
+                              s.id == OutputId::NSET_OPEN ? NEGATED : 0);
+        expect(OutputId::SET_CLOSE);
+        return n;
+      }
+      case OutputId::GROUP_OPEN: {
+        expect(OutputId::GROUP);
+        return group(ast_.add(AstKind::GROUP));
+      }
+      case OutputId::NAMED_GROUP_OPEN: {
+        std::string_view name = optional(OutputId::NAMED_GROUP);
+        expect(OutputId::NAMED_GROUP_NAME_END);
+        return group(ast_.add(AstKind::GROUP, name, NAMED));
+      }
+      case OutputId::BACKSLASH:
+        return ast_.add(AstKind::REFERENCE, optional(OutputId::NREF));
+      case OutputId::REF_OPEN: {
+        uint32_t n =
+            ast_.add(AstKind::REFERENCE, optional(OutputId::REF), NAMED);
+        expect(OutputId::GROUP_CLOSE);
+        return n;
+      }
+      case OutputId::COMMENT_OPEN: {
+        uint32_t n = ast_.add(AstKind::COMMENT, optional(OutputId::COMMENT));
+        expect(OutputId::GROUP_CLOSE);
+        return n;
+      }
+      case OutputId::LOOKAHEAD_OPEN:
+        return group(ast_.add(AstKind::LOOKAROUND));
+      case OutputId::NLOOKAHEAD_OPEN:
+        return group(ast_.add(AstKind::LOOKAROUND, {}, NEGATED));
+      case OutputId::LOOKBEHIND_OPEN:
+      case OutputId::NLOOKBEHIND_OPEN: {
+        uint8_t flags = BEHIND;
+        if (s.id == OutputId::NLOOKBEHIND_OPEN)
+          flags |= NEGATED;
+        uint32_t n = ast_.add(AstKind::LOOKAROUND, {}, flags);
+        expect(OutputId::FIXED_LENGTH_CHECK);
+        ast_.append(n, sequence());
+        expect(OutputId::END_CHECK);
+        expect(OutputId::GROUP_CLOSE);
+        return n;
+      }
+      case OutputId::CONDITION_OPEN:
+        return conditional();
+      default:
+        unbalanced();
+    }
+  }
+
+  /**
+  \brief Parses the contents of a group and its end.
+  */
+  uint32_t group(uint32_t n) {
+    ast_.append(n, alternatives());
+    expect(OutputId::GROUP_CLOSE);
+    return n;
+  }
+
+  /**
+  \brief Parses a repeat or an alternation, both in a non-capturing group.
+  */
+  uint32_t non_capturing() {
+    uint32_t first = sequence();
+    if (!at(OutputId::ALTERNATIVE)) {
+      expect(OutputId::GROUP_CLOSE);
+      if (at(OutputId::REPEAT))
+        return repeat(first, 0);
+      uint32_t n = ast_.add(AstKind::ALTERNATION);
+      ast_.append(n, first);
+      return n;
+    }
+    uint32_t n = ast_.add(AstKind::ALTERNATION);
+    ast_.append(n, first);
+    while (at(OutputId::ALTERNATIVE)) {
+      ++position_;
+      ast_.append(n, sequence());
+    }
+    expect(OutputId::GROUP_CLOSE);
+    return n;
+  }
+
+  uint32_t conditional() {
+    uint32_t n = ast_.add(AstKind::CONDITIONAL);
+    if (at(OutputId::REF))
+      ast_[n].flags |= NAMED;
+    else if (!at(OutputId::NREF))
+      unbalanced();
+    ast_[n].text = symbols_[position_++].attribute;
+    expect(OutputId::GROUP_CLOSE);
+    ast_.append(n, sequence());
+    if (at(OutputId::ALTERNATIVE)) {
+      ++position_;
+      ast_[n].flags |= HAS_ELSE;
+      ast_.append(n, sequence());
+    }
+    expect(OutputId::GROUP_CLOSE);
+    return n;
+  }
+};
+
+/**
+\brief Writes the output symbols of AST nodes.
+*/
+class Lowerer {
+ public:
+  Lowerer(const Ast &ast, std::vector<ReonSymbol> &symbols)
+      : ast_(ast), symbols_(symbols) {}
+
+  void lower(uint32_t root) {
+    emit(OutputId::VARIABLE);
+    emit(OutputId::ASSIGNMENT);
+    if (root != Ast::none)
+      node(root);
+    emit(OutputId::END);
+  }
+
+ protected:
+  const Ast &ast_;
+  std::vector<ReonSymbol> &symbols_;
+
+  void emit(OutputId id, std::string_view attribute = {}) {
+    symbols_.push_back(ReonSymbol{id, attribute});
+  }
+
+  /**
+  \brief Opens the non-capturing group of a node unless it is bare.
+  */
+  void open(const AstNode &a) {
+    if (!(a.flags & BARE))
+      emit(OutputId::NC_GROUP_OPEN);
+  }
+
+  void close(const AstNode &a) {
+    if (!(a.flags & BARE))
+      emit(OutputId::GROUP_CLOSE);
+  }
+
+  void children(uint32_t n) {
+    for (uint32_t c = ast_[n].first; c != Ast::none; c = ast_[c].next) {
+      node(c);
+    }
+  }
+
+  void node(uint32_t n) {
+    const AstNode &a = ast_[n];
+    switch (a.kind) {
+      case AstKind::SEQUENCE:
+        return children(n);
+      case AstKind::ALTERNATION:
+        if (a.first == Ast::none)
+          return;
+        open(a);
+        for (uint32_t c = a.first; c != Ast::none; c = ast_[c].next) {
+          if (c != a.first)
+            emit(OutputId::ALTERNATIVE);
+          node(c);
+        }
+        return close(a);
+      case AstKind::REPEAT:
+        open(a);
+        children(n);
+        close(a);
+        emit(OutputId::REPEAT, a.text);
+        if (a.flags & NON_GREEDY)
+          emit(OutputId::NON_GREEDY);
+        return;
+      case AstKind::LITERAL:
+        return emit(OutputId::RE, a.text);
+      case AstKind::NEVER:
+        return emit(OutputId::NEVER);
+      case AstKind::SET:
+        emit(a.flags & NEGATED ? OutputId::NSET_OPEN : OutputId::SET_OPEN);
+        emit(OutputId::SET, a.text);
+        return emit(OutputId::SET_CLOSE);
+      case AstKind::GROUP:
+        if (a.flags & NAMED) {
+          emit(OutputId::NAMED_GROUP_OPEN);
+          emit(OutputId::NAMED_GROUP, a.text);
+          emit(OutputId::NAMED_GROUP_NAME_END);
+        } else {
+          emit(OutputId::GROUP_OPEN);
+          emit(OutputId::GROUP);
+        }
+        children(n);
+        return emit(OutputId::GROUP_CLOSE);
+      case AstKind::REFERENCE:
+        if (a.flags & NAMED) {
+          emit(OutputId::REF_OPEN);
+          emit(OutputId::REF, a.text);
+          return emit(OutputId::GROUP_CLOSE);
+        }
+        emit(OutputId::BACKSLASH);
+        return emit(OutputId::NREF, a.text);
+      case AstKind::LOOKAROUND:
+        return lookaround(n);
+      case AstKind::CONDITIONAL:
+        emit(OutputId::CONDITION_OPEN);
+        emit(a.flags & NAMED ? OutputId::REF : OutputId::NREF, a.text);
+        emit(OutputId::GROUP_CLOSE);
+        node(a.first);
+        if (a.flags & HAS_ELSE) {
+          emit(OutputId::ALTERNATIVE);
+          node(ast_[a.first].next);
+        }
+        return emit(OutputId::GROUP_CLOSE);
+      case AstKind::COMMENT:
+        emit(OutputId::COMMENT_OPEN);
+        emit(OutputId::COMMENT, a.text);
+        return emit(OutputId::GROUP_CLOSE);
+    }
+  }
+
+  void lookaround(uint32_t n) {
+    const AstNode &a = ast_[n];
+    bool negated = a.flags & NEGATED;
+    if (!(a.flags & BEHIND)) {
+      emit(negated ? OutputId::NLOOKAHEAD_OPEN : OutputId::LOOKAHEAD_OPEN);
+      children(n);
+      emit(OutputId::GROUP_CLOSE);
+      return;
+    }
+    emit(negated ? OutputId::NLOOKBEHIND_OPEN : OutputId::LOOKBEHIND_OPEN);
+    emit(OutputId::FIXED_LENGTH_CHECK);
+    children(n);
+    emit(OutputId::END_CHECK);
+    emit(OutputId::GROUP_CLOSE);
+  }
+};
+
+}  // namespace
+
+bool build_ast(const std::vector<ReonSymbol> &symbols, Ast &ast) {
+  ast.clear();
+  return Builder(symbols, ast).build();
+}
+
+void lower_ast(const Ast &ast, std::vector<ReonSymbol> &symbols) {
+  lower_ast(ast, ast.root(), symbols);
+}
+
+void lower_ast(const Ast &ast, uint32_t root,
+               std::vector<ReonSymbol> &symbols) {
+  symbols.clear();
+  Lowerer(ast, symbols).lower(root);
+}
+
+}  // namespace reon
+
+/*** End of file reon_ast.cpp ***/
@@ -0,0 +1,237 @@
+/**
+\file reon_batch.cpp
+\brief Implements reading of batch job lists.
+\author Radek Vít
+*/
+#include <reon_batch.h>
+#include <cctype>
+#include <stdexcept>
+
+namespace {
+
+/**
+\brief Minimal reader of JSON objects with string members. Values of other
+members are skipped.
+*/
+class NdjsonLine {
+ public:
+  NdjsonLine(const std::string &line, size_t number)
+      : line_(line), number_(number) {}
+
+  /**
+  \brief Reads the object on the line into a job.
+  */
+  BatchJob read() {
+    BatchJob job;
+    skip_space();
+    expect('{');
+    skip_space();
+    if (peek() == '}') {
+      ++position_;
+    } else {
+      while (1) {
+        std::string key = read_string();
+        skip_space();
+        expect(':');
+        skip_space();
+        if (key == "input")
+          job.input = read_string();
+        else if (key == "output")
+          job.output = read_string();
+        else
+          skip_value();
+        skip_space();
+        if (peek() == ',') {
+          ++position_;
+          skip_space();
+          continue;
+        }
+        expect('}');
+        break;
+      }
+    }
+    skip_space();
+    if (position_ != line_.size())
+      error("Trailing characters after object.");
+    if (job.input.empty())
+      error("Missing string member \"input\".");
+    return job;
+  }
+
+ private:
+  const std::string &line_;
+  size_t number_;
+  size_t position_ = 0;
+
+  [[noreturn]] void error(const std::string &msg) {
+    throw std::invalid_argument("NDJSON line " + std::to_string(number_) +
+                                ": " + msg);
+  }
+
+  char peek() { return position_ < line_.size() ? line_[position_] : '\0'; }
+
+  void skip_space() {
+    while (position_ < line_.size() &&
+           std::isspace(static_cast<unsigned char>(line_[position_])))
+      ++position_;
+  }
+
+  void expect(char c) {
+    if (peek() != c)
+      error("Expected '" + std::string{c} + "'.");
+    ++position_;
+  }
+
+  std::string read_string() {
+    expect('"');
+    std::string result;
+    while (1) {
+      if (position_ == line_.size())
+        error("Unterminated string.");
+      char c = line_[position_++];
+      if (c == '"')
+        return result;
+      if (c != '\\') {
+        result += c;
+        continue;
+      }
+      if (position_ == line_.size())
+        error("Unterminated string.");
+      c = line_[position_++];
+      switch (c) {
+        case 'b':
+          result += '\b';
+          break;
+        case 'f':
+          result += '\f';
+          break;
+        case 'n':
+          result += '\n';
+          break;
+        case 'r':
+          result += '\r';
+          break;
+        case 't':
+          result += '\t';
+          break;
+        case 'u':
+          result += read_code_point();
+          break;
+        default:
+          result += c;
+      }
+    }
+  }
+
+  std::string read_code_point() {
+    unsigned long cp = 0;
+    for (int i = 0; i < 4; ++i, ++position_) {
+      if (position_ == line_.size() ||
+          !std::isxdigit(static_cast<unsigned char>(line_[position_])))
+        error("Invalid \\u escape.");
+      char c = line_[position_];
+      cp = cp * 16 + (c >= '0' && c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10);
+    }
+    std::string result;
+    if (cp < 0x80) {
+      result += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+      result += static_cast<char>(0xC0 | (cp >> 6));
+      result += static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+      result += static_cast<char>(0xE0 | (cp >> 12));
+      result += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+      result += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+    return result;
+  }
+
+  /**
+  \brief Skips a value; objects and arrays are skipped up to their balanced
+  end.
+  */
+  void skip_value() {
+    size_t depth = 0;
+    while (position_ < line_.size()) {
+      char c = peek();
+      if (c == '"') {
+        read_string();
+      } else if (c == '{' || c == '[') {
+        ++depth;
+        ++position_;
+      } else if (c == '}' || c == ']') {
+        if (depth == 0)
+          return;
+        --depth;
+        ++position_;
+      } else if (c == ',' && depth == 0) {
+        return;
+      } else {
+        // numbers, true, false, null, separators and whitespace
+        ++position_;
+      }
+    }
+    if (depth > 0)
+      error("Unterminated value.");
+  }
+};
+
+}  // namespace
+
+std::vector<BatchJob> read_manifest(std::istream &is,
+                                    const std::string &name) {
+  std::vector<BatchJob> jobs;
+  std::string line;
+  size_t number = 0;
+  while (std::getline(is, line)) {
+    ++number;
+    size_t begin = line.find_first_not_of(" \t\r");
+    if (begin == std::string::npos || line[begin] == '#')
+      continue;
+    size_t end = line.find_first_of(" \t\r", begin);
+    BatchJob job;
+    job.input = line.substr(begin, end - begin);
+    if (end != std::string::npos) {
+      size_t outBegin = line.find_first_not_of(" \t\r", end);
+      if (outBegin != std::string::npos) {
+        size_t outEnd = line.find_first_of(" \t\r", outBegin);
+        job.output = line.substr(outBegin, outEnd - outBegin);
+        if (outEnd != std::string::npos &&
+            line.find_first_not_of(" \t\r", outEnd) != std::string::npos)
+          throw std::invalid_argument(name + ":" + std::to_string(number) +
+                                      ": Too many paths on a manifest line.");
+      }
+    }
+    jobs.push_back(job);
+  }
+  return jobs;
+}
+
+std::vector<BatchJob> read_ndjson(std::istream &is) {
+  std::vector<BatchJob> jobs;
+  std::string line;
+  size_t number = 0;
+  while (std::getline(is, line)) {
+    ++number;
+    if (line.find_first_not_of(" \t\r") == std::string::npos)
+      continue;
+    jobs.push_back(NdjsonLine(line, number).read());
+  }
+  return jobs;
+}
+
+std::string output_in_directory(const std::string &directory,
+                                const std::string &input,
+                                const std::string &extension) {
+  size_t slash = input.find_last_of('/');
+  std::string base =
+      slash == std::string::npos ? input : input.substr(slash + 1);
+  size_t dot = base.find_last_of('.');
+  if (dot != std::string::npos && dot != 0)
+    base.erase(dot);
+  if (directory.empty() || directory.back() == '/')
+    return directory + base + extension;
+  return directory + "/" + base + extension;
+}
+
+/*** End of file reon_batch.cpp ***/
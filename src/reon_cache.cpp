@@ -0,0 +1,140 @@
+/**
+\file reon_cache.cpp
+\brief Implements the content-addressed on-disk cache of translations.
+\author Radek Vít
+*/
+#include <reon.h>
+#include <reon_cache.h>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+
+namespace reon {
+
+namespace {
+
+/**
+\brief 128-bit FNV-1a over 64-bit halves.
+*/
+class Fnv128 {
+ public:
+  void add(std::string_view s) {
+    for (char c : s) {
+      low_ ^= static_cast<unsigned char>(c);
+      multiply();
+    }
+  }
+
+  /**
+  \brief Adds a string and its length, so that adjacent strings cannot be
+  confused.
+  */
+  void add_field(std::string_view s) {
+    add(s);
+    add(std::to_string(s.size()));
+    add(std::string_view("\0", 1));
+  }
+
+  Cache::Key key() const { return Cache::Key{high_, low_}; }
+
+ protected:
+  uint64_t high_ = 0x6c62272e07bb0142;
+  uint64_t low_ = 0x62b821756295c58d;
+
+  /**
+  \brief Multiplies by the FNV-128 prime, 2^88 + 0x13b, modulo 2^128.
+  */
+  void multiply() {
+    constexpr uint64_t m = 0x13b;
+    uint64_t carry = ((low_ >> 32) * m + ((low_ & 0xffffffff) * m >> 32)) >> 32;
+    uint64_t high = high_ * m + carry + (low_ << 24);
+    low_ *= m;
+    high_ = high;
+  }
+};
+
+}  // namespace
+
+std::string Cache::Key::hex() const {
+  static constexpr char digits[] = "0123456789abcdef";
+  std::string result(32, '0');
+  for (size_t i = 0; i < 16; ++i) {
+    result[15 - i] = digits[(high >> 4 * i) & 0xf];
+    result[31 - i] = digits[(low >> 4 * i) & 0xf];
+  }
+  return result;
+}
+
+Cache::Cache(std::string directory) : directory_(std::move(directory)) {
+  std::error_code error;
+  std::filesystem::create_directories(directory_, error);
+  if (error || !std::filesystem::is_directory(directory_)) {
+    throw std::invalid_argument("Could not create cache directory " +
+                                directory_ + ".");
+  }
+}
+
+Cache::Key Cache::key(std::string_view input, std::string_view options) {
+  Fnv128 hash;
+  hash.add_field(version);
+  hash.add_field(options);
+  hash.add(input);
+  return hash.key();
+}
+
+std::string Cache::path(const Key &key) const {
+  return directory_ + "/" + key.hex();
+}
+
+bool Cache::load(const Key &key, std::string &output) {
+  std::ifstream entry{path(key), std::ios::binary};
+  if (entry.fail()) {
+    ++misses_;
+    return false;
+  }
+  std::ostringstream contents;
+  contents << entry.rdbuf();
+  if (entry.bad()) {
+    ++misses_;
+    return false;
+  }
+  output = contents.str();
+  ++hits_;
+  return true;
+}
+
+void Cache::store(const Key &key, std::string_view output) {
+  std::string target = path(key);
+  // unique among processes sharing the directory
+  std::random_device random;
+  std::string temporary = directory_ + "/.tmp-" + key.hex() + "-" +
+                          std::to_string(random()) + "-" +
+                          std::to_string(stores_);
+  {
+    std::ofstream entry{temporary, std::ios::binary};
+    entry.write(output.data(), output.size());
+    entry.close();
+    if (entry.fail()) {
+      std::remove(temporary.c_str());
+      return;
+    }
+  }
+  // readers see either no entry or a complete one
+  if (std::rename(temporary.c_str(), target.c_str()) != 0) {
+    std::remove(temporary.c_str());
+    return;
+  }
+  ++stores_;
+}
+
+void Cache::report(std::ostream &os) const {
+  os << "cache: " << hits_ << " hits, " << misses_ << " misses, " << stores_
+     << " stored\n";
+}
+
+}  // namespace reon
+
+/*** End of file reon_cache.cpp ***/
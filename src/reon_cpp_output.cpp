@@ -0,0 +1,302 @@
+/**
+\file reon_cpp_output.cpp
+\brief Implements the generation of C++ matchers from reon patterns.
+\author Radek Vít
+*/
+#include <reon_cpp_output.h>
+#include <reon_dfa.h>
+#include <reon_output_buffer.h>
+#include <algorithm>
+#include <cctype>
+#include <string>
+#include <vector>
+
+namespace reon {
+
+namespace {
+
+/**
+\brief Kinds of generated matchers.
+*/
+enum class Mode : uint8_t {
+  /**
+  \brief A match anywhere in the text.
+  */
+  SEARCH,
+  /**
+  \brief A match at the beginning of the text.
+  */
+  MATCH,
+  /**
+  \brief A match of the whole text.
+  */
+  FULL_MATCH
+};
+
+/**
+\brief Writes matcher functions of DFA tables as switch/goto state machines.
+*/
+class CppWriter {
+ public:
+  explicit CppWriter(OutputBuffer &out) : out_(out) {}
+
+  /**
+  \brief Writes a matcher function.
+  \param[in] prefiltered Texts rejected by the prefilter function do not
+  match.
+  */
+  void function(const LazyDfa::Tables &t, Mode mode, std::string_view name,
+                std::string_view brief, bool prefiltered = false) {
+    t_ = &t;
+    mode_ = mode;
+    out_.write("/**\n\\brief ");
+    out_.write(brief);
+    out_.write("\n*/\ninline bool ");
+    out_.write(name);
+    out_.write("(std::string_view text) {\n");
+    if (t.start == LazyDfa::Tables::dead || accepts(t.start)) {
+      // the result does not depend on the text
+      out_.write("  static_cast<void>(text);\n  return ");
+      out_.write(t.start == LazyDfa::Tables::dead ? "false;\n}\n\n"
+                                                  : "true;\n}\n\n");
+      return;
+    }
+    if (prefiltered)
+      out_.write("  if (!prefilter(text))\n    return false;\n");
+    out_.write(
+        "  auto p = reinterpret_cast<const unsigned char *>(text.data());\n"
+        "  auto end = p + text.size();\n");
+    out_.write(t.emptyMatch ? "  if (p == end)\n    return true;\n"
+                            : "  if (p == end)\n    return false;\n");
+    find_targets();
+    for (uint32_t s = 0; s < t.match.size(); ++s) {
+      if (s == t.start || targets_[s])
+        state(s);
+    }
+    out_.write("}\n\n");
+  }
+
+ protected:
+  OutputBuffer &out_;
+  const LazyDfa::Tables *t_ = nullptr;
+  Mode mode_ = Mode::SEARCH;
+  /**
+  \brief States that are jumped to from states reachable from the start.
+  */
+  std::vector<bool> targets_;
+
+  /**
+  \brief Returns true if entering a state ends the matcher with a match.
+  */
+  bool accepts(uint32_t s) const {
+    return mode_ != Mode::FULL_MATCH && t_->match[s];
+  }
+
+  void find_targets() {
+    targets_.assign(t_->match.size(), false);
+    std::vector<bool> reached(t_->match.size(), false);
+    std::vector<uint32_t> stack{t_->start};
+    reached[t_->start] = true;
+    while (!stack.empty()) {
+      uint32_t s = stack.back();
+      stack.pop_back();
+      for (size_t c = 0; c < t_->classCount; ++c) {
+        uint32_t next = t_->transitions[s * t_->classCount + c];
+        if (next == LazyDfa::Tables::dead || accepts(next))
+          continue;
+        targets_[next] = true;
+        if (!reached[next]) {
+          reached[next] = true;
+          stack.push_back(next);
+        }
+      }
+    }
+  }
+
+  void action(uint32_t next) {
+    if (next == LazyDfa::Tables::dead) {
+      out_.write("return false;\n");
+    } else if (accepts(next)) {
+      out_.write("return true;\n");
+    } else {
+      out_.write("goto s");
+      out_.write(std::to_string(next));
+      out_.write(";\n");
+    }
+  }
+
+  static std::string byte_literal(unsigned c) {
+    if (std::isalnum(static_cast<int>(c)))
+      return std::string{'\'', static_cast<char>(c), '\''};
+    const char *digits = "0123456789abcdef";
+    return std::string{'0', 'x', digits[c >> 4], digits[c & 15]};
+  }
+
+  void state(uint32_t s) {
+    if (targets_[s]) {
+      out_.put('s');
+      out_.write(std::to_string(s));
+      out_.write(":\n");
+    }
+    // the text is not empty when the matcher enters the start state
+    if (targets_[s]) {
+      out_.write("  if (p == end)\n    return ");
+      out_.write(t_->matchAtEnd[s] ? "true;\n" : "false;\n");
+    }
+
+    // bytes jumping to the most common next state use the default label
+    std::vector<uint32_t> next(256);
+    for (unsigned c = 0; c < 256; ++c) {
+      next[c] = t_->transitions[s * t_->classCount + t_->byteClass[c]];
+    }
+    std::vector<uint32_t> order = next;
+    std::sort(order.begin(), order.end());
+    order.erase(std::unique(order.begin(), order.end()), order.end());
+    uint32_t common = *std::max_element(
+        order.begin(), order.end(), [&next](uint32_t a, uint32_t b) {
+          return std::count(next.begin(), next.end(), a) <
+                 std::count(next.begin(), next.end(), b);
+        });
+
+    if (order.size() == 1) {
+      out_.write(common == LazyDfa::Tables::dead || accepts(common)
+                     ? "  "
+                     : "  ++p;\n  ");
+      action(common);
+      return;
+    }
+    out_.write("  switch (*p++) {\n");
+    for (uint32_t target : order) {
+      if (target == common)
+        continue;
+      size_t column = 0;
+      for (unsigned c = 0; c < 256; ++c) {
+        if (next[c] != target)
+          continue;
+        std::string label = "case " + byte_literal(c) + ":";
+        if (column == 0 || column + label.size() + 1 > 80) {
+          out_.write(column == 0 ? "    " : "\n    ");
+          column = 4;
+        } else {
+          out_.put(' ');
+          ++column;
+        }
+        out_.write(label);
+        column += label.size();
+      }
+      out_.write("\n      ");
+      action(target);
+    }
+    out_.write("    default:\n      ");
+    action(common);
+    out_.write("  }\n");
+  }
+};
+
+/**
+\brief Writes a C++ string literal.
+*/
+void string_literal(OutputBuffer &out, std::string_view s) {
+  out.put('"');
+  for (char c : s) {
+    auto u = static_cast<unsigned char>(c);
+    if (c == '"' || c == '\\') {
+      out.put('\\');
+      out.put(c);
+    } else if (u < 0x20 || u >= 0x7F) {
+      // octal escapes have at most three digits and end unambiguously
+      char escape[] = {'\\', static_cast<char>('0' + (u >> 6)),
+                       static_cast<char>('0' + (u >> 3 & 7)),
+                       static_cast<char>('0' + (u & 7))};
+      out.write(std::string_view(escape, 4));
+    } else {
+      out.put(c);
+    }
+  }
+  out.put('"');
+}
+
+/**
+\brief Writes the prefilter function.
+*/
+void write_prefilter(OutputBuffer &out, const Prefilter &prefilter) {
+  out.write(
+      "/**\n\\brief Returns false if text cannot contain a match; search "
+      "returns false\nwithout matching then.\n*/\n"
+      "inline bool prefilter(std::string_view text) {\n");
+  if (prefilter.empty() || prefilter.never) {
+    out.write("  static_cast<void>(text);\n  return ");
+    out.write(prefilter.never ? "false;\n}\n\n" : "true;\n}\n\n");
+    return;
+  }
+  for (auto &literal : prefilter.required) {
+    out.write("  if (text.find(");
+    string_literal(out, literal);
+    out.write(") == std::string_view::npos)\n    return false;\n");
+  }
+  if (prefilter.anyFirst) {
+    out.write("  return true;\n}\n\n");
+    return;
+  }
+  out.write("  static constexpr unsigned long long first[4] = {\n");
+  const char *digits = "0123456789abcdef";
+  for (size_t i = 0; i < 4; ++i) {
+    out.write("      0x");
+    for (int shift = 60; shift >= 0; shift -= 4) {
+      out.put(digits[prefilter.first.bits[i] >> shift & 15]);
+    }
+    out.write(i < 3 ? "ULL,\n" : "ULL};\n");
+  }
+  out.write(
+      "  for (unsigned char c : text) {\n"
+      "    if (first[c >> 6] >> (c & 63) & 1)\n"
+      "      return true;\n"
+      "  }\n"
+      "  return false;\n}\n\n");
+}
+
+}  // namespace
+
+void generate_cpp(const Program &program, std::string_view name,
+                  std::ostream &output, const Prefilter *prefilter) {
+  if (!LazyDfa::supported(program))
+    throw SemanticError(
+        "Word boundaries are not supported by generated C++ matchers.");
+  // all states are kept, the cache is never flushed
+  LazyDfa unanchored(program, false, true, SIZE_MAX);
+  LazyDfa anchored(program, true, true, SIZE_MAX);
+  auto searchTables = unanchored.tables(maxGeneratedStates);
+  auto anchoredTables = anchored.tables(maxGeneratedStates);
+
+  std::string guard = "REON_";
+  for (char c : name) {
+    guard.push_back(static_cast<char>(std::toupper(c)));
+  }
+  guard += "_H";
+
+  OutputBuffer out;
+  out.set_stream(output);
+  out.write("// Generated by reon; matchers of a reon pattern.\n");
+  out.write("#ifndef " + guard + "\n#define " + guard + "\n\n");
+  out.write("#include <string_view>\n\nnamespace ");
+  out.write(name);
+  out.write(" {\n\n");
+  if (prefilter)
+    write_prefilter(out, *prefilter);
+  CppWriter writer(out);
+  writer.function(searchTables, Mode::SEARCH, "search",
+                  "Returns true if text contains a match.",
+                  prefilter != nullptr);
+  writer.function(anchoredTables, Mode::MATCH, "match",
+                  "Returns true if text begins with a match.");
+  writer.function(anchoredTables, Mode::FULL_MATCH, "full_match",
+                  "Returns true if all of text matches.");
+  out.write("}  // namespace ");
+  out.write(name);
+  out.write("\n\n#endif\n");
+  out.flush();
+}
+
+}  // namespace reon
+
+/*** End of file reon_cpp_output.cpp ***/
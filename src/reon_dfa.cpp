@@ -0,0 +1,321 @@
+/**
+\file reon_dfa.cpp
+\brief Implements the lazily built DFA for matching reon patterns.
+\author Radek Vít
+*/
+#include <reon_dfa.h>
+#include <algorithm>
+
+namespace reon {
+
+LazyDfa::LazyDfa(const Program &program, bool anchored, bool longest,
+                 size_t cacheSize)
+    : program_(program),
+      anchored_(anchored),
+      longest_(longest),
+      cacheSize_(cacheSize),
+      restart_(static_cast<uint32_t>(program.insts.size())),
+      visited_(program.insts.size(), 0) {
+  compute_byte_classes();
+}
+
+void LazyDfa::compute_byte_classes() {
+  // bytes are split by every set they are tested against
+  auto refine = [this](const ByteSet &set) {
+    int map[2][256];
+    std::fill(&map[0][0], &map[0][0] + 2 * 256, -1);
+    int next = 0;
+    for (unsigned b = 0; b < 256; ++b) {
+      int &m = map[set.test(static_cast<unsigned char>(b))][byteClass_[b]];
+      if (m < 0)
+        m = next++;
+      byteClass_[b] = static_cast<uint16_t>(m);
+    }
+  };
+  ByteSet bytes;
+  for (auto &inst : program_.insts) {
+    if (inst.op == Op::BYTE)
+      bytes.set(static_cast<unsigned char>(inst.arg));
+  }
+  for (unsigned b = 0; b < 256; ++b) {
+    if (bytes.test(static_cast<unsigned char>(b))) {
+      ByteSet single;
+      single.set(static_cast<unsigned char>(b));
+      refine(single);
+    }
+  }
+  for (auto &set : program_.classes) {
+    refine(set);
+  }
+  uint16_t count = *std::max_element(byteClass_, byteClass_ + 256) + 1;
+  representative_.resize(count);
+  for (unsigned b = 256; b-- > 0;) {
+    representative_[byteClass_[b]] = static_cast<unsigned char>(b);
+  }
+}
+
+void LazyDfa::clear_list() {
+  list_.clear();
+  if (++generation_ == 0) {
+    std::fill(visited_.begin(), visited_.end(), 0);
+    generation_ = 1;
+  }
+}
+
+void LazyDfa::closure(uint32_t pc0, bool atBegin, bool atEnd, bool &cut) {
+  const auto &insts = program_.insts;
+  stack_.push_back(pc0);
+  while (!stack_.empty()) {
+    uint32_t pc = stack_.back();
+    stack_.pop_back();
+    while (visited_[pc] != generation_) {
+      visited_[pc] = generation_;
+      const Inst &inst = insts[pc];
+      if (inst.op == Op::JUMP) {
+        pc = inst.arg;
+      } else if (inst.op == Op::SPLIT) {
+        stack_.push_back(inst.alt);
+        pc = inst.arg;
+      } else if (inst.op == Op::SAVE) {
+        ++pc;
+      } else if (inst.op == Op::ASSERT) {
+        auto a = static_cast<Assertion>(inst.arg);
+        if (a == Assertion::BEGIN_TEXT && atBegin) {
+          ++pc;
+        } else if (a == Assertion::END_TEXT && atEnd) {
+          ++pc;
+        } else {
+          // the end may be reached later
+          if (a == Assertion::END_TEXT)
+            list_.push_back(pc);
+          break;
+        }
+      } else if (inst.op == Op::FAIL) {
+        break;
+      } else {
+        list_.push_back(pc);
+        if (inst.op == Op::MATCH && !longest_) {
+          // threads with lower priority are cut off
+          cut = true;
+          stack_.clear();
+          return;
+        }
+        break;
+      }
+    }
+  }
+}
+
+uint32_t LazyDfa::intern() {
+  if (list_.empty())
+    return dead;
+  std::string key(reinterpret_cast<const char *>(list_.data()),
+                  list_.size() * sizeof(uint32_t));
+  auto found = ids_.find(key);
+  if (found != ids_.end())
+    return found->second;
+
+  size_t stride = representative_.size();
+  size_t cost = 2 * key.size() + stride * sizeof(uint32_t) + sizeof(State) + 64;
+  if (memory_ + cost > cacheSize_ && !states_.empty())
+    return unknown;
+  memory_ += cost;
+
+  bool match = false;
+  for (uint32_t pc : list_) {
+    if (pc != restart_ && program_.insts[pc].op == Op::MATCH)
+      match = true;
+  }
+  uint32_t id = static_cast<uint32_t>(states_.size());
+  states_.push_back(State{static_cast<uint32_t>(pcs_.size()),
+                          static_cast<uint32_t>(list_.size()), match});
+  pcs_.insert(pcs_.end(), list_.begin(), list_.end());
+  transitions_.resize(transitions_.size() + stride, unknown);
+  ids_.emplace(std::move(key), id);
+  return id;
+}
+
+bool LazyDfa::flush() {
+  if (scanned_ < minBytesPerState * states_.size())
+    return false;
+  ++flushes_;
+  states_.clear();
+  pcs_.clear();
+  transitions_.clear();
+  ids_.clear();
+  start_[0] = start_[1] = unknown;
+  memory_ = 0;
+  scanned_ = 0;
+  return true;
+}
+
+uint32_t LazyDfa::start_state(bool atBegin) {
+  if (start_[atBegin] != unknown)
+    return start_[atBegin];
+  clear_list();
+  bool cut = false;
+  closure(0, atBegin, false, cut);
+  if (!anchored_ && !cut)
+    list_.push_back(restart_);
+  uint32_t s = intern();
+  if (s == unknown) {
+    if (!flush())
+      return unknown;
+    s = intern();
+  }
+  start_[atBegin] = s;
+  return s;
+}
+
+uint32_t LazyDfa::transition(uint32_t state, uint16_t byteClass) {
+  // the threads are copied, the cache may be flushed
+  const State &s = states_[state];
+  threads_.assign(pcs_.begin() + s.begin, pcs_.begin() + s.begin + s.size);
+  unsigned char c = representative_[byteClass];
+
+  clear_list();
+  bool cut = false;
+  for (uint32_t pc : threads_) {
+    if (cut)
+      break;
+    if (pc == restart_) {
+      closure(0, false, false, cut);
+      if (!cut)
+        list_.push_back(restart_);
+      continue;
+    }
+    const Inst &inst = program_.insts[pc];
+    bool consumes =
+        inst.op == Op::ANY || (inst.op == Op::BYTE && inst.arg == c) ||
+        (inst.op == Op::CLASS && program_.classes[inst.arg].test(c));
+    if (consumes)
+      closure(pc + 1, false, false, cut);
+  }
+
+  uint32_t next = intern();
+  if (next == unknown) {
+    // the transition of the flushed state is not recorded
+    if (!flush())
+      return unknown;
+    return intern();
+  }
+  transitions_[state * representative_.size() + byteClass] = next;
+  return next;
+}
+
+bool LazyDfa::matches_at_end(uint32_t state, bool atBegin) {
+  const State &s = states_[state];
+  if (s.match)
+    return true;
+  threads_.assign(pcs_.begin() + s.begin, pcs_.begin() + s.begin + s.size);
+  clear_list();
+  bool cut = false;
+  for (uint32_t pc : threads_) {
+    if (pc != restart_ && program_.insts[pc].op == Op::ASSERT)
+      closure(pc + 1, atBegin, true, cut);
+  }
+  return std::any_of(list_.begin(), list_.end(), [this](uint32_t pc) {
+    return program_.insts[pc].op == Op::MATCH;
+  });
+}
+
+LazyDfa::Result LazyDfa::scan(std::string_view text, size_t position,
+                              int step, bool earliest, size_t &last) {
+  bool forward = step > 0;
+  bool atBegin = forward ? position == 0 : position == text.size();
+  size_t end = forward ? text.size() : 0;
+  const unsigned char *bytes =
+      reinterpret_cast<const unsigned char *>(text.data());
+  // reversed programs read the byte before the position
+  if (!forward)
+    --bytes;
+
+  uint32_t s = start_state(atBegin);
+  if (s == unknown)
+    return Result::GAVE_UP;
+  if (s == dead)
+    return Result::NO_MATCH;
+  bool found = false;
+  if (states_[s].match) {
+    found = true;
+    last = position;
+    if (earliest)
+      return Result::MATCH;
+  }
+  size_t stride = representative_.size();
+  while (position != end) {
+    uint16_t byteClass = byteClass_[bytes[position]];
+    uint32_t next = transitions_[s * stride + byteClass];
+    if (next == unknown) {
+      next = transition(s, byteClass);
+      if (next == unknown)
+        return Result::GAVE_UP;
+    }
+    position += step;
+    ++scanned_;
+    if (next == dead)
+      return found ? Result::MATCH : Result::NO_MATCH;
+    s = next;
+    if (states_[s].match) {
+      found = true;
+      last = position;
+      if (earliest)
+        return Result::MATCH;
+    }
+  }
+  if (matches_at_end(s, atBegin && text.empty())) {
+    found = true;
+    last = position;
+  }
+  return found ? Result::MATCH : Result::NO_MATCH;
+}
+
+LazyDfa::Result LazyDfa::forward(std::string_view text, bool earliest,
+                                 size_t &end) {
+  return scan(text, 0, 1, earliest, end);
+}
+
+LazyDfa::Result LazyDfa::reverse(std::string_view text, size_t from,
+                                 size_t &begin) {
+  return scan(text, from, -1, false, begin);
+}
+
+LazyDfa::Tables LazyDfa::tables(size_t maxStates) {
+  // a flush would renumber the states
+  size_t flushes = flushes_;
+  Tables t;
+  std::copy(byteClass_, byteClass_ + 256, t.byteClass);
+  t.classCount = representative_.size();
+  t.start = start_state(true);
+  if (t.start == unknown || flushes != flushes_)
+    throw SemanticError("The DFA of the pattern does not fit its cache.");
+  t.emptyMatch = t.start != dead && matches_at_end(t.start, true);
+  if (t.start == dead) {
+    t.start = Tables::dead;
+    return t;
+  }
+
+  // states are numbered in the order they are found
+  for (uint32_t s = 0; s < states_.size(); ++s) {
+    for (uint16_t c = 0; c < t.classCount; ++c) {
+      uint32_t next = transitions_[s * t.classCount + c];
+      if (next == unknown)
+        next = transition(s, c);
+      if (next == unknown || flushes != flushes_)
+        throw SemanticError("The DFA of the pattern does not fit its cache.");
+      if (states_.size() > maxStates)
+        throw SemanticError("The DFA of the pattern has more than " +
+                            std::to_string(maxStates) + " states.");
+      t.transitions.push_back(next == dead ? Tables::dead : next);
+    }
+  }
+  for (uint32_t s = 0; s < states_.size(); ++s) {
+    t.match.push_back(states_[s].match);
+    t.matchAtEnd.push_back(matches_at_end(s, false));
+  }
+  return t;
+}
+
+}  // namespace reon
+
+/*** End of file reon_dfa.cpp ***/
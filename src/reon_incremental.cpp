@@ -0,0 +1,300 @@
+/**
+\file reon_incremental.cpp
+\brief Implements the incremental translation of reon.
+\author Radek Vít
+*/
+#include <reon_incremental.h>
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+
+namespace reon {
+
+namespace {
+
+/**
+\brief Replaces the elements first to last of v. The elements after them
+move only if the number of elements changes.
+*/
+template <typename T, typename Iterator>
+void splice(vector<T> &v, size_t first, size_t last, Iterator begin,
+            Iterator end) {
+  for (; first < last && begin != end; ++first, ++begin) {
+    v[first] = *begin;
+  }
+  if (first < last)
+    v.erase(v.begin() + first, v.begin() + last);
+  else
+    v.insert(v.begin() + first, begin, end);
+}
+
+}  // namespace
+
+IncrementalTranslation::IncrementalTranslation(ReonOutput::Target target,
+                                               std::string variable)
+    : ReonTranslation(std::make_unique<ReonLexer>(),
+                      std::make_unique<ReonOutput>(target,
+                                                   std::move(variable))) {}
+
+const std::string &IncrementalTranslation::set_text(std::string text) {
+  text_ = std::move(text);
+  rebuild();
+  rewrite();
+  return output();
+}
+
+const std::string &IncrementalTranslation::edit(
+    size_t offset, size_t length, std::string_view replacement) {
+  if (offset > text_.size())
+    throw std::out_of_range("Edit past the end of the document.");
+  length = std::min(length, text_.size() - offset);
+  text_.replace(offset, length, replacement.data(), replacement.size());
+  std::ptrdiff_t delta = static_cast<std::ptrdiff_t>(replacement.size()) -
+                         static_cast<std::ptrdiff_t>(length);
+  // a failed translation leaves nothing to update
+  if (!valid_ || !update(offset, offset + length, delta))
+    rebuild();
+  rewrite();
+  return output();
+}
+
+void IncrementalTranslation::rebuild() {
+  valid_ = false;
+  reparsed_ = text_.size();
+  lexer_->set_string(text_);
+  parse_input(reonStart, 0);
+  symbols_.swap(parsedSymbols_);
+  values_.swap(parsedValues_);
+  output_range(symbols_, 0, symbols_.size(), fragment_, fragmentOffsets_);
+  generated_.swap(fragment_);
+  offsets_.swap(fragmentOffsets_);
+  valid_ = true;
+}
+
+void IncrementalTranslation::parse_input(NonterminalId start, size_t base) {
+  nodes_.clear();
+  stack_.clear();
+  parsedValues_.clear();
+
+  nodes_.push_back(
+      OutputNode{RuleSymbol{true, static_cast<uint8_t>(start)}, false, {},
+                 noNode});
+  stack_.push_back(StackEntry{nodes_.back().symbol, 0, {}, 0});
+
+  // innermost value being parsed and the end of the last matched token
+  uint32_t open = noValue;
+  size_t end = 0;
+  ReonToken token = lexer_->get_token();
+  while (!stack_.empty()) {
+    StackEntry top = stack_.back();
+    stack_.pop_back();
+    if (!top.symbol.nonterminal) {
+      if (top.symbol.id != static_cast<uint8_t>(token.id))
+        syntax_error(token.id, top);
+      for (uint8_t i = 0; i < top.targetCount; ++i) {
+        nodes_[top.targets[i]].attribute = token.attribute;
+      }
+      end = lexer_->token_end();
+      token = lexer_->get_token();
+      continue;
+    }
+    if (top.symbol.id == valueEnd) {
+      Value &v = parsedValues_[top.node];
+      v.end = base + end;
+      open = v.parent;
+      continue;
+    }
+    uint8_t rule =
+        reonTable.rule(static_cast<NonterminalId>(top.symbol.id), token.id);
+    if (rule == LLTable::noRule)
+      syntax_error(token.id, top);
+    if (top.symbol.id == static_cast<uint8_t>(NonterminalId::REFULL)) {
+      // the value ends when the entry below its rule is popped
+      uint32_t v = static_cast<uint32_t>(parsedValues_.size());
+      parsedValues_.push_back(Value{base + lexer_->token_start(), 0, 0, 0,
+                                    open, false, top.node,
+                                    nodes_[top.node].next});
+      open = v;
+      stack_.push_back(StackEntry{RuleSymbol{true, valueEnd}, v, {}, 0});
+    }
+    expand(top, reonGrammar[rule]);
+  }
+  if (token.id != TerminalId::EOI) {
+    StackEntry eof{RuleSymbol{false, static_cast<uint8_t>(TerminalId::EOI)},
+                   noNode, {}, 0};
+    syntax_error(token.id, eof);
+  }
+
+  parsedSymbols_.clear();
+  nodeSymbols_.resize(nodes_.size());
+  nodeChecks_.resize(nodes_.size());
+  uint32_t checks = 0;
+  for (uint32_t i = 0; i != noNode; i = nodes_[i].next) {
+    const OutputNode &n = nodes_[i];
+    nodeSymbols_[i] = static_cast<uint32_t>(parsedSymbols_.size());
+    nodeChecks_[i] = checks;
+    if (n.empty)
+      continue;
+    auto id = static_cast<OutputId>(n.symbol.id);
+    if (id == OutputId::FIXED_LENGTH_CHECK)
+      ++checks;
+    else if (id == OutputId::END_CHECK)
+      --checks;
+    parsedSymbols_.push_back(Symbol{id, std::string(n.attribute)});
+  }
+  for (Value &v : parsedValues_) {
+    v.symbolBegin = nodeSymbols_[v.node];
+    v.symbolEnd =
+        v.after == noNode ? parsedSymbols_.size() : nodeSymbols_[v.after];
+    v.inLookbehind = nodeChecks_[v.node] > 0;
+  }
+}
+
+bool IncrementalTranslation::update(size_t begin, size_t end,
+                                    std::ptrdiff_t delta) {
+  // the last value beginning before the edit or one of its ancestors encloses
+  // the edit without its first and last character
+  auto next = std::partition_point(
+      values_.begin(), values_.end(),
+      [begin](const Value &v) { return v.begin < begin; });
+  if (next == values_.begin())
+    return false;
+  uint32_t v = static_cast<uint32_t>(next - values_.begin() - 1);
+  while (v != noValue && values_[v].end <= end) {
+    v = values_[v].parent;
+  }
+  if (v == noValue)
+    return false;
+  const Value old = values_[v];
+  size_t subtreeEnd =
+      std::partition_point(
+          values_.begin() + v + 1, values_.end(),
+          [&old](const Value &d) { return d.begin < old.end; }) -
+      values_.begin();
+
+  // tokens around the value are unchanged, so the value lexes the same on its
+  // own; edits that do not leave a single value are translated as a whole
+  size_t newEnd = old.end + delta;
+  reparsed_ = newEnd - old.begin;
+  try {
+    lexer_->set_string(
+        std::string_view(text_).substr(old.begin, newEnd - old.begin));
+    parse_input(NonterminalId::REFULL, old.begin);
+  } catch (TranslationError &) {
+    return false;
+  }
+
+  valid_ = false;
+  bool whole = old.inLookbehind ||
+               checked(symbols_, old.symbolBegin, old.symbolEnd) ||
+               checked(parsedSymbols_, 0, parsedSymbols_.size());
+  if (!whole) {
+    output_range(parsedSymbols_, 0, parsedSymbols_.size(), fragment_,
+                 fragmentOffsets_);
+  }
+
+  std::ptrdiff_t symbolDelta =
+      static_cast<std::ptrdiff_t>(parsedSymbols_.size()) -
+      static_cast<std::ptrdiff_t>(old.symbolEnd - old.symbolBegin);
+  std::ptrdiff_t valueDelta =
+      static_cast<std::ptrdiff_t>(parsedValues_.size()) -
+      static_cast<std::ptrdiff_t>(subtreeEnd - v);
+  for (size_t i = 0; i < parsedValues_.size(); ++i) {
+    Value &p = parsedValues_[i];
+    p.symbolBegin += old.symbolBegin;
+    p.symbolEnd += old.symbolBegin;
+    p.parent = i == 0 ? old.parent : p.parent + v;
+    p.inLookbehind = p.inLookbehind || old.inLookbehind;
+  }
+  for (size_t i = subtreeEnd; i < values_.size(); ++i) {
+    Value &later = values_[i];
+    later.begin += delta;
+    later.end += delta;
+    later.symbolBegin += symbolDelta;
+    later.symbolEnd += symbolDelta;
+    if (later.parent != noValue && later.parent >= subtreeEnd)
+      later.parent += valueDelta;
+  }
+  for (uint32_t a = old.parent; a != noValue; a = values_[a].parent) {
+    values_[a].end += delta;
+    values_[a].symbolEnd += symbolDelta;
+  }
+  splice(values_, v, subtreeEnd, parsedValues_.begin(), parsedValues_.end());
+  splice(symbols_, old.symbolBegin, old.symbolEnd,
+         std::make_move_iterator(parsedSymbols_.begin()),
+         std::make_move_iterator(parsedSymbols_.end()));
+
+  if (whole) {
+    output_range(symbols_, 0, symbols_.size(), fragment_, fragmentOffsets_);
+    generated_.swap(fragment_);
+    offsets_.swap(fragmentOffsets_);
+    valid_ = true;
+    return true;
+  }
+  size_t outputBegin = offsets_[old.symbolBegin];
+  size_t outputEnd = offsets_[old.symbolEnd];
+  std::ptrdiff_t outputDelta = static_cast<std::ptrdiff_t>(fragment_.size()) -
+                               static_cast<std::ptrdiff_t>(outputEnd -
+                                                           outputBegin);
+  generated_.replace(outputBegin, outputEnd - outputBegin, fragment_);
+  for (size_t i = old.symbolEnd; i < offsets_.size(); ++i) {
+    offsets_[i] += outputDelta;
+  }
+  // the offset past the fragment is the offset of the following symbol
+  fragmentOffsets_.pop_back();
+  for (size_t &offset : fragmentOffsets_) {
+    offset += outputBegin;
+  }
+  splice(offsets_, old.symbolBegin, old.symbolEnd, fragmentOffsets_.begin(),
+         fragmentOffsets_.end());
+  valid_ = true;
+  return true;
+}
+
+void IncrementalTranslation::rewrite() {
+  if (!passManager_.any_enabled())
+    return;
+  views_.clear();
+  for (auto &s : symbols_) {
+    views_.push_back(ReonSymbol{s.id, s.attribute});
+  }
+  passManager_.run(views_, ast_);
+  result_.clear();
+  output_->set_output(result_);
+  output_->output(views_.begin(), views_.end());
+}
+
+void IncrementalTranslation::output_range(const vector<Symbol> &symbols,
+                                          size_t first, size_t last,
+                                          std::string &output,
+                                          vector<size_t> &offsets) {
+  views_.clear();
+  for (size_t i = first; i < last; ++i) {
+    views_.push_back(ReonSymbol{symbols[i].id, symbols[i].attribute});
+  }
+  output.clear();
+  offsets.clear();
+  output_->set_output(output);
+  output_->output(views_.begin(), views_.end(),
+                  [&offsets](size_t offset) { offsets.push_back(offset); });
+}
+
+bool IncrementalTranslation::checked(const vector<Symbol> &symbols,
+                                     size_t first, size_t last) {
+  for (size_t i = first; i < last; ++i) {
+    switch (symbols[i].id) {
+      case OutputId::GROUP:
+      case OutputId::NAMED_GROUP:
+      case OutputId::REF:
+      case OutputId::NREF:
+        return true;
+      default:
+        break;
+    }
+  }
+  return false;
+}
+
+}  // namespace reon
+
+/*** End of file reon_incremental.cpp ***/
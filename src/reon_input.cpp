@@ -0,0 +1,116 @@
+/**
+\file reon_input.cpp
+\brief Implements contiguous input buffers for reon lexical analysis.
+\author Radek Vít
+*/
+#include <reon_input.h>
+#include <fstream>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define REON_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+void InputBuffer::release() {
+#ifdef REON_MMAP
+  if (mapping_)
+    munmap(mapping_, mappingSize_);
+#endif
+  mapping_ = nullptr;
+  mappingSize_ = 0;
+  storage_.clear();
+  data_ = "";
+  size_ = 0;
+}
+
+void InputBuffer::set_view(const char *data, size_t size) {
+  release();
+  data_ = data;
+  size_ = size;
+}
+
+void InputBuffer::use_storage() {
+  // growth by doubling may leave up to twice the input size allocated
+  if (storage_.capacity() > storage_.size() + storage_.size() / 8)
+    storage_.shrink_to_fit();
+  data_ = storage_.data();
+  size_ = storage_.size();
+}
+
+void InputBuffer::read_stream(std::istream &is) {
+  release();
+  size_t read = 0;
+  while (is) {
+    storage_.resize(read + chunkSize);
+    is.read(&storage_[read], chunkSize);
+    read += is.gcount();
+  }
+  storage_.resize(read);
+  use_storage();
+}
+
+#ifdef REON_MMAP
+
+void InputBuffer::open_file(const std::string &path) {
+  release();
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    throw std::invalid_argument("Could not open file " + path +
+                                " for input.");
+  struct stat info;
+  bool regular = fstat(fd, &info) == 0 && S_ISREG(info.st_mode);
+  if (regular && info.st_size > 0) {
+    size_t size = static_cast<size_t>(info.st_size);
+    void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping != MAP_FAILED) {
+      madvise(mapping, size, MADV_SEQUENTIAL);
+      close(fd);
+      mapping_ = mapping;
+      mappingSize_ = size;
+      data_ = static_cast<const char *>(mapping);
+      size_ = size;
+      return;
+    }
+  }
+  // pipes, character devices and unmappable files are read in chunks
+  if (regular)
+    storage_.reserve(static_cast<size_t>(info.st_size));
+  size_t read = 0;
+  while (1) {
+    if (storage_.size() < read + chunkSize)
+      storage_.resize(read + chunkSize);
+    ssize_t count = ::read(fd, &storage_[read], chunkSize);
+    if (count < 0) {
+      if (errno == EINTR)
+        continue;
+      close(fd);
+      release();
+      throw std::invalid_argument("Could not read file " + path + ".");
+    }
+    if (count == 0)
+      break;
+    read += static_cast<size_t>(count);
+  }
+  close(fd);
+  storage_.resize(read);
+  use_storage();
+}
+
+#else
+
+void InputBuffer::open_file(const std::string &path) {
+  std::ifstream file{path, std::ios::binary};
+  if (file.fail())
+    throw std::invalid_argument("Could not open file " + path +
+                                " for input.");
+  read_stream(file);
+}
+
+#endif
+
+/*** End of file reon_input.cpp ***/
@@ -0,0 +1,158 @@
+/**
+\file reon_length.cpp
+\brief Implements the analysis of the length of matches of reon patterns.
+\author Radek Vít
+*/
+#include <reon_length.h>
+#include <algorithm>
+
+namespace reon {
+
+namespace {
+
+/**
+\brief Bounds of a subtree; min is noMatch if the subtree never matches.
+*/
+struct Bounds {
+  uint64_t min;
+  uint64_t max;
+  bool unbounded;
+};
+
+constexpr uint64_t noMatch = UINT64_MAX;
+
+uint64_t saturated(uint64_t x) { return std::min(x, maxMatchLength); }
+
+/**
+\brief Adds bounds of subtrees matched one after another.
+*/
+Bounds concatenate(Bounds a, Bounds b) {
+  if (a.min == noMatch || b.min == noMatch)
+    return Bounds{noMatch, 0, false};
+  Bounds r{saturated(a.min + b.min), a.max + b.max,
+           a.unbounded || b.unbounded};
+  if (r.max > maxMatchLength)
+    r.unbounded = true;
+  return r;
+}
+
+/**
+\brief Merges bounds of alternatives.
+*/
+Bounds either(Bounds a, Bounds b) {
+  if (a.min == noMatch)
+    return b;
+  if (b.min == noMatch)
+    return a;
+  return Bounds{std::min(a.min, b.min), std::max(a.max, b.max),
+                a.unbounded || b.unbounded};
+}
+
+/**
+\brief Returns the number of characters a 're' terminal matches.
+*/
+uint64_t literal_length(std::string_view a) {
+  uint64_t length = 0;
+  for (size_t i = 0; i < a.size(); ++i) {
+    // UTF-8 sequences are a single character
+    if ((static_cast<unsigned char>(a[i]) & 0xC0) == 0x80)
+      continue;
+    if (a[i] == '\\' && i + 1 < a.size() &&
+        std::string_view("A^Z$bB").find(a[++i]) != std::string_view::npos)
+      continue;
+    ++length;
+  }
+  return length;
+}
+
+class Analyzer {
+ public:
+  explicit Analyzer(const Ast &ast) : ast_(ast) {}
+
+  Bounds bounds(uint32_t n) {
+    const AstNode &a = ast_[n];
+    switch (a.kind) {
+      case AstKind::SEQUENCE: {
+        Bounds r{0, 0, false};
+        for (uint32_t c = a.first; c != Ast::none; c = ast_[c].next) {
+          r = concatenate(r, bounds(c));
+        }
+        return r;
+      }
+      case AstKind::ALTERNATION: {
+        Bounds r{noMatch, 0, false};
+        for (uint32_t c = a.first; c != Ast::none; c = ast_[c].next) {
+          r = either(r, bounds(c));
+        }
+        return r;
+      }
+      case AstKind::REPEAT:
+        return repeat(bounds(a.first), repeat_bounds(a.text));
+      case AstKind::LITERAL: {
+        uint64_t length = saturated(literal_length(a.text));
+        return Bounds{length, length, false};
+      }
+      case AstKind::SET:
+        return Bounds{1, 1, false};
+      case AstKind::GROUP:
+        return bounds(a.first);
+      case AstKind::REFERENCE:
+        return Bounds{0, 0, true};
+      case AstKind::CONDITIONAL: {
+        Bounds r = bounds(a.first);
+        uint32_t otherwise = ast_[a.first].next;
+        return either(r, otherwise == Ast::none ? Bounds{0, 0, false}
+                                                : bounds(otherwise));
+      }
+      case AstKind::NEVER:
+        return Bounds{noMatch, 0, false};
+      case AstKind::LOOKAROUND:
+      case AstKind::COMMENT:
+        return Bounds{0, 0, false};
+    }
+    return Bounds{0, 0, true};
+  }
+
+ protected:
+  const Ast &ast_;
+
+  static Bounds repeat(Bounds child, RepeatBounds count) {
+    if (child.min == noMatch) {
+      // only zero repetitions match
+      return count.min == 0 ? Bounds{0, 0, false} : child;
+    }
+    // repetitions of empty matches are empty
+    if (child.max == 0 && !child.unbounded)
+      return Bounds{0, 0, false};
+    // both minimums are at most UINT32_MAX, so the product does not overflow;
+    // maximums of unbounded bounds are not used
+    Bounds r{saturated(child.min * count.min), child.max * count.max,
+             child.unbounded || count.unbounded};
+    if (r.max > maxMatchLength)
+      r.unbounded = true;
+    return r;
+  }
+};
+
+}  // namespace
+
+MatchLength match_length(const Ast &ast) {
+  if (ast.root() == Ast::none)
+    return MatchLength{0, 0, false};
+  Bounds b = Analyzer(ast).bounds(ast.root());
+  if (b.min == noMatch)
+    return MatchLength{0, 0, false};
+  if (b.unbounded)
+    return MatchLength{b.min, 0, true};
+  return MatchLength{b.min, b.max, false};
+}
+
+MatchLength match_length(const std::vector<ReonSymbol> &symbols, Ast &ast) {
+  if (!build_ast(symbols, ast))
+    return MatchLength{0, 0, true};
+  return match_length(ast);
+}
+
+}  // namespace reon
+
+/*** End of file reon_length.cpp ***/
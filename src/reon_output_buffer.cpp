@@ -0,0 +1,61 @@
+/**
+\file reon_output_buffer.cpp
+\brief Implements the buffered output sink for reon output generation.
+\author Radek Vít
+*/
+#include <reon_output_buffer.h>
+
+#if defined(__SSE2__)
+#define REON_SSE2 1
+#include <emmintrin.h>
+#endif
+
+void OutputBuffer::flush() {
+  if (!buffer_.empty())
+    sink(buffer_);
+  buffer_.clear();
+}
+
+size_t OutputBuffer::find_stop(std::string_view s, const EscapeTable &table) {
+  size_t i = 0;
+#ifdef REON_SSE2
+  __m128i stops[EscapeTable::maxStops];
+  for (uint8_t j = 0; j < table.stopCount; ++j) {
+    stops[j] = _mm_set1_epi8(table.stops[j]);
+  }
+  for (; i + 16 <= s.size(); i += 16) {
+    __m128i chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(s.data() + i));
+    __m128i hit = _mm_setzero_si128();
+    for (uint8_t j = 0; j < table.stopCount; ++j) {
+      hit = _mm_or_si128(hit, _mm_cmpeq_epi8(chunk, stops[j]));
+    }
+    int mask = _mm_movemask_epi8(hit);
+    if (mask)
+      return i + __builtin_ctz(static_cast<unsigned>(mask));
+  }
+#endif
+  for (; i < s.size(); ++i) {
+    if (table[s[i]] != EscapeClass::COPY)
+      return i;
+  }
+  return i;
+}
+
+size_t OutputBuffer::write_escaped(std::string_view s,
+                                   const EscapeTable &table) {
+  size_t i = 0;
+  while (i < s.size()) {
+    // copy the run of plain characters in bulk
+    size_t run = find_stop(s.substr(i), table);
+    write(s.substr(i, run));
+    i += run;
+    if (i == s.size() || table[s[i]] == EscapeClass::STOP)
+      break;
+    put('\\');
+    put(s[i++]);
+  }
+  return i;
+}
+
+/*** End of file reon_output_buffer.cpp ***/
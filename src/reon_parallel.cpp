@@ -0,0 +1,111 @@
+/**
+\file reon_parallel.cpp
+\brief Implements the work-stealing thread pool of batch translations.
+\author Radek Vít
+*/
+#include <reon_parallel.h>
+#include <atomic>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace reon {
+
+namespace {
+
+/**
+\brief Jobs waiting for a worker.
+*/
+struct Queue {
+  std::mutex mutex;
+  std::deque<size_t> jobs;
+
+  bool pop_front(size_t &job) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (jobs.empty())
+      return false;
+    job = jobs.front();
+    jobs.pop_front();
+    return true;
+  }
+
+  bool pop_back(size_t &job) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (jobs.empty())
+      return false;
+    job = jobs.back();
+    jobs.pop_back();
+    return true;
+  }
+};
+
+}  // namespace
+
+void parallel_for(size_t count, size_t threads,
+                  const std::function<void(size_t worker, size_t job)> &run) {
+  if (threads > count)
+    threads = count;
+  if (threads <= 1) {
+    for (size_t job = 0; job < count; ++job) {
+      run(0, job);
+    }
+    return;
+  }
+
+  std::unique_ptr<Queue[]> queues{new Queue[threads]};
+  for (size_t w = 0; w < threads; ++w) {
+    for (size_t job = w * count / threads; job < (w + 1) * count / threads;
+         ++job) {
+      queues[w].jobs.push_back(job);
+    }
+  }
+
+  std::atomic<bool> failed = false;
+  std::exception_ptr error;
+  std::mutex errorMutex;
+  auto work = [&](size_t w) {
+    size_t job;
+    while (!failed) {
+      bool found = queues[w].pop_front(job);
+      // no jobs are added, so a worker finding all queues empty is done
+      for (size_t i = 1; i < threads && !found; ++i) {
+        found = queues[(w + i) % threads].pop_back(job);
+      }
+      if (!found)
+        return;
+      try {
+        run(w, job);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        if (!error)
+          error = std::current_exception();
+        failed = true;
+      }
+    }
+  };
+
+  std::vector<std::thread> workers;
+  workers.reserve(threads - 1);
+  for (size_t w = 1; w < threads; ++w) {
+    try {
+      workers.emplace_back(work, w);
+    } catch (std::system_error &) {
+      // the jobs of workers that did not start are stolen
+      break;
+    }
+  }
+  work(0);
+  for (auto &worker : workers) {
+    worker.join();
+  }
+  if (error)
+    std::rethrow_exception(error);
+}
+
+}  // namespace reon
+
+/*** End of file reon_parallel.cpp ***/
@@ -0,0 +1,543 @@
+/**
+\file reon_passes.cpp
+\brief Implements the rewrite passes over reon ASTs and their manager.
+\author Radek Vít
+*/
+#include <reon_passes.h>
+#include <iomanip>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+namespace reon {
+
+namespace {
+
+/**
+\brief Replaces the children of a node.
+*/
+void set_children(Ast &ast, uint32_t n, const std::vector<uint32_t> &children) {
+  ast[n].first = ast[n].last = Ast::none;
+  for (uint32_t c : children) {
+    ast[c].next = Ast::none;
+    ast.append(n, c);
+  }
+}
+
+/**
+\brief Flattens a subtree.
+\returns The node replacing n.
+*/
+uint32_t flatten(Ast &ast, uint32_t n) {
+  std::vector<uint32_t> children;
+  bool sequence = ast[n].kind == AstKind::SEQUENCE;
+  for (uint32_t c = ast[n].first; c != Ast::none;) {
+    uint32_t next = ast[c].next;
+    uint32_t r = flatten(ast, c);
+    if (sequence && ast[r].kind == AstKind::SEQUENCE) {
+      // flattened sequences contain no sequences
+      for (uint32_t g = ast[r].first; g != Ast::none; g = ast[g].next) {
+        children.push_back(g);
+      }
+    } else {
+      children.push_back(r);
+    }
+    c = next;
+  }
+  if (sequence && children.size() == 1)
+    return children[0];
+  set_children(ast, n, children);
+  return n;
+}
+
+/**
+\brief Returns true if removing a subtree cannot change the outcome of the
+semantic checks: it holds only literals without escapes, never matching
+nodes, sequences and alternations. Groups are kept as well, as removing them
+would renumber the following groups.
+*/
+bool unchecked(const Ast &ast, uint32_t n) {
+  const AstNode &a = ast[n];
+  switch (a.kind) {
+    case AstKind::NEVER:
+      return true;
+    case AstKind::LITERAL:
+      return a.text.find('\\') == std::string_view::npos;
+    case AstKind::SEQUENCE:
+    case AstKind::ALTERNATION:
+      for (uint32_t c = a.first; c != Ast::none; c = ast[c].next) {
+        if (!unchecked(ast, c))
+          return false;
+      }
+      return true;
+    default:
+      return false;
+  }
+}
+
+/**
+\brief Returns true if a subtree can never match.
+*/
+bool never(const Ast &ast, uint32_t n) {
+  const AstNode &a = ast[n];
+  switch (a.kind) {
+    case AstKind::NEVER:
+      return true;
+    case AstKind::SEQUENCE:
+      for (uint32_t c = a.first; c != Ast::none; c = ast[c].next) {
+        if (never(ast, c))
+          return true;
+      }
+      return false;
+    case AstKind::ALTERNATION:
+      if (a.first == Ast::none)
+        return false;
+      for (uint32_t c = a.first; c != Ast::none; c = ast[c].next) {
+        if (!never(ast, c))
+          return false;
+      }
+      return true;
+    case AstKind::REPEAT:
+      return !optional_repeat(a.text) && never(ast, a.first);
+    case AstKind::GROUP:
+      return never(ast, a.first);
+    case AstKind::LOOKAROUND:
+      return !(a.flags & NEGATED) && never(ast, a.first);
+    default:
+      return false;
+  }
+}
+
+/**
+\brief Removes the alternatives that never match and whose removal does not
+change which documents are valid.
+*/
+void prune_never(Ast &ast, uint32_t n) {
+  // alternatives within lookbehinds are checked to have the same width
+  if (ast[n].kind == AstKind::LOOKAROUND && (ast[n].flags & BEHIND))
+    return;
+  for (uint32_t c = ast[n].first; c != Ast::none; c = ast[c].next) {
+    prune_never(ast, c);
+  }
+  if (ast[n].kind != AstKind::ALTERNATION)
+    return;
+  std::vector<uint32_t> kept;
+  size_t count = 0;
+  for (uint32_t c = ast[n].first; c != Ast::none; c = ast[c].next) {
+    ++count;
+    if (!never(ast, c) || !unchecked(ast, c))
+      kept.push_back(c);
+  }
+  if (kept.size() == count)
+    return;
+  if (kept.empty())
+    kept.push_back(ast.add(AstKind::NEVER));
+  set_children(ast, n, kept);
+}
+
+/**
+\brief Maximal nesting of the alternations a trie creates. Deeper keys are
+left as flat alternatives.
+*/
+constexpr size_t maxTrieDepth = 100;
+
+/**
+\brief Factors common prefixes and suffixes of literal alternatives.
+
+A key is an alternative made only of literals, split to atoms: characters
+and escape sequences, which must not be split.
+*/
+class TrieBuilder {
+ public:
+  explicit TrieBuilder(Ast &ast) : ast_(ast) {}
+
+  void factor(uint32_t n) {
+    const AstNode &a = ast_[n];
+    // lookbehinds must keep the fixed length of their alternatives
+    if (a.kind == AstKind::LOOKAROUND && (a.flags & BEHIND))
+      return;
+    for (uint32_t c = a.first; c != Ast::none; c = ast_[c].next) {
+      factor(c);
+    }
+    if (a.kind == AstKind::ALTERNATION)
+      alternation(n);
+  }
+
+ protected:
+  using Atoms = std::vector<std::string_view>;
+
+  Ast &ast_;
+  std::vector<Atoms> keys_;
+
+  /**
+  \brief Splits the literals of an alternative to atoms.
+  \returns False if the alternative is not a key.
+  */
+  bool split(uint32_t n, Atoms &atoms) const {
+    const AstNode &a = ast_[n];
+    if (a.kind == AstKind::SEQUENCE) {
+      for (uint32_t c = a.first; c != Ast::none; c = ast_[c].next) {
+        if (!split(c, atoms))
+          return false;
+      }
+      return true;
+    }
+    if (a.kind != AstKind::LITERAL)
+      return false;
+    std::string_view t = a.text;
+    for (size_t i = 0; i < t.size(); ++i) {
+      size_t length = t[i] == '\\' ? 2 : 1;
+      // a trailing backslash would escape the following literal
+      if (i + length > t.size())
+        return false;
+      atoms.push_back(t.substr(i, length));
+      i += length - 1;
+    }
+    return true;
+  }
+
+  /**
+  \brief Splits keys to groups by their atom at a position. Keys without the
+  atom form a single group of their own.
+  \returns The groups in the order of their first key.
+  */
+  std::vector<std::vector<size_t>> partition(const std::vector<size_t> &keys,
+                                             size_t at) const {
+    std::vector<std::vector<size_t>> groups;
+    std::unordered_map<std::string_view, size_t> index;
+    constexpr std::string_view ended{};
+    for (size_t k : keys) {
+      std::string_view atom = at < keys_[k].size() ? keys_[k][at] : ended;
+      auto [it, added] = index.emplace(atom, groups.size());
+      if (added)
+        groups.emplace_back();
+      groups[it->second].push_back(k);
+    }
+    return groups;
+  }
+
+  uint32_t literal(const Atoms &atoms, size_t from, size_t to) {
+    std::string text;
+    for (size_t i = from; i < to; ++i) {
+      text += atoms[i];
+    }
+    return ast_.add(AstKind::LITERAL, ast_.store(std::move(text)));
+  }
+
+  /**
+  \brief Builds the trie of keys sharing their atoms before a position.
+  */
+  uint32_t trie(const std::vector<size_t> &keys, size_t at, size_t depth) {
+    const Atoms &first = keys_[keys[0]];
+    size_t prefix = first.size();
+    for (size_t k : keys) {
+      size_t i = at;
+      while (i < prefix && i < keys_[k].size() && keys_[k][i] == first[i]) {
+        ++i;
+      }
+      prefix = i;
+    }
+    uint32_t alternation = ast_.add(AstKind::ALTERNATION);
+    std::vector<std::vector<size_t>> groups = partition(keys, prefix);
+    bool leaves = true;
+    for (auto &group : groups) {
+      leaves = leaves && group.size() == 1 && keys_[group[0]].size() > prefix;
+    }
+    size_t suffix = leaves ? common_suffix(groups, prefix) : 0;
+    for (auto &group : groups) {
+      const Atoms &atoms = keys_[group[0]];
+      if (atoms.size() == prefix) {
+        // keys ending here; duplicate keys are merged
+        ast_.append(alternation, ast_.add(AstKind::SEQUENCE));
+      } else if (group.size() == 1 || depth >= maxTrieDepth) {
+        for (size_t k : group) {
+          ast_.append(alternation, literal(keys_[k], prefix,
+                                           keys_[k].size() - suffix));
+        }
+      } else {
+        ast_.append(alternation, trie(group, prefix, depth + 1));
+      }
+    }
+    uint32_t n = ast_.add(AstKind::SEQUENCE);
+    if (prefix > at)
+      ast_.append(n, literal(first, at, prefix));
+    // identical keys leave a single empty alternative
+    if (groups.size() > 1)
+      ast_.append(n, alternation);
+    if (suffix)
+      ast_.append(n, literal(first, first.size() - suffix, first.size()));
+    return n;
+  }
+
+  /**
+  \brief Returns the number of atoms at the end of all single key groups in
+  common, never reaching into a prefix.
+  */
+  size_t common_suffix(const std::vector<std::vector<size_t>> &groups,
+                       size_t prefix) const {
+    const Atoms &first = keys_[groups[0][0]];
+    size_t suffix = first.size() - prefix;
+    for (auto &group : groups) {
+      const Atoms &atoms = keys_[group[0]];
+      size_t s = 0;
+      while (s < suffix && s < atoms.size() - prefix &&
+             atoms[atoms.size() - 1 - s] == first[first.size() - 1 - s]) {
+        ++s;
+      }
+      suffix = s;
+    }
+    return suffix;
+  }
+
+  void alternation(uint32_t n) {
+    keys_.clear();
+    std::vector<uint32_t> children;
+    std::vector<size_t> keyed;
+    for (uint32_t c = ast_[n].first; c != Ast::none; c = ast_[c].next) {
+      children.push_back(c);
+      keys_.emplace_back();
+      if (split(c, keys_.back()) && !keys_.back().empty())
+        keyed.push_back(keys_.size() - 1);
+    }
+    std::vector<std::vector<size_t>> groups = partition(keyed, 0);
+    if (groups.size() == keyed.size())
+      return;
+    // alternatives may be reordered: keys join the first key of their group
+    std::vector<uint32_t> factored(children.size(), Ast::none);
+    std::vector<bool> merged(children.size(), false);
+    for (auto &group : groups) {
+      if (group.size() == 1)
+        continue;
+      factored[group[0]] = trie(group, 0, 0);
+      for (size_t k : group) {
+        merged[k] = true;
+      }
+    }
+    std::vector<uint32_t> kept;
+    for (size_t i = 0; i < children.size(); ++i) {
+      if (factored[i] != Ast::none)
+        kept.push_back(factored[i]);
+      else if (!merged[i])
+        kept.push_back(children[i]);
+    }
+    set_children(ast_, n, kept);
+  }
+};
+
+/**
+\brief Returns true if a repeat applies to the whole node without a group:
+a single character or escape other than an assertion, a set, a capturing
+group or a reference.
+*/
+bool repeatable(const Ast &ast, uint32_t n) {
+  const AstNode &a = ast[n];
+  switch (a.kind) {
+    case AstKind::SET:
+    case AstKind::GROUP:
+    case AstKind::REFERENCE:
+      return true;
+    case AstKind::LITERAL: {
+      std::string_view t = a.text;
+      if (t.size() == 1)
+        return true;
+      return t.size() == 2 && t[0] == '\\' &&
+             std::string_view("A^Z$bB").find(t[1]) == std::string_view::npos;
+    }
+    default:
+      return false;
+  }
+}
+
+bool digit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+/**
+\brief Returns true if a bare repeat after a node would extend the node: a
+digit literal following a numbered reference changes the referenced group.
+*/
+bool extends(const Ast &ast, uint32_t previous, uint32_t repeat) {
+  const AstNode &p = ast[previous];
+  const AstNode &r = ast[repeat];
+  if (p.kind != AstKind::REFERENCE || p.text.empty() || !digit(p.text[0]))
+    return false;
+  if (r.kind != AstKind::REPEAT || !(r.flags & BARE))
+    return false;
+  const AstNode &operand = ast[r.first];
+  return operand.kind == AstKind::LITERAL && digit(operand.text[0]);
+}
+
+bool alternatives(const Ast &ast, uint32_t n) {
+  return ast[n].kind == AstKind::ALTERNATION && ast[n].first != Ast::none;
+}
+
+/**
+\brief Removes non-capturing groups from a subtree where precedence does not
+need them.
+\returns The node replacing n.
+*/
+uint32_t ungroup(Ast &ast, uint32_t n) {
+  std::vector<uint32_t> children;
+  AstKind kind = ast[n].kind;
+  for (uint32_t c = ast[n].first; c != Ast::none;) {
+    uint32_t next = ast[c].next;
+    uint32_t r = ungroup(ast, c);
+    if (kind == AstKind::SEQUENCE && ast[r].kind == AstKind::SEQUENCE) {
+      for (uint32_t g = ast[r].first; g != Ast::none; g = ast[g].next) {
+        children.push_back(g);
+      }
+    } else if (kind == AstKind::SEQUENCE &&
+               ast[r].kind == AstKind::ALTERNATION &&
+               ast[r].first == Ast::none) {
+      // outputs nothing
+    } else if (kind == AstKind::ALTERNATION && alternatives(ast, r)) {
+      // alternatives of alternatives
+      for (uint32_t g = ast[r].first; g != Ast::none; g = ast[g].next) {
+        children.push_back(g);
+      }
+    } else {
+      children.push_back(r);
+    }
+    c = next;
+  }
+  if ((kind == AstKind::SEQUENCE || kind == AstKind::ALTERNATION) &&
+      children.size() == 1)
+    return children[0];
+  if (kind == AstKind::SEQUENCE) {
+    for (size_t i = 1; i < children.size(); ++i) {
+      if (extends(ast, children[i - 1], children[i]))
+        ast[children[i]].flags &= ~BARE;
+    }
+  }
+  set_children(ast, n, children);
+  AstNode &a = ast[n];
+  bool ahead = kind == AstKind::LOOKAROUND && !(a.flags & BEHIND);
+  if (kind == AstKind::REPEAT &&
+      (repeatable(ast, a.first) || alternatives(ast, a.first)))
+    a.flags |= BARE;
+  else if ((kind == AstKind::GROUP || ahead) && alternatives(ast, a.first))
+    ast[a.first].flags |= BARE;
+  return n;
+}
+
+/**
+\brief Counts the nodes reachable from a node.
+*/
+size_t reachable(const Ast &ast, uint32_t n) {
+  size_t count = 1;
+  for (uint32_t c = ast[n].first; c != Ast::none; c = ast[c].next) {
+    count += reachable(ast, c);
+  }
+  return count;
+}
+
+}  // namespace
+
+void flatten_pass(Ast &ast) {
+  ast.set_root(flatten(ast, ast.root()));
+}
+
+void never_pass(Ast &ast) {
+  prune_never(ast, ast.root());
+}
+
+void trie_pass(Ast &ast) {
+  TrieBuilder(ast).factor(ast.root());
+}
+
+void groups_pass(Ast &ast) {
+  uint32_t root = ungroup(ast, ast.root());
+  if (alternatives(ast, root))
+    ast[root].flags |= BARE;
+  ast.set_root(root);
+}
+
+PassManager::PassManager() {
+  enable_all(true);
+}
+
+void PassManager::enable(std::string_view name, bool enabled) {
+  for (size_t i = 0; i < passCount; ++i) {
+    if (name == passes[i].name) {
+      enabled_[i] = enabled;
+      return;
+    }
+  }
+  throw std::invalid_argument("Unknown pass " + std::string(name) +
+                              ". Run with --list-passes for passes.");
+}
+
+void PassManager::enable_all(bool enabled) {
+  for (bool &e : enabled_) {
+    e = enabled;
+  }
+}
+
+bool PassManager::any_enabled() const {
+  for (bool e : enabled_) {
+    if (e)
+      return true;
+  }
+  return false;
+}
+
+void PassManager::run(std::vector<ReonSymbol> &symbols, Ast &ast) {
+  using Clock = std::chrono::steady_clock;
+  if (!any_enabled())
+    return;
+  ++runs_;
+  auto start = Clock::now();
+  bool built = build_ast(symbols, ast);
+  buildTime_ += Clock::now() - start;
+  if (!built)
+    return;
+  nodesBefore_ += reachable(ast, ast.root());
+  for (size_t i = 0; i < passCount; ++i) {
+    if (!enabled_[i])
+      continue;
+    start = Clock::now();
+    passes[i].run(ast);
+    passTime_[i] += Clock::now() - start;
+  }
+  nodesAfter_ += reachable(ast, ast.root());
+  start = Clock::now();
+  lower_ast(ast, symbols);
+  lowerTime_ += Clock::now() - start;
+}
+
+void PassManager::report(std::ostream &os) const {
+  auto line = [&os](const char *name, Duration time) {
+    double ms = std::chrono::duration<double, std::milli>(time).count();
+    os << std::left << std::setw(12) << name << std::right << std::fixed
+       << std::setprecision(3) << std::setw(12) << ms << " ms\n";
+  };
+  os << "Passes over " << runs_ << " patterns, " << nodesBefore_ << " -> "
+     << nodesAfter_ << " nodes:\n";
+  line("build", buildTime_);
+  for (size_t i = 0; i < passCount; ++i) {
+    if (enabled_[i])
+      line(passes[i].name, passTime_[i]);
+  }
+  line("lower", lowerTime_);
+}
+
+void PassManager::merge(const PassManager &other) {
+  for (size_t i = 0; i < passCount; ++i) {
+    passTime_[i] += other.passTime_[i];
+  }
+  buildTime_ += other.buildTime_;
+  lowerTime_ += other.lowerTime_;
+  runs_ += other.runs_;
+  nodesBefore_ += other.nodesBefore_;
+  nodesAfter_ += other.nodesAfter_;
+}
+
+void PassManager::list(std::ostream &os) {
+  for (auto &pass : passes) {
+    os << std::left << std::setw(12) << pass.name << pass.description << "\n";
+  }
+}
+
+}  // namespace reon
+
+/*** End of file reon_passes.cpp ***/
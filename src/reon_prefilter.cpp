@@ -0,0 +1,460 @@
+/**
+\file reon_prefilter.cpp
+\brief Implements the extraction of prefilters of reon patterns.
+\author Radek Vít
+*/
+#include <reon_prefilter.h>
+#include <algorithm>
+
+namespace reon {
+
+namespace {
+
+/**
+\brief What the matches of a subtree are known to contain.
+
+Exact subtrees always match text, and then prefix and suffix are text too.
+*/
+struct Facts {
+  bool exact = true;
+  std::string text{};
+  /**
+  \brief Every match begins with the prefix and ends with the suffix.
+  */
+  std::string prefix{};
+  std::string suffix{};
+  /**
+  \brief Literals every match contains.
+  */
+  std::vector<std::string> required{};
+  /**
+  \brief Bytes non-empty matches begin with.
+  */
+  ByteSet first{};
+  bool nullable = true;
+  bool never = false;
+};
+
+Facts never_facts() {
+  Facts f;
+  f.exact = false;
+  f.nullable = false;
+  f.never = true;
+  return f;
+}
+
+/**
+\brief Facts of a single character from a set of bytes.
+*/
+Facts byte_facts(const ByteSet &bytes) {
+  Facts f;
+  f.first = bytes;
+  f.nullable = false;
+  if (bytes.count() != 1) {
+    f.exact = false;
+    return f;
+  }
+  for (unsigned c = 0; c < 256; ++c) {
+    if (bytes.test(static_cast<unsigned char>(c)))
+      f.text.push_back(static_cast<char>(c));
+  }
+  f.prefix = f.suffix = f.text;
+  return f;
+}
+
+ByteSet all_bytes() {
+  ByteSet bytes;
+  bytes.invert();
+  return bytes;
+}
+
+void add(std::vector<std::string> &required, std::string literal) {
+  if (!literal.empty())
+    required.push_back(std::move(literal));
+}
+
+std::vector<std::string> reduce(std::vector<std::string> literals);
+
+/**
+\brief Cuts long literals to maxLiteralLength and keeps the number of
+required literals bounded.
+*/
+void trim(Facts &f) {
+  if (f.exact && f.text.size() > maxLiteralLength) {
+    f.exact = false;
+    f.text.clear();
+  }
+  if (f.prefix.size() > maxLiteralLength) {
+    f.prefix.resize(maxLiteralLength);
+    add(f.required, f.prefix);
+  }
+  if (f.suffix.size() > maxLiteralLength) {
+    f.suffix.erase(0, f.suffix.size() - maxLiteralLength);
+    add(f.required, f.suffix);
+  }
+  if (f.required.size() > 2 * maxRequiredLiterals)
+    f.required = reduce(std::move(f.required));
+}
+
+/**
+\brief Joins facts of a subtree matched after a.
+*/
+void append(Facts &a, const Facts &b) {
+  if (a.never || b.never) {
+    a = never_facts();
+    return;
+  }
+  bool exact = a.exact && b.exact;
+  // the end of a and the beginning of b are adjacent in every match
+  if (!exact)
+    add(a.required, a.suffix + b.prefix);
+  a.required.insert(a.required.end(), b.required.begin(), b.required.end());
+  // the prefix of exact facts is their text
+  if (a.exact)
+    a.prefix += b.prefix;
+  a.suffix = b.exact ? a.suffix + b.text : b.suffix;
+  if (exact)
+    a.text += b.text;
+  a.exact = exact;
+  if (a.nullable)
+    a.first.merge(b.first);
+  a.nullable = a.nullable && b.nullable;
+  trim(a);
+}
+
+/**
+\brief Returns the literals of a contained in a literal of b.
+*/
+std::vector<std::string> contained(const std::vector<std::string> &a,
+                                   const std::vector<std::string> &b) {
+  std::vector<std::string> r;
+  for (auto &x : a) {
+    for (auto &y : b) {
+      if (y.find(x) != std::string::npos) {
+        r.push_back(x);
+        break;
+      }
+    }
+  }
+  return r;
+}
+
+/**
+\brief Merges facts of alternatives.
+*/
+Facts either(const Facts &a, const Facts &b) {
+  if (a.never)
+    return b;
+  if (b.never)
+    return a;
+  Facts r;
+  r.exact = a.exact && b.exact && a.text == b.text;
+  if (r.exact)
+    r.text = a.text;
+  size_t p = 0;
+  while (p < a.prefix.size() && p < b.prefix.size() &&
+         a.prefix[p] == b.prefix[p]) {
+    ++p;
+  }
+  r.prefix = a.prefix.substr(0, p);
+  size_t s = 0;
+  while (s < a.suffix.size() && s < b.suffix.size() &&
+         a.suffix.rbegin()[s] == b.suffix.rbegin()[s]) {
+    ++s;
+  }
+  r.suffix = a.suffix.substr(a.suffix.size() - s);
+  // with their prefixes and suffixes, which are required too
+  std::vector<std::string> left = a.required;
+  add(left, a.prefix);
+  add(left, a.suffix);
+  std::vector<std::string> right = b.required;
+  add(right, b.prefix);
+  add(right, b.suffix);
+  r.required = contained(left, right);
+  std::vector<std::string> more = contained(right, left);
+  r.required.insert(r.required.end(), more.begin(), more.end());
+  r.first = a.first;
+  r.first.merge(b.first);
+  r.nullable = a.nullable || b.nullable;
+  return r;
+}
+
+class Extractor {
+ public:
+  explicit Extractor(const Ast &ast) : ast_(ast) {}
+
+  Facts facts(uint32_t n) {
+    const AstNode &a = ast_[n];
+    switch (a.kind) {
+      case AstKind::SEQUENCE: {
+        Facts r;
+        for (uint32_t c = a.first; c != Ast::none; c = ast_[c].next) {
+          append(r, facts(c));
+        }
+        return r;
+      }
+      case AstKind::ALTERNATION: {
+        // alternatives without children output nothing
+        if (a.first == Ast::none)
+          return Facts{};
+        Facts r = never_facts();
+        for (uint32_t c = a.first; c != Ast::none; c = ast_[c].next) {
+          r = either(r, facts(c));
+        }
+        return r;
+      }
+      case AstKind::REPEAT:
+        return repeat(facts(a.first), repeat_bounds(a.text));
+      case AstKind::LITERAL:
+        return literal(a.text);
+      case AstKind::SET:
+        return set(a);
+      case AstKind::GROUP:
+        return facts(a.first);
+      case AstKind::REFERENCE:
+        return unknown();
+      case AstKind::CONDITIONAL: {
+        Facts r = facts(a.first);
+        uint32_t otherwise = ast_[a.first].next;
+        return either(r, otherwise == Ast::none ? Facts{} : facts(otherwise));
+      }
+      case AstKind::NEVER:
+        return never_facts();
+      case AstKind::LOOKAROUND: {
+        if (a.flags & NEGATED)
+          return Facts{};
+        Facts child = facts(a.first);
+        if (child.never)
+          return child;
+        Facts r;
+        r.required = std::move(child.required);
+        add(r.required, child.prefix);
+        add(r.required, child.suffix);
+        return r;
+      }
+      case AstKind::COMMENT:
+        return Facts{};
+    }
+    return unknown();
+  }
+
+ protected:
+  const Ast &ast_;
+
+  /**
+  \brief Facts of a subtree that may match anything.
+  */
+  static Facts unknown() {
+    Facts f;
+    f.exact = false;
+    f.first = all_bytes();
+    return f;
+  }
+
+  /**
+  \brief Returns the bytes of \\d, \\s or \\w or their complements, with the
+  characters Python's Unicode classes add.
+  */
+  static ByteSet escape_bytes(char c) {
+    const char escape[] = {'\\', c};
+    ByteSet bytes = set_bytes(std::string_view(escape, 2));
+    bytes.set_range(0x80, 0xFF);
+    if (c == 's')
+      bytes.set_range(0x1C, 0x1F);
+    return bytes;
+  }
+
+  static Facts literal(std::string_view a) {
+    Facts r;
+    for (size_t i = 0; i < a.size(); ++i) {
+      ByteSet bytes;
+      if (a[i] != '\\' || i + 1 == a.size()) {
+        bytes.set(static_cast<unsigned char>(a[i]));
+        append(r, byte_facts(bytes));
+        continue;
+      }
+      char c = a[++i];
+      switch (c) {
+        case 'A':
+        case '^':
+        case 'Z':
+        case '$':
+        case 'b':
+        case 'B':
+          // assertions match no characters
+          continue;
+        case 'd':
+        case 'D':
+        case 's':
+        case 'S':
+        case 'w':
+        case 'W':
+          bytes = escape_bytes(c);
+          break;
+        case '.':
+          bytes = all_bytes();
+          break;
+        case 'f':
+          bytes.set('\f');
+          break;
+        case 'n':
+          bytes.set('\n');
+          break;
+        case 'r':
+          bytes.set('\r');
+          break;
+        case 't':
+          bytes.set('\t');
+          break;
+        case 'v':
+          bytes.set('\v');
+          break;
+        default:
+          bytes.set(static_cast<unsigned char>(c));
+          break;
+      }
+      append(r, byte_facts(bytes));
+    }
+    return r;
+  }
+
+  static Facts set(const AstNode &a) {
+    ByteSet bytes;
+    try {
+      bytes = set_bytes(a.text);
+    } catch (SemanticError &) {
+      // reported by the output; any byte keeps the prefilter correct
+      return byte_facts(all_bytes());
+    }
+    for (size_t i = 0; i + 1 < a.text.size(); ++i) {
+      if (a.text[i] != '\\')
+        continue;
+      char c = a.text[++i];
+      if (c == 'd' || c == 's' || c == 'w')
+        bytes.merge(escape_bytes(c));
+    }
+    if (a.flags & NEGATED)
+      bytes.invert();
+    return byte_facts(bytes);
+  }
+
+  static Facts repeat(Facts child, RepeatBounds count) {
+    if (child.never)
+      return count.min == 0 ? Facts{} : child;
+    if (count.min == 0) {
+      Facts r;
+      r.exact = false;
+      r.first = child.first;
+      return r;
+    }
+    // every repetition begins with the prefix and ends with the suffix
+    if (!child.exact || child.text.empty())
+      return child;
+    std::string text;
+    uint64_t repetitions = 0;
+    for (; repetitions < count.min && text.size() <= maxLiteralLength;
+         ++repetitions) {
+      text += child.text;
+    }
+    Facts r = std::move(child);
+    r.prefix = r.suffix = text;
+    if (repetitions == count.min && !count.unbounded &&
+        count.min == count.max) {
+      r.text = std::move(text);
+    } else {
+      r.exact = false;
+      r.text.clear();
+      add(r.required, std::move(text));
+    }
+    trim(r);
+    return r;
+  }
+};
+
+/**
+\brief Sorts literals by length, drops duplicates and literals contained in
+longer ones and keeps at most maxRequiredLiterals.
+*/
+std::vector<std::string> reduce(std::vector<std::string> literals) {
+  std::sort(literals.begin(), literals.end(),
+            [](const std::string &a, const std::string &b) {
+              return a.size() != b.size() ? a.size() > b.size() : a < b;
+            });
+  std::vector<std::string> r;
+  for (auto &l : literals) {
+    if (r.size() == maxRequiredLiterals)
+      break;
+    bool redundant = false;
+    for (auto &kept : r) {
+      if (kept.find(l) != std::string::npos) {
+        redundant = true;
+        break;
+      }
+    }
+    if (!redundant)
+      r.push_back(std::move(l));
+  }
+  return r;
+}
+
+}  // namespace
+
+bool Prefilter::accepts(std::string_view text, bool anchored) const {
+  if (never)
+    return false;
+  for (auto &literal : required) {
+    if (text.find(literal) == std::string_view::npos)
+      return false;
+  }
+  if (anyFirst)
+    return true;
+  if (anchored)
+    return !text.empty() && first.test(static_cast<unsigned char>(text[0]));
+  for (char c : text) {
+    if (first.test(static_cast<unsigned char>(c)))
+      return true;
+  }
+  return false;
+}
+
+bool Prefilter::ascii_first(std::string &chars) const {
+  if (anyFirst)
+    return false;
+  chars.clear();
+  for (unsigned c = 0; c < 256; ++c) {
+    if (!first.test(static_cast<unsigned char>(c)))
+      continue;
+    if (c >= 0x80)
+      return false;
+    chars.push_back(static_cast<char>(c));
+  }
+  return true;
+}
+
+Prefilter prefilter(const Ast &ast) {
+  Prefilter p;
+  if (ast.root() == Ast::none)
+    return p;
+  Facts f = Extractor(ast).facts(ast.root());
+  if (f.never) {
+    p.never = true;
+    p.anyFirst = false;
+    return p;
+  }
+  add(f.required, f.prefix);
+  add(f.required, f.suffix);
+  p.required = reduce(std::move(f.required));
+  p.first = f.first;
+  p.anyFirst = f.nullable || f.first.count() == 256;
+  return p;
+}
+
+Prefilter prefilter(const std::vector<ReonSymbol> &symbols, Ast &ast) {
+  if (!build_ast(symbols, ast))
+    return Prefilter{};
+  return prefilter(ast);
+}
+
+}  // namespace reon
+
+/*** End of file reon_prefilter.cpp ***/
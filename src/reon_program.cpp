@@ -0,0 +1,649 @@
+/**
+\file reon_program.cpp
+\brief Implements the compilation of reon output symbols to programs.
+\author Radek Vít
+*/
+#include <reon_program.h>
+#include <algorithm>
+#include <cctype>
+
+namespace reon {
+
+namespace {
+
+/**
+\brief Marks an unbounded repeat.
+*/
+constexpr size_t unbounded = SIZE_MAX;
+
+/**
+\brief Pattern tree built from output symbols.
+*/
+struct Node {
+  enum class Kind : uint8_t {
+    EMPTY,
+    NEVER,
+    BYTE,
+    CLASS,
+    ANY,
+    ASSERT,
+    CONCAT,
+    ALTERNATE,
+    REPEAT,
+    GROUP
+  };
+
+  Kind kind = Kind::EMPTY;
+  unsigned char byte = 0;
+  Assertion assertion = Assertion::BEGIN_TEXT;
+  ByteSet set{};
+  std::vector<Node> children{};
+  size_t min = 0;
+  size_t max = 0;
+  bool greedy = true;
+  size_t group = 0;
+
+  static Node of(Kind kind) {
+    Node n;
+    n.kind = kind;
+    return n;
+  }
+};
+
+/**
+\brief Returns the set of bytes matched by \\d, \\s or \\w, or their
+complements.
+*/
+ByteSet escape_class(char c) {
+  ByteSet set;
+  switch (c) {
+    case 'd':
+    case 'D':
+      set.set_range('0', '9');
+      break;
+    case 's':
+    case 'S':
+      set.set(' ');
+      set.set_range('\t', '\r');
+      break;
+    default:
+      for (unsigned b = 0; b < 256; ++b) {
+        if (is_word_byte(static_cast<unsigned char>(b)))
+          set.set(static_cast<unsigned char>(b));
+      }
+      break;
+  }
+  if (c == 'D' || c == 'S' || c == 'W')
+    set.invert();
+  return set;
+}
+
+/**
+\brief Returns the byte of an escaped control character, or 0 for other
+characters.
+*/
+unsigned char escape_control(char c) {
+  switch (c) {
+    case 'f':
+      return '\f';
+    case 'n':
+      return '\n';
+    case 'r':
+      return '\r';
+    case 't':
+      return '\t';
+    case 'v':
+      return '\v';
+    default:
+      return 0;
+  }
+}
+
+/**
+\brief Recursive descent parser of output symbols.
+
+The symbols form a Python regular expression; the parser follows the
+structure reonGrammar produces.
+*/
+class Parser {
+ public:
+  Parser(const std::vector<ReonSymbol> &symbols, Program &program)
+      : symbols_(symbols), program_(program) {}
+
+  Node parse() {
+    Node n = alternation();
+    if (position_ != symbols_.size())
+      throw SemanticError("Unbalanced groups in a compiled pattern.");
+    return n;
+  }
+
+ protected:
+  const std::vector<ReonSymbol> &symbols_;
+  Program &program_;
+  size_t position_ = 0;
+
+  bool at(OutputId id) const {
+    return position_ < symbols_.size() && symbols_[position_].id == id;
+  }
+
+  void expect(OutputId id) {
+    if (!at(id))
+      throw SemanticError("Unbalanced groups in a compiled pattern.");
+    ++position_;
+  }
+
+  Node alternation() {
+    Node first = sequence();
+    if (!at(OutputId::ALTERNATIVE))
+      return first;
+    Node n = Node::of(Node::Kind::ALTERNATE);
+    n.children.push_back(std::move(first));
+    while (at(OutputId::ALTERNATIVE)) {
+      ++position_;
+      n.children.push_back(sequence());
+    }
+    return n;
+  }
+
+  Node sequence() {
+    Node n = Node::of(Node::Kind::CONCAT);
+    while (position_ < symbols_.size() && !at(OutputId::ALTERNATIVE) &&
+           !at(OutputId::GROUP_CLOSE)) {
+      atom(n);
+      if (at(OutputId::REPEAT)) {
+        Node r = Node::of(Node::Kind::REPEAT);
+        repeat(symbols_[position_++].attribute, r);
+        if (at(OutputId::NON_GREEDY)) {
+          ++position_;
+          r.greedy = false;
+        }
+        if (n.children.empty())
+          throw SemanticError("Nothing to repeat in a compiled pattern.");
+        r.children.push_back(std::move(n.children.back()));
+        n.children.back() = std::move(r);
+      }
+    }
+    return n;
+  }
+
+  /**
+  \brief Parses a single element and appends it to a sequence.
+  */
+  void atom(Node &seq) {
+    const ReonSymbol &s = symbols_[position_++];
+    switch (s.id) {
+      case OutputId::RE:
+        return literal(s.attribute, seq);
+      case OutputId::NEVER:
+        seq.children.push_back(Node::of(Node::Kind::NEVER));
+        return;
+      case OutputId::NC_GROUP_OPEN: {
+        Node inner = alternation();
+        expect(OutputId::GROUP_CLOSE);
+        seq.children.push_back(std::move(inner));
+        return;
+      }
+      case OutputId::GROUP_OPEN:
+        return group(seq, program_.groupCount++);
+      case OutputId::NAMED_GROUP_OPEN: {
+        size_t number = program_.groupCount++;
+        if (!at(OutputId::NAMED_GROUP))
+          throw SemanticError("Unbalanced groups in a compiled pattern.");
+        named_group(symbols_[position_++].attribute, number);
+        expect(OutputId::NAMED_GROUP_NAME_END);
+        return group(seq, number);
+      }
+      case OutputId::SET_OPEN:
+      case OutputId::NSET_OPEN: {
+        Node n = Node::of(Node::Kind::CLASS);
+        if (at(OutputId::SET))
+          n.set = set(symbols_[position_++].attribute);
+        if (s.id == OutputId::NSET_OPEN)
+          n.set.invert();
+        expect(OutputId::SET_CLOSE);
+        seq.children.push_back(std::move(n));
+        return;
+      }
+      case OutputId::COMMENT_OPEN:
+        if (at(OutputId::COMMENT))
+          ++position_;
+        expect(OutputId::GROUP_CLOSE);
+        return;
+      case OutputId::BACKSLASH:
+      case OutputId::REF_OPEN:
+        throw SemanticError(
+            "Group references cannot be matched in linear time.");
+      case OutputId::LOOKAHEAD_OPEN:
+      case OutputId::NLOOKAHEAD_OPEN:
+      case OutputId::LOOKBEHIND_OPEN:
+      case OutputId::NLOOKBEHIND_OPEN:
+        throw SemanticError(
+            "Lookahead and lookbehind assertions cannot be matched in linear "
+            "time.");
+      case OutputId::CONDITION_OPEN:
+        throw SemanticError("Conditionals cannot be matched in linear time.");
+      default:
+        // the assignment and other symbols without meaning for matching
+        return;
+    }
+  }
+
+  void group(Node &seq, size_t number) {
+    if (at(OutputId::GROUP))
+      ++position_;
+    Node n = Node::of(Node::Kind::GROUP);
+    n.group = number;
+    n.children.push_back(alternation());
+    expect(OutputId::GROUP_CLOSE);
+    seq.children.push_back(std::move(n));
+  }
+
+  /**
+  \brief Validates and records a group name.
+  */
+  void named_group(std::string_view name, size_t number) {
+    if (name.empty())
+      throw SemanticError(
+          "Identifier of a named group cannot have a length of 0.");
+    for (char c : name) {
+      if (!is_word_byte(static_cast<unsigned char>(c)))
+        throw SemanticError("Identifier of a named group cannot contain " +
+                            string{c} + ".");
+    }
+    if (name[0] >= '0' && name[0] <= '9')
+      throw SemanticError("Identifier of a named group cannot start with " +
+                          string{name[0]} + ".");
+    for (auto &known : program_.groupNames) {
+      if (known.first == name)
+        throw SemanticError("Multiple definitions of a group with name " +
+                            string(name) + ".");
+    }
+    program_.groupNames.emplace_back(string(name), number);
+  }
+
+  /**
+  \brief Appends the elements of a 're' terminal.
+  */
+  void literal(std::string_view a, Node &seq) {
+    for (size_t i = 0; i < a.size(); ++i) {
+      Node n = Node::of(Node::Kind::BYTE);
+      n.byte = static_cast<unsigned char>(a[i]);
+      if (a[i] == '\\') {
+        if (++i == a.size())
+          break;
+        char c = a[i];
+        switch (c) {
+          case 'A':
+          case '^':
+            n = Node::of(Node::Kind::ASSERT);
+            n.assertion = Assertion::BEGIN_TEXT;
+            break;
+          case 'Z':
+          case '$':
+            n = Node::of(Node::Kind::ASSERT);
+            n.assertion = Assertion::END_TEXT;
+            break;
+          case 'b':
+          case 'B':
+            n = Node::of(Node::Kind::ASSERT);
+            n.assertion = c == 'b' ? Assertion::WORD_BOUNDARY
+                                   : Assertion::NOT_WORD_BOUNDARY;
+            program_.wordBoundaries = true;
+            break;
+          case 'd':
+          case 'D':
+          case 's':
+          case 'S':
+          case 'w':
+          case 'W':
+            n = Node::of(Node::Kind::CLASS);
+            n.set = escape_class(c);
+            break;
+          case '.':
+            n = Node::of(Node::Kind::ANY);
+            break;
+          case '\\':
+            n.byte = '\\';
+            break;
+          default:
+            n.byte = escape_control(c);
+            if (!n.byte)
+              throw SemanticError("Unknown escaped sequence \\" +
+                                  std::string{c} + ".");
+        }
+      }
+      seq.children.push_back(std::move(n));
+    }
+  }
+
+  /**
+  \brief A single character or class of a set.
+  */
+  struct SetItem {
+    bool literal = true;
+    unsigned char byte = 0;
+    ByteSet set{};
+  };
+
+  /**
+  \brief Reads a set item at position i of a and moves i past it.
+  */
+  static SetItem set_item(std::string_view a, size_t &i) {
+    SetItem item;
+    char c = a[i++];
+    item.byte = static_cast<unsigned char>(c);
+    if (c != '\\' || i == a.size())
+      return item;
+    c = a[i++];
+    item.byte = static_cast<unsigned char>(c);
+    switch (c) {
+      case 'd':
+      case 'D':
+      case 's':
+      case 'S':
+      case 'w':
+      case 'W':
+        item.literal = false;
+        item.set = escape_class(c);
+        break;
+      case 'a':
+        item.byte = '\a';
+        break;
+      case 'b':
+        item.byte = '\b';
+        break;
+      default:
+        if (escape_control(c)) {
+          item.byte = escape_control(c);
+        } else if (std::isalnum(static_cast<unsigned char>(c))) {
+          throw SemanticError("Unknown escaped sequence \\" + std::string{c} +
+                              " in a set.");
+        }
+    }
+    return item;
+  }
+
+  static void add_item(ByteSet &set, const SetItem &item) {
+    if (item.literal)
+      set.set(item.byte);
+    else
+      set.merge(item.set);
+  }
+
+ public:
+  /**
+  \brief Returns the bytes of a 'set' terminal.
+  */
+  static ByteSet set(std::string_view a) {
+    ByteSet result;
+    size_t i = 0;
+    while (i < a.size()) {
+      SetItem first = set_item(a, i);
+      if (i == a.size() || a[i] != '-') {
+        add_item(result, first);
+        continue;
+      }
+      if (++i == a.size()) {
+        // a trailing '-' is a character
+        add_item(result, first);
+        result.set('-');
+        break;
+      }
+      SetItem last = set_item(a, i);
+      if (!first.literal || !last.literal)
+        throw SemanticError("Invalid char range in a set.");
+      if (first.byte >= last.byte)
+        throw SemanticError("Invalid char range " +
+                            string{static_cast<char>(first.byte)} + "-" +
+                            string{static_cast<char>(last.byte)} + ".");
+      result.set_range(first.byte, last.byte);
+    }
+    return result;
+  }
+
+ protected:
+  /**
+  \brief Reads the bounds of a 'repeat' terminal.
+  */
+  static void repeat(std::string_view a, Node &n) {
+    if (a == "*" || a == "+" || a == "?") {
+      n.min = a == "+" ? 1 : 0;
+      n.max = a == "?" ? 1 : unbounded;
+      return;
+    }
+    size_t bounds[2] = {0, 0};
+    size_t count = 0;
+    bool range = false;
+    for (char c : a) {
+      if (c == '-') {
+        range = true;
+        continue;
+      }
+      size_t &b = bounds[range];
+      b = b * 10 + (c - '0');
+      if (b > maxRepeat)
+        throw SemanticError("Repeat counts larger than " +
+                            std::to_string(maxRepeat) +
+                            " cannot be compiled.");
+      if (range)
+        ++count;
+    }
+    n.min = bounds[0];
+    n.max = !range ? bounds[0] : count ? bounds[1] : unbounded;
+    if (range && count && n.min >= n.max)
+      throw SemanticError("Maximum repeats are larger than minimum repeats.");
+  }
+};
+
+/**
+\brief Emits program instructions for a pattern tree.
+*/
+class Emitter {
+ public:
+  /**
+  \param[out] program Program to emit to.
+  \param[in] reversed Emits a program matching the reversed texts.
+  */
+  Emitter(Program &program, bool reversed)
+      : program_(program), reversed_(reversed) {}
+
+  void emit(const Node &n) {
+    auto &insts = program_.insts;
+    if (insts.size() > maxProgramSize)
+      throw SemanticError("Pattern is too large to be compiled.");
+    switch (n.kind) {
+      case Node::Kind::EMPTY:
+        break;
+      case Node::Kind::NEVER:
+        add(Op::FAIL);
+        break;
+      case Node::Kind::BYTE:
+        add(Op::BYTE, n.byte);
+        break;
+      case Node::Kind::ANY:
+        add(Op::ANY);
+        break;
+      case Node::Kind::CLASS:
+        emit_class(n.set);
+        break;
+      case Node::Kind::ASSERT:
+        add(Op::ASSERT, static_cast<uint32_t>(assertion(n.assertion)));
+        break;
+      case Node::Kind::CONCAT:
+        if (reversed_) {
+          for (auto it = n.children.rbegin(); it != n.children.rend(); ++it) {
+            emit(*it);
+          }
+        } else {
+          for (auto &child : n.children) {
+            emit(child);
+          }
+        }
+        break;
+      case Node::Kind::GROUP:
+        add(Op::SAVE, 2 * n.group);
+        emit(n.children[0]);
+        add(Op::SAVE, 2 * n.group + 1);
+        break;
+      case Node::Kind::ALTERNATE: {
+        std::vector<uint32_t> jumps;
+        for (size_t i = 0; i + 1 < n.children.size(); ++i) {
+          uint32_t split = add(Op::SPLIT);
+          insts[split].arg = split + 1;
+          emit(n.children[i]);
+          jumps.push_back(add(Op::JUMP));
+          insts[split].alt = pc();
+        }
+        emit(n.children.back());
+        for (uint32_t j : jumps) {
+          insts[j].arg = pc();
+        }
+        break;
+      }
+      case Node::Kind::REPEAT:
+        emit_repeat(n);
+        break;
+    }
+  }
+
+ protected:
+  Program &program_;
+  bool reversed_;
+
+  /**
+  \brief Swaps the text anchors of reversed programs.
+  */
+  Assertion assertion(Assertion a) const {
+    if (!reversed_)
+      return a;
+    switch (a) {
+      case Assertion::BEGIN_TEXT:
+        return Assertion::END_TEXT;
+      case Assertion::END_TEXT:
+        return Assertion::BEGIN_TEXT;
+      default:
+        return a;
+    }
+  }
+
+  uint32_t pc() const { return static_cast<uint32_t>(program_.insts.size()); }
+
+  uint32_t add(Op op, uint32_t arg = 0) {
+    program_.insts.push_back(Inst{op, arg, 0});
+    return pc() - 1;
+  }
+
+  /**
+  \brief Sets the targets of a split; the preferred target is taken first.
+  */
+  void set_split(uint32_t split, uint32_t taken, uint32_t skipped,
+                 bool greedy) {
+    program_.insts[split].arg = greedy ? taken : skipped;
+    program_.insts[split].alt = greedy ? skipped : taken;
+  }
+
+  void emit_class(const ByteSet &set) {
+    ByteSet all;
+    all.invert();
+    if (set == all) {
+      add(Op::ANY);
+      return;
+    }
+    auto &classes = program_.classes;
+    auto found = std::find(classes.begin(), classes.end(), set);
+    if (found == classes.end()) {
+      classes.push_back(set);
+      found = classes.end() - 1;
+    }
+    add(Op::CLASS, static_cast<uint32_t>(found - classes.begin()));
+  }
+
+  void emit_repeat(const Node &n) {
+    const Node &child = n.children[0];
+    for (size_t i = 0; i < n.min; ++i) {
+      emit(child);
+    }
+    if (n.max == unbounded) {
+      uint32_t split = add(Op::SPLIT);
+      emit(child);
+      add(Op::JUMP, split);
+      set_split(split, split + 1, pc(), n.greedy);
+      return;
+    }
+    // optional copies are nested, each may skip the rest
+    std::vector<uint32_t> splits;
+    for (size_t i = n.min; i < n.max; ++i) {
+      splits.push_back(add(Op::SPLIT));
+      emit(child);
+    }
+    for (uint32_t split : splits) {
+      set_split(split, split + 1, pc(), n.greedy);
+    }
+  }
+};
+
+/**
+\brief Returns true if a pattern matches only at the beginning of the text.
+*/
+bool anchored(const Node &n) {
+  switch (n.kind) {
+    case Node::Kind::ASSERT:
+      return n.assertion == Assertion::BEGIN_TEXT;
+    case Node::Kind::GROUP:
+      return anchored(n.children[0]);
+    case Node::Kind::REPEAT:
+      return n.min > 0 && anchored(n.children[0]);
+    case Node::Kind::CONCAT:
+      for (auto &child : n.children) {
+        if (child.kind != Node::Kind::EMPTY)
+          return anchored(child);
+      }
+      return false;
+    case Node::Kind::ALTERNATE:
+      return std::all_of(n.children.begin(), n.children.end(),
+                         [](const Node &c) { return anchored(c); });
+    default:
+      return false;
+  }
+}
+
+}  // namespace
+
+bool assertion_holds(Assertion a, std::string_view text, size_t position) {
+  switch (a) {
+    case Assertion::BEGIN_TEXT:
+      return position == 0;
+    case Assertion::END_TEXT:
+      return position == text.size();
+    default: {
+      auto word = [text](size_t i) {
+        return is_word_byte(static_cast<unsigned char>(text[i]));
+      };
+      bool before = position > 0 && word(position - 1);
+      bool after = position < text.size() && word(position);
+      return (before != after) == (a == Assertion::WORD_BOUNDARY);
+    }
+  }
+}
+
+ByteSet set_bytes(std::string_view set) {
+  return Parser::set(set);
+}
+
+Program compile(const std::vector<ReonSymbol> &symbols, bool reversed) {
+  Program program;
+  Node pattern = Parser(symbols, program).parse();
+  program.anchored = !reversed && anchored(pattern);
+
+  Emitter emitter(program, reversed);
+  Node whole = Node::of(Node::Kind::GROUP);
+  whole.group = 0;
+  whole.children.push_back(std::move(pattern));
+  emitter.emit(whole);
+  program.insts.push_back(Inst{Op::MATCH, 0, 0});
+  return program;
+}
+
+}  // namespace reon
+
+/*** End of file reon_program.cpp ***/
@@ -0,0 +1,441 @@
+/**
+\file reon_redos.cpp
+\brief Implements the static analysis of catastrophic backtracking in reon
+patterns.
+\author Radek Vít
+*/
+#include <reon_program.h>
+#include <reon_redos.h>
+#include <memory>
+#include <unordered_set>
+
+namespace reon {
+
+namespace {
+
+/**
+\brief Maximal number of NFA state pairs visited when comparing the languages
+of the subexpressions of a single pattern.
+*/
+constexpr size_t overlapBudget = 1 << 20;
+
+/**
+\brief Returns true if an escape of a 're' terminal is an assertion.
+*/
+bool assertion(char escaped) {
+  return std::string_view("A^Z$bB").find(escaped) != std::string_view::npos;
+}
+
+/**
+\brief Finds the issues of a single AST.
+*/
+class Analyzer {
+ public:
+  explicit Analyzer(const Ast &ast)
+      : ast_(ast), nullable_(ast.size(), -1), programs_(ast.size()) {}
+
+  std::vector<RedosIssue> analyze() {
+    if (ast_.root() != Ast::none)
+      visit(ast_.root());
+    return std::move(issues_);
+  }
+
+ protected:
+  const Ast &ast_;
+  /**
+  \brief Memoized nullable(), -1 if not computed yet.
+  */
+  std::vector<int8_t> nullable_;
+  /**
+  \brief Compiled subexpressions by node, empty if not compiled yet.
+  */
+  std::vector<std::unique_ptr<Program>> programs_;
+  std::unordered_set<uint32_t> uncompilable_;
+  /**
+  \brief Repeats already reported.
+  */
+  std::unordered_set<uint32_t> reported_;
+  std::vector<RedosIssue> issues_;
+  size_t budget_ = overlapBudget;
+
+  void visit(uint32_t n) {
+    const AstNode &a = ast_[n];
+    for (uint32_t c = a.first; c != Ast::none; c = ast_[c].next) {
+      visit(c);
+    }
+    if (a.kind == AstKind::REPEAT && unbounded_repeat(a.text))
+      repeat(n);
+    else if (a.kind == AstKind::SEQUENCE)
+      sequence(n);
+  }
+
+  /**
+  \brief Returns true if a subtree can match the empty string.
+  */
+  bool nullable(uint32_t n) {
+    if (nullable_[n] >= 0)
+      return nullable_[n];
+    const AstNode &a = ast_[n];
+    bool result = false;
+    switch (a.kind) {
+      case AstKind::SEQUENCE:
+        result = true;
+        for (uint32_t c = a.first; c != Ast::none; c = ast_[c].next) {
+          result = result && nullable(c);
+        }
+        break;
+      case AstKind::ALTERNATION:
+        result = a.first == Ast::none;
+        for (uint32_t c = a.first; c != Ast::none; c = ast_[c].next) {
+          result = nullable(c) || result;
+        }
+        break;
+      case AstKind::REPEAT:
+        result = optional_repeat(a.text) || nullable(a.first);
+        break;
+      case AstKind::LITERAL:
+        result = true;
+        for (size_t i = 0; i < a.text.size(); ++i) {
+          if (a.text[i] != '\\' || i + 1 == a.text.size()) {
+            result = false;
+            break;
+          }
+          if (!assertion(a.text[++i])) {
+            result = false;
+            break;
+          }
+        }
+        break;
+      case AstKind::GROUP:
+        result = nullable(a.first);
+        break;
+      case AstKind::CONDITIONAL:
+        result = !(a.flags & HAS_ELSE) || nullable(a.first) ||
+                 nullable(ast_[a.first].next);
+        break;
+      case AstKind::LOOKAROUND:
+      case AstKind::COMMENT:
+        result = true;
+        break;
+      case AstKind::NEVER:
+      case AstKind::SET:
+      case AstKind::REFERENCE:
+        break;
+    }
+    nullable_[n] = result;
+    return result;
+  }
+
+  /**
+  \brief Collects unbounded repeats and alternatives of a subtree that can
+  match alone, while the rest of the subtree matches the empty string.
+  */
+  void exposed(uint32_t n, std::vector<uint32_t> &out) {
+    const AstNode &a = ast_[n];
+    switch (a.kind) {
+      case AstKind::SEQUENCE: {
+        size_t required = 0;
+        uint32_t last = Ast::none;
+        for (uint32_t c = a.first; c != Ast::none; c = ast_[c].next) {
+          if (!nullable(c)) {
+            ++required;
+            last = c;
+          }
+        }
+        if (required == 1) {
+          exposed(last, out);
+        } else if (required == 0) {
+          for (uint32_t c = a.first; c != Ast::none; c = ast_[c].next) {
+            exposed(c, out);
+          }
+        }
+        return;
+      }
+      case AstKind::ALTERNATION:
+        out.push_back(n);
+        for (uint32_t c = a.first; c != Ast::none; c = ast_[c].next) {
+          exposed(c, out);
+        }
+        return;
+      case AstKind::REPEAT:
+        if (unbounded_repeat(a.text))
+          out.push_back(n);
+        else
+          exposed(a.first, out);
+        return;
+      case AstKind::GROUP:
+        return exposed(a.first, out);
+      default:
+        return;
+    }
+  }
+
+  /**
+  \brief Compiles a subtree, caches the result.
+  \returns nullptr if the subtree cannot be compiled.
+  */
+  const Program *program(uint32_t n) {
+    if (programs_[n])
+      return programs_[n].get();
+    if (uncompilable_.count(n))
+      return nullptr;
+    std::vector<ReonSymbol> symbols;
+    lower_ast(ast_, n, symbols);
+    try {
+      programs_[n] = std::make_unique<Program>(compile(symbols));
+    } catch (SemanticError &) {
+      uncompilable_.insert(n);
+      return nullptr;
+    }
+    return programs_[n].get();
+  }
+
+  /**
+  \brief Returns true if a subtree can match a non-empty text.
+  */
+  bool consumes(uint32_t n) {
+    const Program *p = program(n);
+    if (!p)
+      return !nullable(n);
+    for (uint32_t pc : closure(*p, 0)) {
+      if (p->insts[pc].op != Op::MATCH)
+        return true;
+    }
+    return false;
+  }
+
+  /**
+  \brief Collects the byte matching instructions and the match reachable from
+  an instruction without reading.
+  */
+  static void closure(const Program &p, uint32_t pc, std::vector<uint32_t> &out,
+                      std::vector<bool> &seen) {
+    std::vector<uint32_t> stack{pc};
+    while (!stack.empty()) {
+      pc = stack.back();
+      stack.pop_back();
+      if (seen[pc])
+        continue;
+      seen[pc] = true;
+      const Inst &i = p.insts[pc];
+      switch (i.op) {
+        case Op::JUMP:
+          stack.push_back(i.arg);
+          break;
+        case Op::SPLIT:
+          stack.push_back(i.alt);
+          stack.push_back(i.arg);
+          break;
+        case Op::SAVE:
+        case Op::ASSERT:
+          // assertions are assumed to hold
+          stack.push_back(pc + 1);
+          break;
+        case Op::FAIL:
+          break;
+        default:
+          out.push_back(pc);
+      }
+    }
+  }
+
+  static std::vector<uint32_t> closure(const Program &p, uint32_t pc) {
+    std::vector<uint32_t> out;
+    std::vector<bool> seen(p.insts.size());
+    closure(p, pc, out, seen);
+    return out;
+  }
+
+  static ByteSet bytes(const Program &p, const Inst &i) {
+    ByteSet set;
+    if (i.op == Op::BYTE)
+      set.set(static_cast<unsigned char>(i.arg));
+    else if (i.op == Op::CLASS)
+      set = p.classes[i.arg];
+    else
+      set.invert();
+    return set;
+  }
+
+  static bool intersect(const ByteSet &a, const ByteSet &b) {
+    for (size_t i = 0; i < 4; ++i) {
+      if (a.bits[i] & b.bits[i])
+        return true;
+    }
+    return false;
+  }
+
+  /**
+  \brief Returns true if two subtrees can match the same non-empty text.
+  Subtrees that cannot be compiled or exceed the budget are assumed distinct.
+  */
+  bool overlap(uint32_t x, uint32_t y) {
+    const Program *a = program(x);
+    const Program *b = program(y);
+    if (!a || !b)
+      return false;
+    // pairs of instructions reading the same text
+    std::unordered_set<uint64_t> seen;
+    std::vector<std::pair<uint32_t, uint32_t>> work;
+    auto add = [&](const std::vector<uint32_t> &as,
+                   const std::vector<uint32_t> &bs, bool read) {
+      for (uint32_t i : as) {
+        for (uint32_t j : bs) {
+          bool matchA = a->insts[i].op == Op::MATCH;
+          bool matchB = b->insts[j].op == Op::MATCH;
+          if (matchA && matchB && read)
+            return true;
+          if (matchA || matchB)
+            continue;
+          if (seen.insert(uint64_t{i} << 32 | j).second)
+            work.emplace_back(i, j);
+        }
+      }
+      return false;
+    };
+    add(closure(*a, 0), closure(*b, 0), false);
+    while (!work.empty()) {
+      if (budget_ == 0)
+        return false;
+      --budget_;
+      auto [i, j] = work.back();
+      work.pop_back();
+      if (!intersect(bytes(*a, a->insts[i]), bytes(*b, b->insts[j])))
+        continue;
+      if (add(closure(*a, i + 1), closure(*b, j + 1), true))
+        return true;
+    }
+    return false;
+  }
+
+  void report(uint32_t n, uint32_t other, bool exponential,
+              std::string message) {
+    if (!reported_.insert(n).second)
+      return;
+    std::string_view otherText =
+        other == Ast::none ? std::string_view{} : ast_[other].text;
+    issues_.push_back(
+        RedosIssue{exponential, ast_[n].text, otherText, std::move(message)});
+  }
+
+  /**
+  \brief Checks the body of an unbounded repeat.
+  */
+  void repeat(uint32_t n) {
+    std::vector<uint32_t> inner;
+    exposed(ast_[n].first, inner);
+    for (uint32_t i : inner) {
+      const AstNode &a = ast_[i];
+      if (a.kind == AstKind::REPEAT) {
+        if (consumes(a.first))
+          report(i, n, true,
+                 "Nested unbounded repeats can backtrack exponentially; this "
+                 "repeat can match the text of several iterations of the "
+                 "enclosing repeat.");
+        continue;
+      }
+      std::vector<uint32_t> branches;
+      for (uint32_t c = a.first; c != Ast::none; c = ast_[c].next) {
+        branches.push_back(c);
+      }
+      for (size_t x = 0; x < branches.size(); ++x) {
+        for (size_t y = x + 1; y < branches.size(); ++y) {
+          if (!overlap(branches[x], branches[y]))
+            continue;
+          report(n, Ast::none, true,
+                 "Alternatives " + std::to_string(x + 1) + " and " +
+                     std::to_string(y + 1) +
+                     " within this unbounded repeat can match the same text "
+                     "and backtrack exponentially.");
+          return;
+        }
+      }
+    }
+  }
+
+  /**
+  \brief Checks unbounded repeats following each other in a sequence.
+  */
+  void sequence(uint32_t n) {
+    std::vector<uint32_t> children;
+    for (uint32_t c = ast_[n].first; c != Ast::none; c = ast_[c].next) {
+      children.push_back(c);
+    }
+    std::vector<uint32_t> left;
+    std::vector<uint32_t> right;
+    for (size_t i = 0; i < children.size(); ++i) {
+      left.clear();
+      exposed(children[i], left);
+      for (size_t j = i + 1; j < children.size() && !left.empty(); ++j) {
+        right.clear();
+        exposed(children[j], right);
+        for (uint32_t x : left) {
+          for (uint32_t y : right) {
+            if (ast_[x].kind != AstKind::REPEAT ||
+                ast_[y].kind != AstKind::REPEAT)
+              continue;
+            if (overlap(ast_[x].first, ast_[y].first))
+              report(y, x, false,
+                     "Unbounded repeats following each other can match the "
+                     "same text and backtrack polynomially.");
+          }
+        }
+        // a required element separates the following repeats
+        if (!nullable(children[j]))
+          break;
+      }
+    }
+  }
+};
+
+}  // namespace
+
+std::vector<RedosIssue> find_redos(const Ast &ast) {
+  return Analyzer(ast).analyze();
+}
+
+std::string RedosChecker::location(std::string_view at,
+                                   const ReonLexer &lexer) {
+  ReonLexer::uint_type row;
+  ReonLexer::uint_type col;
+  if (!lexer.locate(at, row, col))
+    return "";
+  return " on row " + std::to_string(row) + ", col " + std::to_string(col);
+}
+
+void RedosChecker::check(const std::vector<ReonSymbol> &symbols,
+                         const ReonLexer &lexer, std::string_view source) {
+  warnings_.clear();
+  if (!build_ast(symbols, ast_))
+    return;
+  for (auto &issue : find_redos(ast_)) {
+    ++issues_;
+    RedosWarning warning;
+    lexer.locate(issue.at, warning.row, warning.col);
+    std::string message =
+        std::string(issue.exponential ? "Exponential" : "Polynomial") +
+        " backtracking" + location(issue.at, lexer) + ": " + issue.message;
+    if (!issue.other.empty()) {
+      std::string other = location(issue.other, lexer);
+      if (!other.empty())
+        message += " See also the repeat" + other + ".";
+    }
+    warning.message = message;
+    warnings_.push_back(std::move(warning));
+    if (strict_)
+      throw SemanticError(message);
+    if (stream_)
+      print(*stream_, warnings_.back(), source);
+  }
+}
+
+void RedosChecker::print(std::ostream &os, const RedosWarning &warning,
+                         std::string_view source) {
+  if (!source.empty())
+    os << source << ": ";
+  os << "ReDoS warning: " << warning.message << "\n";
+}
+
+}  // namespace reon
+
+/*** End of file reon_redos.cpp ***/
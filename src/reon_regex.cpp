@@ -0,0 +1,350 @@
+/**
+\file reon_regex.cpp
+\brief Implements native matching of reon patterns with lazy DFAs and a Pike
+VM.
+\author Radek Vít
+*/
+#include <reon_dfa.h>
+#include <reon_regex.h>
+#include <reon_translation.h>
+#include <algorithm>
+#include <mutex>
+
+namespace reon {
+
+namespace {
+
+/**
+\brief Ordered set of threads of the Pike VM with their captures.
+
+Uses a sparse set, clearing is constant time.
+*/
+class ThreadList {
+ public:
+  ThreadList(size_t size, size_t slots)
+      : sparse_(size), dense_(size), captures_(size * slots), slots_(slots) {}
+
+  bool contains(uint32_t pc) const {
+    uint32_t i = sparse_[pc];
+    return i < count_ && dense_[i] == pc;
+  }
+  uint32_t add(uint32_t pc) {
+    sparse_[pc] = count_;
+    dense_[count_] = pc;
+    return count_++;
+  }
+  void clear() { count_ = 0; }
+  uint32_t size() const { return count_; }
+  uint32_t pc(uint32_t i) const { return dense_[i]; }
+  size_t *captures(uint32_t i) { return &captures_[i * slots_]; }
+
+ protected:
+  std::vector<uint32_t> sparse_;
+  std::vector<uint32_t> dense_;
+  std::vector<size_t> captures_;
+  size_t slots_;
+  uint32_t count_ = 0;
+};
+
+/**
+\brief Pike VM over a program.
+*/
+class PikeVm {
+ public:
+  PikeVm(const Program &program, std::string_view text)
+      : insts_(program.insts),
+        classes_(program.classes),
+        text_(text),
+        slots_(2 * program.groupCount),
+        current_(insts_.size(), slots_),
+        next_(insts_.size(), slots_) {}
+
+  /**
+  \brief Finds the match preferred by the program in text[from, to).
+  \param[in] anchorEnd Matches must end at to.
+  */
+  bool run(Match *match, bool anchorBegin, bool anchorEnd, size_t from,
+           size_t to) {
+    std::vector<size_t> start(slots_, Match::npos);
+    std::vector<size_t> best;
+    bool matched = false;
+    for (size_t position = from;; ++position) {
+      if (!matched && (position == from || !anchorBegin)) {
+        // the new thread has the lowest priority
+        add_thread(current_, 0, position, start.data());
+      } else if (current_.size() == 0) {
+        break;
+      }
+      next_.clear();
+      for (uint32_t i = 0; i < current_.size(); ++i) {
+        uint32_t pc = current_.pc(i);
+        const Inst &inst = insts_[pc];
+        size_t *captures = current_.captures(i);
+        bool consumes = false;
+        switch (inst.op) {
+          case Op::MATCH:
+            if (anchorEnd && position != to)
+              break;
+            matched = true;
+            best.assign(captures, captures + slots_);
+            // threads with lower priority are cut off
+            i = current_.size();
+            break;
+          case Op::BYTE:
+            consumes = position < text_.size() &&
+                       static_cast<unsigned char>(text_[position]) == inst.arg;
+            break;
+          case Op::CLASS:
+            consumes = position < text_.size() &&
+                       in_class(inst.arg, text_[position]);
+            break;
+          case Op::ANY:
+            consumes = position < text_.size();
+            break;
+          default:
+            break;
+        }
+        if (consumes)
+          add_thread(next_, pc + 1, position + 1, captures);
+      }
+      if (position == to)
+        break;
+      std::swap(current_, next_);
+    }
+    if (matched && match) {
+      match->subject = text_;
+      match->offsets = std::move(best);
+    }
+    return matched;
+  }
+
+ protected:
+  /**
+  \brief Marks stack entries that continue at a pc.
+  */
+  static constexpr uint32_t noSlot = UINT32_MAX;
+
+  /**
+  \brief Entry of the stack of add_thread; either a pc to follow or a capture
+  slot to restore.
+  */
+  struct Entry {
+    uint32_t pc;
+    uint32_t slot;
+    size_t value;
+  };
+
+  const std::vector<Inst> &insts_;
+  const std::vector<ByteSet> &classes_;
+  std::string_view text_;
+  size_t slots_;
+  ThreadList current_;
+  ThreadList next_;
+  std::vector<Entry> stack_;
+
+  bool in_class(uint32_t set, char c) const {
+    return classes_[set].test(static_cast<unsigned char>(c));
+  }
+
+  /**
+  \brief Adds a thread and all threads reachable without consuming input, in
+  priority order.
+  \param[in] captures Captures of the thread; restored before returning.
+  */
+  void add_thread(ThreadList &list, uint32_t pc0, size_t position,
+                  size_t *captures) {
+    stack_.push_back(Entry{pc0, noSlot, 0});
+    while (!stack_.empty()) {
+      Entry e = stack_.back();
+      stack_.pop_back();
+      if (e.slot != noSlot) {
+        captures[e.slot] = e.value;
+        continue;
+      }
+      uint32_t pc = e.pc;
+      while (!list.contains(pc)) {
+        uint32_t i = list.add(pc);
+        const Inst &inst = insts_[pc];
+        if (inst.op == Op::JUMP) {
+          pc = inst.arg;
+        } else if (inst.op == Op::SPLIT) {
+          stack_.push_back(Entry{inst.alt, noSlot, 0});
+          pc = inst.arg;
+        } else if (inst.op == Op::SAVE) {
+          stack_.push_back(Entry{0, inst.arg, captures[inst.arg]});
+          captures[inst.arg] = position;
+          ++pc;
+        } else if (inst.op == Op::ASSERT) {
+          if (!assertion_holds(static_cast<Assertion>(inst.arg), text_,
+                               position))
+            break;
+          ++pc;
+        } else {
+          if (inst.op != Op::FAIL)
+            std::copy(captures, captures + slots_, list.captures(i));
+          break;
+        }
+      }
+    }
+  }
+};
+
+}  // namespace
+
+/**
+\brief DFAs of a program with their own copies of the programs, so that they
+stay valid when the Regex is moved.
+
+Each search checks out a cache of the DFAs and returns it when done, so
+concurrent searches only contend for the pool and not for the scan.
+*/
+struct Regex::Dfas {
+  /**
+  \brief States of the DFAs built by the searches of one thread at a time.
+  */
+  struct Cache {
+    explicit Cache(const Dfas &d)
+        : unanchored(d.program, false, false),
+          anchored(d.program, true, false),
+          reverse(d.reversed, true, true) {}
+
+    LazyDfa unanchored;
+    LazyDfa anchored;
+    /**
+    \brief Finds the beginning of a match from its end.
+    */
+    LazyDfa reverse;
+  };
+
+  /**
+  \brief Returns a cache to the pool when the search ends.
+  */
+  class Checkout {
+   public:
+    explicit Checkout(Dfas &d) : dfas_(d), cache_(d.acquire()) {}
+    ~Checkout() { dfas_.release(std::move(cache_)); }
+    Checkout(const Checkout &) = delete;
+    Checkout &operator=(const Checkout &) = delete;
+
+    Cache *operator->() const { return cache_.get(); }
+
+   private:
+    Dfas &dfas_;
+    std::unique_ptr<Cache> cache_;
+  };
+
+  Dfas(const Program &p, Program r) : program(p), reversed(std::move(r)) {}
+
+  /**
+  \brief Takes a cache from the pool or creates one if all are in use.
+  */
+  std::unique_ptr<Cache> acquire() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (!pool.empty()) {
+        auto cache = std::move(pool.back());
+        pool.pop_back();
+        return cache;
+      }
+    }
+    return std::make_unique<Cache>(*this);
+  }
+
+  void release(std::unique_ptr<Cache> cache) {
+    std::lock_guard<std::mutex> lock(mutex);
+    pool.push_back(std::move(cache));
+  }
+
+  Program program;
+  Program reversed;
+  /**
+  \brief Caches not used by any search; grows to the largest number of
+  concurrent searches.
+  */
+  std::vector<std::unique_ptr<Cache>> pool;
+  std::mutex mutex;
+};
+
+Regex::Regex(const std::vector<ReonSymbol> &symbols)
+    : program_(reon::compile(symbols)) {
+  if (LazyDfa::supported(program_))
+    dfas_ = std::make_unique<Dfas>(program_, reon::compile(symbols, true));
+  Ast ast;
+  prefilter_ = reon::prefilter(symbols, ast);
+}
+
+Regex::Regex(Regex &&) noexcept = default;
+Regex &Regex::operator=(Regex &&) noexcept = default;
+Regex::~Regex() = default;
+
+Regex Regex::compile(std::string_view source) {
+  ReonTranslation t{std::make_unique<ReonLexer>()};
+  return Regex(t.parse_string(source));
+}
+
+Regex Regex::compile_file(const std::string &path) {
+  ReonTranslation t{std::make_unique<ReonLexer>()};
+  return Regex(t.parse_file(path));
+}
+
+bool Regex::search(std::string_view text, Match *match) const {
+  return find(text, match, false);
+}
+
+bool Regex::match(std::string_view text, Match *match) const {
+  return find(text, match, true);
+}
+
+bool Regex::full_match(std::string_view text, Match *match) const {
+  if (!prefilter_.accepts(text, true))
+    return false;
+  return run(text, match, true, true);
+}
+
+size_t Regex::group_index(std::string_view name) const {
+  for (auto &group : program_.groupNames) {
+    if (group.first == name)
+      return group.second;
+  }
+  return Match::npos;
+}
+
+bool Regex::find(std::string_view text, Match *match, bool anchorBegin) const {
+  if (!prefilter_.accepts(text, anchorBegin || program_.anchored))
+    return false;
+  if (!dfas_)
+    return run(text, match, anchorBegin, false);
+  anchorBegin = anchorBegin || program_.anchored;
+
+  Dfas::Checkout cache(*dfas_);
+  LazyDfa &forward = anchorBegin ? cache->anchored : cache->unanchored;
+  size_t end = 0;
+  auto result = forward.forward(text, match == nullptr, end);
+  if (result == LazyDfa::Result::GAVE_UP)
+    return run(text, match, anchorBegin, false);
+  if (result == LazyDfa::Result::NO_MATCH || !match)
+    return result == LazyDfa::Result::MATCH;
+
+  size_t begin = 0;
+  if (!anchorBegin &&
+      cache->reverse.reverse(text, end, begin) != LazyDfa::Result::MATCH)
+    return run(text, match, anchorBegin, false);
+  if (program_.groupCount == 1) {
+    match->subject = text;
+    match->offsets = {begin, end};
+    return true;
+  }
+  // groups are captured only within the match
+  return run(text, match, true, true, begin, end);
+}
+
+bool Regex::run(std::string_view text, Match *match, bool anchorBegin,
+                bool anchorEnd, size_t from, size_t to) const {
+  PikeVm vm(program_, text);
+  return vm.run(match, anchorBegin || program_.anchored, anchorEnd, from,
+                std::min(to, text.size()));
+}
+
+}  // namespace reon
+
+/*** End of file reon_regex.cpp ***/
@@ -0,0 +1,351 @@
+/**
+\file reon_server.cpp
+\brief Implements the compile server of reon.
+\author Radek Vít
+*/
+#include <reon_server.h>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define REON_SOCKETS 1
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+namespace reon {
+
+#ifdef REON_SOCKETS
+
+namespace {
+
+/**
+\brief Largest accepted request; larger ones close the connection.
+*/
+constexpr uint32_t maxRequest = 1 << 26;
+/**
+\brief Size of a single read from a connection.
+*/
+constexpr size_t readSize = 1 << 16;
+
+volatile sig_atomic_t stopping = 0;
+
+void stop(int) { stopping = 1; }
+
+uint32_t read_u32(const char *p) {
+  auto b = reinterpret_cast<const unsigned char *>(p);
+  return uint32_t{b[0]} << 24 | uint32_t{b[1]} << 16 | uint32_t{b[2]} << 8 |
+         uint32_t{b[3]};
+}
+
+void write_u32(std::string &out, uint32_t x) {
+  out.push_back(static_cast<char>(x >> 24));
+  out.push_back(static_cast<char>(x >> 16));
+  out.push_back(static_cast<char>(x >> 8));
+  out.push_back(static_cast<char>(x));
+}
+
+bool set_nonblocking(int fd) {
+  int flags = fcntl(fd, F_GETFL);
+  return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+/**
+\brief A client connection.
+*/
+struct Connection {
+  int fd;
+  /**
+  \brief Received bytes of incomplete requests.
+  */
+  std::string in{};
+  /**
+  \brief Responses not sent yet.
+  */
+  std::string out{};
+  size_t sent = 0;
+  /**
+  \brief Set when the client stopped sending; the connection closes once all
+  responses are sent.
+  */
+  bool closing = false;
+};
+
+/**
+\brief Poll loop over the listening socket and the connections.
+*/
+class Server {
+ public:
+  Server(const std::string &path, const Options &options, std::ostream &log)
+      : path_(path), compiler_(options), log_(log) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address.sun_path))
+      throw std::invalid_argument("Invalid socket path " + path + ".");
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    remove_stale(address);
+    listener_ = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener_ < 0)
+      fail("Could not create a socket");
+    if (bind(listener_, reinterpret_cast<sockaddr *>(&address),
+             sizeof(address)) != 0) {
+      fail("Could not bind " + path);
+    }
+    bound_ = true;
+    if (listen(listener_, SOMAXCONN) != 0 || !set_nonblocking(listener_))
+      fail("Could not listen on " + path);
+  }
+
+  ~Server() {
+    for (auto &c : connections_) {
+      close(c.fd);
+    }
+    if (listener_ >= 0)
+      close(listener_);
+    if (bound_)
+      unlink(path_.c_str());
+  }
+
+  void run() {
+    std::vector<pollfd> fds;
+    while (!stopping) {
+      fds.clear();
+      fds.push_back(pollfd{listener_, POLLIN, 0});
+      for (auto &c : connections_) {
+        short events = c.closing ? 0 : POLLIN;
+        if (c.sent < c.out.size())
+          events |= POLLOUT;
+        fds.push_back(pollfd{c.fd, events, 0});
+      }
+      if (poll(fds.data(), fds.size(), -1) < 0) {
+        if (errno == EINTR)
+          continue;
+        fail("Polling failed");
+      }
+      size_t kept = 0;
+      for (size_t i = 0; i < connections_.size(); ++i) {
+        Connection &c = connections_[i];
+        short events = fds[i + 1].revents;
+        bool alive = true;
+        if (events & (POLLIN | POLLHUP | POLLERR))
+          alive = receive(c);
+        if (alive && c.sent < c.out.size())
+          alive = send(c);
+        if (!alive || (c.closing && c.sent == c.out.size())) {
+          close(c.fd);
+          continue;
+        }
+        if (kept != i)
+          connections_[kept] = std::move(c);
+        ++kept;
+      }
+      connections_.resize(kept);
+      if (fds[0].revents & POLLIN)
+        accept_all();
+    }
+  }
+
+ protected:
+  std::string path_;
+  Compiler compiler_;
+  std::ostream &log_;
+  int listener_ = -1;
+  /**
+  \brief Set once the socket file exists and must be removed.
+  */
+  bool bound_ = false;
+  std::vector<Connection> connections_;
+
+  [[noreturn]] void fail(const std::string &message) {
+    throw std::runtime_error(message + ": " + std::strerror(errno) + ".");
+  }
+
+  /**
+  \brief Removes a socket left by a server that no longer runs.
+  */
+  void remove_stale(const sockaddr_un &address) {
+    struct stat s;
+    if (lstat(path_.c_str(), &s) != 0 || !S_ISSOCK(s.st_mode))
+      return;
+    int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (probe < 0)
+      fail("Could not create a socket");
+    bool live = connect(probe, reinterpret_cast<const sockaddr *>(&address),
+                        sizeof(address)) == 0;
+    close(probe);
+    if (live) {
+      throw std::runtime_error("Another server is listening on " + path_ +
+                               ".");
+    }
+    unlink(path_.c_str());
+  }
+
+  void accept_all() {
+    while (true) {
+      int fd = accept(listener_, nullptr, nullptr);
+      if (fd < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+          log_ << "Could not accept a connection: " << std::strerror(errno)
+               << ".\n";
+        return;
+      }
+      if (!set_nonblocking(fd)) {
+        close(fd);
+        continue;
+      }
+      connections_.push_back(Connection{fd});
+    }
+  }
+
+  /**
+  \brief Reads what the client sent and answers complete requests.
+  \returns False if the connection failed or a request is too large.
+
+  Requests are answered after each read, so a length prefix over maxRequest
+  closes the connection before the request is buffered.
+  */
+  bool receive(Connection &c) {
+    char buffer[readSize];
+    while (!c.closing) {
+      ssize_t n = read(c.fd, buffer, readSize);
+      if (n > 0) {
+        c.in.append(buffer, n);
+        if (!handle(c))
+          return false;
+        continue;
+      }
+      if (n == 0) {
+        c.closing = true;
+        break;
+      }
+      if (errno == EINTR)
+        continue;
+      if (errno == EAGAIN || errno == EWOULDBLOCK)
+        break;
+      log_ << "Could not read a request: " << std::strerror(errno) << ".\n";
+      return false;
+    }
+    return true;
+  }
+
+  /**
+  \brief Answers the complete requests of a connection.
+  \returns False if a request is too large.
+  */
+  bool handle(Connection &c) {
+    size_t position = 0;
+    while (c.in.size() - position >= 4) {
+      uint32_t length = read_u32(c.in.data() + position);
+      if (length > maxRequest) {
+        log_ << "Request of " << length << " bytes is too large.\n";
+        return false;
+      }
+      if (c.in.size() - position - 4 < length)
+        break;
+      respond(c, std::string_view{c.in.data() + position + 4, length});
+      position += 4 + size_t{length};
+    }
+    c.in.erase(0, position);
+    return true;
+  }
+
+  void respond(Connection &c, std::string_view input) {
+    Result result = compiler_.compile(input);
+    std::string messages;
+    for (auto &d : result.diagnostics) {
+      messages += d.message;
+      messages += '\n';
+    }
+    write_u32(c.out, static_cast<uint32_t>(result.code));
+    write_u32(c.out, static_cast<uint32_t>(result.output.size()));
+    c.out += result.output;
+    write_u32(c.out, static_cast<uint32_t>(messages.size()));
+    c.out += messages;
+  }
+
+  /**
+  \brief Sends pending responses.
+  \returns False if the connection failed.
+  */
+  bool send(Connection &c) {
+    while (c.sent < c.out.size()) {
+      ssize_t n = write(c.fd, c.out.data() + c.sent, c.out.size() - c.sent);
+      if (n >= 0) {
+        c.sent += n;
+        continue;
+      }
+      if (errno == EINTR)
+        continue;
+      if (errno == EAGAIN || errno == EWOULDBLOCK)
+        return true;
+      // clients may leave without reading their responses
+      if (errno != EPIPE && errno != ECONNRESET)
+        log_ << "Could not send a response: " << std::strerror(errno) << ".\n";
+      return false;
+    }
+    c.out.clear();
+    c.sent = 0;
+    return true;
+  }
+};
+
+/**
+\brief Installs the signal handlers of the server and restores the previous
+ones.
+*/
+class Signals {
+ public:
+  Signals() {
+    stopping = 0;
+    struct sigaction action {};
+    action.sa_handler = stop;
+    sigemptyset(&action.sa_mask);
+    // no SA_RESTART, so that poll returns on signals
+    sigaction(SIGINT, &action, &int_);
+    sigaction(SIGTERM, &action, &term_);
+    action.sa_handler = SIG_IGN;
+    sigaction(SIGPIPE, &action, &pipe_);
+  }
+
+  ~Signals() {
+    sigaction(SIGINT, &int_, nullptr);
+    sigaction(SIGTERM, &term_, nullptr);
+    sigaction(SIGPIPE, &pipe_, nullptr);
+  }
+
+ protected:
+  struct sigaction int_ {};
+  struct sigaction term_ {};
+  struct sigaction pipe_ {};
+};
+
+}  // namespace
+
+int serve(const std::string &path, const Options &options, std::ostream &log) {
+  Signals signals;
+  Server server{path, options, log};
+  server.run();
+  return 0;
+}
+
+#else
+
+int serve(const std::string &, const Options &, std::ostream &) {
+  throw std::runtime_error("The compile server requires Unix domain sockets.");
+}
+
+#endif
+
+}  // namespace reon
+
+/*** End of file reon_server.cpp ***/
@@ -0,0 +1,169 @@
+/**
+\file reon_stats.cpp
+\brief Implements the per-phase statistics and the trace of translations.
+\author Radek Vít
+*/
+#include <reon_stats.h>
+#include <algorithm>
+#include <cstdio>
+#include <iomanip>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define REON_RUSAGE 1
+#include <sys/resource.h>
+#endif
+
+namespace reon {
+
+namespace {
+
+double milliseconds(Stats::Clock::duration time) {
+  return std::chrono::duration<double, std::milli>(time).count();
+}
+
+double microseconds(Stats::Clock::duration time) {
+  return std::chrono::duration<double, std::micro>(time).count();
+}
+
+void write_json_string(std::ostream &os, std::string_view s) {
+  os << '"';
+  for (char c : s) {
+    if (c == '"' || c == '\\') {
+      os << '\\' << c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      char escaped[8];
+      std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+      os << escaped;
+    } else {
+      os << c;
+    }
+  }
+  os << '"';
+}
+
+/**
+\brief Prints the input side of a rule, e.g. "RE-list -> , RE RE-list".
+*/
+void print_rule(std::ostream &os, const Rule &rule) {
+  os << nonterminalNames[static_cast<size_t>(rule.nonterminal)] << " ->";
+  if (rule.inputSize == 0)
+    os << " (empty)";
+  for (uint8_t i = 0; i < rule.inputSize; ++i) {
+    const RuleSymbol &s = rule.input[i];
+    os << ' '
+       << (s.nonterminal ? nonterminalNames[s.id] : terminalNames[s.id]);
+  }
+}
+
+}  // namespace
+
+void Stats::merge(const Stats &other) {
+  for (size_t i = 0; i < phaseCount; ++i) {
+    time_[i] += other.time_[i];
+  }
+  for (size_t i = 0; i < terminalCount; ++i) {
+    tokens_[i] += other.tokens_[i];
+  }
+  for (size_t i = 0; i < ruleCount; ++i) {
+    rules_[i] += other.rules_[i];
+  }
+  inputs_ += other.inputs_;
+  bytesIn_ += other.bytesIn_;
+  bytesOut_ += other.bytesOut_;
+  checkDepth_ = std::max(checkDepth_, other.checkDepth_);
+  events_.insert(events_.end(), other.events_.begin(), other.events_.end());
+}
+
+void Stats::report(std::ostream &os, Clock::duration wall) const {
+  auto line = [&os](const char *name, Clock::duration time) {
+    os << std::left << std::setw(12) << name << std::right << std::fixed
+       << std::setprecision(3) << std::setw(12) << milliseconds(time)
+       << " ms\n";
+  };
+  os << "Statistics of " << inputs_ << " inputs, " << bytesIn_
+     << " bytes in, " << bytesOut_ << " bytes out:\n";
+  for (size_t i = 0; i < phaseCount; ++i) {
+    line(phaseNames[i], time_[i]);
+  }
+  line("wall", wall);
+
+  size_t tokens = 0;
+  for (size_t count : tokens_) {
+    tokens += count;
+  }
+  os << "Tokens: " << tokens << "\n";
+  for (size_t i = 0; i < terminalCount; ++i) {
+    if (tokens_[i] > 0)
+      os << "  " << std::left << std::setw(20) << terminalNames[i]
+         << std::right << std::setw(10) << tokens_[i] << "\n";
+  }
+
+  size_t expansions = 0;
+  for (size_t count : rules_) {
+    expansions += count;
+  }
+  os << "Rule expansions: " << expansions << "\n";
+  for (size_t i = 0; i < ruleCount; ++i) {
+    if (rules_[i] == 0)
+      continue;
+    os << "  " << std::setw(10) << rules_[i] << "  ";
+    print_rule(os, reonGrammar[i]);
+    os << "\n";
+  }
+
+  os << "Peak lookbehind nesting: " << checkDepth_ << "\n";
+  size_t rss = peak_rss();
+  if (rss > 0)
+    os << "Peak RSS: " << rss / 1024 << " KiB\n";
+}
+
+void Stats::write_trace(std::ostream &os) const {
+  os << "{\"traceEvents\": [";
+  uint32_t threads = 0;
+  for (auto &e : events_) {
+    threads = std::max(threads, e.thread + 1);
+  }
+  const char *separator = "\n  ";
+  for (uint32_t t = 0; t < threads; ++t) {
+    os << separator << "{\"name\": \"thread_name\", \"ph\": \"M\", "
+       << "\"pid\": 1, \"tid\": " << t << ", \"args\": {\"name\": \"worker "
+       << t << "\"}}";
+    separator = ",\n  ";
+  }
+  os << std::fixed << std::setprecision(3);
+  for (auto &e : events_) {
+    os << separator << "{\"name\": \"" << e.name
+       << "\", \"cat\": \"reon\", \"ph\": \"X\", \"ts\": "
+       << microseconds(e.start - epoch_)
+       << ", \"dur\": " << microseconds(e.end - e.start)
+       << ", \"pid\": 1, \"tid\": " << e.thread;
+    if (!e.input.empty()) {
+      os << ", \"args\": {\"input\": ";
+      write_json_string(os, e.input);
+      os << "}";
+    }
+    os << "}";
+    separator = ",\n  ";
+  }
+  os << "\n], \"displayTimeUnit\": \"ms\"}\n";
+}
+
+size_t peak_rss() {
+#ifdef REON_RUSAGE
+  rusage usage{};
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return 0;
+#ifdef __APPLE__
+  return static_cast<size_t>(usage.ru_maxrss);
+#else
+  // kilobytes on Linux and the BSDs
+  return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+#else
+  return 0;
+#endif
+}
+
+}  // namespace reon
+
+/*** End of file reon_stats.cpp ***/
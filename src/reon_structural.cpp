@@ -0,0 +1,191 @@
+/**
+\file reon_structural.cpp
+\brief Implements the structural index of reon input.
+\author Radek Vít
+*/
+#include <reon_structural.h>
+#include <cstring>
+
+#if defined(__AVX2__)
+#define REON_AVX2 1
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#define REON_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+/**
+\brief Returns a mask with bits set between pairs of set bits of x, including
+the first bit of each pair.
+*/
+uint64_t prefix_xor(uint64_t x) {
+  x ^= x << 1;
+  x ^= x << 2;
+  x ^= x << 4;
+  x ^= x << 8;
+  x ^= x << 16;
+  x ^= x << 32;
+  return x;
+}
+
+/**
+\brief Finds characters escaped by a backslash.
+\param[in] backslash Backslashes in the block.
+\param[in,out] carry 1 if the first character of the block is escaped. Set for
+the next block.
+\returns Mask of escaped characters.
+*/
+uint64_t find_escaped(uint64_t backslash, uint64_t &carry) {
+  constexpr uint64_t evenBits = 0x5555555555555555ULL;
+  backslash &= ~carry;
+  uint64_t followsEscape = backslash << 1 | carry;
+  // sequences of backslashes of odd length escape the following character
+  uint64_t oddStarts = backslash & ~evenBits & ~followsEscape;
+  uint64_t evenStarts = oddStarts + backslash;
+  carry = evenStarts < oddStarts;
+  uint64_t invert = evenStarts << 1;
+  return (evenBits ^ invert) & followsEscape;
+}
+
+#ifdef REON_AVX2
+uint64_t eq(__m256i lo, __m256i hi, char c) {
+  __m256i v = _mm256_set1_epi8(c);
+  uint32_t l = _mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, v));
+  uint32_t h = _mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, v));
+  return uint64_t{h} << 32 | l;
+}
+#elif defined(REON_SSE2)
+uint64_t movemask(__m128i a, __m128i b, __m128i c, __m128i d) {
+  return uint64_t{static_cast<uint16_t>(_mm_movemask_epi8(a))} |
+         uint64_t{static_cast<uint16_t>(_mm_movemask_epi8(b))} << 16 |
+         uint64_t{static_cast<uint16_t>(_mm_movemask_epi8(c))} << 32 |
+         uint64_t{static_cast<uint16_t>(_mm_movemask_epi8(d))} << 48;
+}
+
+uint64_t eq(const __m128i (&v)[4], char c) {
+  __m128i s = _mm_set1_epi8(c);
+  return movemask(_mm_cmpeq_epi8(v[0], s), _mm_cmpeq_epi8(v[1], s),
+                  _mm_cmpeq_epi8(v[2], s), _mm_cmpeq_epi8(v[3], s));
+}
+#endif
+
+}  // namespace
+
+StructuralIndex::Masks StructuralIndex::classify(const char *block) {
+  Masks m;
+#ifdef REON_AVX2
+  __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block));
+  __m256i hi =
+      _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block + 32));
+  m.quote = eq(lo, hi, '"');
+  m.backslash = eq(lo, hi, '\\');
+  m.structural = eq(lo, hi, '[') | eq(lo, hi, ']') | eq(lo, hi, '{') |
+                 eq(lo, hi, '}') | eq(lo, hi, ',') | eq(lo, hi, ':');
+  m.space = eq(lo, hi, ' ') | eq(lo, hi, '\t') | eq(lo, hi, '\n') |
+            eq(lo, hi, '\v') | eq(lo, hi, '\f') | eq(lo, hi, '\r');
+  // signed compare; characters above 0x7F are control characters as well
+  __m256i limit = _mm256_set1_epi8(0x20);
+  uint32_t l = _mm256_movemask_epi8(_mm256_cmpgt_epi8(limit, lo));
+  uint32_t h = _mm256_movemask_epi8(_mm256_cmpgt_epi8(limit, hi));
+  m.control = uint64_t{h} << 32 | l;
+#elif defined(REON_SSE2)
+  __m128i v[4];
+  for (size_t i = 0; i < 4; ++i) {
+    v[i] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + 16 * i));
+  }
+  m.quote = eq(v, '"');
+  m.backslash = eq(v, '\\');
+  m.structural = eq(v, '[') | eq(v, ']') | eq(v, '{') | eq(v, '}') |
+                 eq(v, ',') | eq(v, ':');
+  m.space = eq(v, ' ') | eq(v, '\t') | eq(v, '\n') | eq(v, '\v') |
+            eq(v, '\f') | eq(v, '\r');
+  // signed compare; characters above 0x7F are control characters as well
+  __m128i limit = _mm_set1_epi8(0x20);
+  m.control = movemask(
+      _mm_cmplt_epi8(v[0], limit), _mm_cmplt_epi8(v[1], limit),
+      _mm_cmplt_epi8(v[2], limit), _mm_cmplt_epi8(v[3], limit));
+#else
+  for (size_t i = 0; i < blockSize; ++i) {
+    uint64_t bit = uint64_t{1} << i;
+    char c = block[i];
+    switch (c) {
+      case '"':
+        m.quote |= bit;
+        break;
+      case '\\':
+        m.backslash |= bit;
+        break;
+      case '[':
+      case ']':
+      case '{':
+      case '}':
+      case ',':
+      case ':':
+        m.structural |= bit;
+        break;
+      case ' ':
+      case '\t':
+      case '\n':
+      case '\v':
+      case '\f':
+      case '\r':
+        m.space |= bit;
+        break;
+      default:
+        break;
+    }
+    // characters above 0x7F are control characters, as in the SIMD paths
+    if (static_cast<signed char>(c) < 0x20)
+      m.control |= bit;
+  }
+#endif
+  return m;
+}
+
+void StructuralIndex::build(const char *data, size_t size) {
+  positions_.clear();
+  positions_.reserve(size / 8 + 1);
+  firstControl_ = size;
+  // state carried between blocks
+  uint64_t escapedCarry = 0;
+  uint64_t inStringCarry = 0;
+  // the beginning of input acts as whitespace
+  uint64_t separatorCarry = 1;
+
+  char last[blockSize];
+  for (size_t base = 0; base < size; base += blockSize) {
+    const char *block = data + base;
+    if (size - base < blockSize) {
+      // the last block is padded with whitespace
+      std::memset(last, ' ', blockSize);
+      std::memcpy(last, block, size - base);
+      block = last;
+    }
+    Masks m = classify(block);
+
+    uint64_t escaped = find_escaped(m.backslash, escapedCarry);
+    uint64_t quote = m.quote & ~escaped;
+    // opening quotes and string contents
+    uint64_t inString = prefix_xor(quote) ^ inStringCarry;
+    inStringCarry = static_cast<uint64_t>(static_cast<int64_t>(inString) >> 63);
+
+    uint64_t control = m.control & inString & ~escaped;
+    if (control && firstControl_ == size)
+      firstControl_ = base + __builtin_ctzll(control);
+
+    uint64_t separator = m.structural | m.space | quote;
+    uint64_t scalar = ~separator & ~inString;
+    uint64_t scalarStart = scalar & (separator << 1 | separatorCarry);
+    separatorCarry = separator >> 63;
+
+    uint64_t bits = (m.structural & ~inString) | quote | scalarStart;
+    while (bits) {
+      positions_.push_back(static_cast<uint32_t>(base + __builtin_ctzll(bits)));
+      bits &= bits - 1;
+    }
+  }
+}
+
+/*** End of file reon_structural.cpp ***/
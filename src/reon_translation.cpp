@@ -0,0 +1,279 @@
+/**
+\file reon_translation.cpp
+\brief Implements the table driven translation of reon.
+\author Radek Vít
+*/
+#include <reon_translation.h>
+
+using reon::LLTable;
+using reon::NonterminalId;
+using reon::OutputId;
+using reon::Rule;
+using reon::RuleSymbol;
+using reon::TerminalId;
+
+template <typename F>
+void ReonTranslation::read(std::string_view source, F set) {
+  if (!stats_)
+    return set();
+  auto start = reon::Stats::Clock::now();
+  set();
+  stats_->phase(reon::Phase::READ, start, reon::Stats::Clock::now(), source);
+}
+
+void ReonTranslation::run(std::istream &input, std::ostream &output) {
+  read({}, [&] { lexer_->set_stream(input); });
+  translate();
+  generate(output);
+}
+
+void ReonTranslation::run_file(const string &path, std::ostream &output) {
+  read(path, [&] { lexer_->set_file(path); });
+  translate(path);
+  generate(output, path);
+}
+
+void ReonTranslation::run_file(const string &path, std::string &output) {
+  read(path, [&] { lexer_->set_file(path); });
+  translate(path);
+  generate(output, path);
+}
+
+void ReonTranslation::run_string(std::string_view input, std::string &output,
+                                 std::string_view source) {
+  read(source, [&] { lexer_->set_string(input); });
+  translate(source);
+  generate(output, source);
+}
+
+const vector<ReonSymbol> &ReonTranslation::parse(std::istream &input) {
+  read({}, [&] { lexer_->set_stream(input); });
+  translate();
+  return terminals_;
+}
+
+const vector<ReonSymbol> &ReonTranslation::parse_file(const string &path) {
+  read(path, [&] { lexer_->set_file(path); });
+  translate(path);
+  return terminals_;
+}
+
+const vector<ReonSymbol> &ReonTranslation::parse_string(
+    std::string_view input) {
+  read({}, [&] { lexer_->set_string(input); });
+  translate();
+  return terminals_;
+}
+
+void ReonTranslation::translate(std::string_view source) {
+  if (stats_)
+    translate_input<true>(source);
+  else
+    translate_input<false>(source);
+}
+
+template <bool collect>
+void ReonTranslation::translate_input(std::string_view source) {
+  using Clock = reon::Stats::Clock;
+  Clock::time_point start;
+  Clock::duration lexTime{};
+  if constexpr (collect) {
+    stats_->count_input(lexer_->input_size());
+    start = Clock::now();
+  }
+  auto next_token = [&]() {
+    if constexpr (collect) {
+      auto lexStart = Clock::now();
+      ReonToken t = lexer_->get_token();
+      lexTime += Clock::now() - lexStart;
+      stats_->count_token(t.id);
+      return t;
+    } else {
+      return lexer_->get_token();
+    }
+  };
+
+  nodes_.clear();
+  stack_.clear();
+
+  nodes_.push_back(OutputNode{
+      RuleSymbol{true, static_cast<uint8_t>(reon::reonStart)}, false, {},
+      noNode});
+  stack_.push_back(StackEntry{nodes_.back().symbol, 0, {}, 0});
+
+  ReonToken token = next_token();
+  while (!stack_.empty()) {
+    StackEntry top = stack_.back();
+    stack_.pop_back();
+    if (!top.symbol.nonterminal) {
+      if (top.symbol.id != static_cast<uint8_t>(token.id))
+        syntax_error(token.id, top);
+      for (uint8_t i = 0; i < top.targetCount; ++i) {
+        nodes_[top.targets[i]].attribute = token.attribute;
+      }
+      token = next_token();
+      continue;
+    }
+    uint8_t rule = reon::reonTable.rule(
+        static_cast<NonterminalId>(top.symbol.id), token.id);
+    if (rule == LLTable::noRule)
+      syntax_error(token.id, top);
+    if constexpr (collect)
+      stats_->count_rule(rule);
+    expand(top, reon::reonGrammar[rule]);
+  }
+  if (token.id != TerminalId::EOI) {
+    StackEntry eof{RuleSymbol{false, static_cast<uint8_t>(TerminalId::EOI)},
+                   noNode, {}, 0};
+    syntax_error(token.id, eof);
+  }
+
+  terminals_.clear();
+  for (uint32_t i = 0; i != noNode; i = nodes_[i].next) {
+    const OutputNode &n = nodes_[i];
+    if (n.empty)
+      continue;
+    terminals_.push_back(
+        ReonSymbol{static_cast<OutputId>(n.symbol.id), n.attribute});
+  }
+  if constexpr (collect) {
+    // lexing is interleaved with parsing; its event covers both
+    auto end = Clock::now();
+    stats_->add(reon::Phase::LEX, lexTime);
+    stats_->add(reon::Phase::PARSE, end - start - lexTime);
+    stats_->event("lex+parse", start, end, source);
+    start = end;
+  }
+  // passes do not change the matches
+  if (lengths_ || prefilters_) {
+    if (!reon::build_ast(terminals_, analysisAst_)) {
+      length_ = reon::MatchLength{0, 0, true};
+      prefilter_ = reon::Prefilter{};
+    } else {
+      if (lengths_)
+        length_ = reon::match_length(analysisAst_);
+      if (prefilters_)
+        prefilter_ = reon::prefilter(analysisAst_);
+    }
+  }
+  if (redos_) {
+    redos_->check(terminals_, *lexer_, source);
+    if constexpr (collect) {
+      auto end = Clock::now();
+      stats_->phase(reon::Phase::REDOS, start, end, source);
+      start = end;
+    }
+  }
+  if (passes_) {
+    passes_->run(terminals_, ast_);
+    if constexpr (collect)
+      stats_->phase(reon::Phase::PASSES, start, Clock::now(), source);
+  }
+}
+
+void ReonTranslation::expand(const StackEntry &top, const Rule &rule) {
+  // output symbols replace the expanded nonterminal in the output list
+  uint32_t node[Rule::maxSymbols];
+  uint32_t next = nodes_[top.node].next;
+  if (rule.outputSize == 0) {
+    nodes_[top.node].empty = true;
+  }
+  for (uint8_t i = 0; i < rule.outputSize; ++i) {
+    if (i == 0) {
+      node[i] = top.node;
+    } else {
+      node[i] = nodes_.size();
+      nodes_.push_back(OutputNode{});
+      nodes_[node[i - 1]].next = node[i];
+    }
+    nodes_[node[i]] = OutputNode{rule.output[i], false, {}, next};
+  }
+
+  // pairs input nonterminals with their output counterparts
+  uint32_t nonterminalNodes[Rule::maxSymbols];
+  uint8_t nonterminals = 0;
+  for (uint8_t i = 0; i < rule.outputSize; ++i) {
+    if (rule.output[i].nonterminal)
+      nonterminalNodes[nonterminals++] = node[i];
+  }
+  uint8_t terminals = 0;
+  for (uint8_t i = 0; i < rule.inputSize; ++i) {
+    if (!rule.input[i].nonterminal)
+      ++terminals;
+  }
+
+  for (uint8_t i = rule.inputSize; i-- > 0;) {
+    const RuleSymbol &symbol = rule.input[i];
+    if (symbol.nonterminal) {
+      stack_.push_back(
+          StackEntry{symbol, nonterminalNodes[--nonterminals], {}, 0});
+      continue;
+    }
+    StackEntry entry{symbol, noNode, {}, 0};
+    --terminals;
+    for (uint8_t a = 0; a < rule.actionsSize; ++a) {
+      if (rule.actions[a].terminal == terminals)
+        entry.targets[entry.targetCount++] = node[rule.actions[a].target];
+    }
+    stack_.push_back(entry);
+  }
+}
+
+void ReonTranslation::syntax_error(TerminalId id, const StackEntry &top) {
+  string expected;
+  auto add_expected = [&expected](size_t t) {
+    expected += expected.empty() ? "" : ", ";
+    expected += string{"\""} + reon::terminalNames[t] + "\"";
+  };
+  if (top.symbol.nonterminal) {
+    for (size_t t = 0; t < reon::terminalCount; ++t) {
+      if (reon::reonTable.rules[top.symbol.id][t] != LLTable::noRule)
+        add_expected(t);
+    }
+  } else {
+    add_expected(top.symbol.id);
+  }
+  string found = reon::terminalNames[static_cast<size_t>(id)];
+  if (id != TerminalId::EOI)
+    found = "\"" + found + "\"";
+  throw TranslationError("Syntax error on row " +
+                         std::to_string(lexer_->token_row()) + ", col " +
+                         std::to_string(lexer_->token_col()) +
+                         ": unexpected " + found + ", expected " + expected +
+                         ".\n");
+}
+
+void ReonTranslation::generate(std::ostream &output,
+                               std::string_view source) {
+  output_->set_output(output);
+  output_symbols(source);
+}
+
+void ReonTranslation::generate(std::string &output, std::string_view source) {
+  output_->set_output(output);
+  output_symbols(source);
+}
+
+void ReonTranslation::output_symbols(std::string_view source) {
+  auto output = [this]() {
+    output_->output(terminals_.begin(), terminals_.end());
+    if (lengths_)
+      output_->lengths(length_.min, length_.max, length_.unbounded);
+    if (prefilters_) {
+      std::string first;
+      bool ascii = prefilter_.ascii_first(first);
+      output_->prefilter(prefilter_.required, ascii ? &first : nullptr);
+    }
+  };
+  if (!stats_)
+    return output();
+  auto start = reon::Stats::Clock::now();
+  size_t written = output_->written();
+  output();
+  stats_->phase(reon::Phase::OUTPUT, start, reon::Stats::Clock::now(),
+                source);
+  stats_->count_output(output_->written() - written);
+  stats_->note_check_depth(output_->peak_checks());
+}
+
+/*** End of file reon_translation.cpp ***/
@@ -5,6 +5,10 @@
 */
 #include <reon_translation_grammar.h>
 
+namespace reon {
+
+using namespace grammar;
+
 /*
 Output terminals with special meaning:
   re          -   sequence of characters
@@ -27,128 +31,251 @@ Output special symbols:
 
 This is an LL grammar for the input.
 */
-const TranslationGrammar reonGrammar{
-    // terminals are taken from rules
-    // nonterminals are taken from rules
-    // rules
-    {
-        // first derivation
-        {"E"_nt, {"RE"_nt}, {"variable"_s, " = r\"(?s)"_t, "RE"_nt, "\"\n"_t}},
-        // empty regular expression
-        {"RE"_nt, {}},
-        // regular expression with some reon content
-        {"RE"_nt, {"REFULL"_nt}},
-        // match empty string
-        {"REFULL"_nt, {"true"_t}, {"re"_t}},
-        // don't match ever
-        {"REFULL"_nt, {"false"_t}, {"(?!)"_t}},
-        // don't match ever
-        {"REFULL"_nt, {"null"_t}, {"(?!)"_t}},
-        // string only RE
-        {"REFULL"_nt, {"string"_t}, {"re"_t}, {{0}}},
-        // append list
-        {"REFULL"_nt, {"["_t, "RE-listE"_nt, "]"_t}, {"RE-listE"_nt}},
-        // object
-        {"REFULL"_nt, {"{"_t, "OBJ"_nt, "}"_t}, {"OBJ"_nt}},
-        // repeat object
-        {"OBJ"_nt,
-         {"repeat"_t, ":"_t, "RE"_nt},
-         {"(?:"_t, "RE"_nt, ")"_t, "repeat"_t},
-         {{3}, {}}},
-        // non-greedy repeat object
-        {"OBJ"_nt,
-         {"non-greedy repeat"_t, ":"_t, "RE"_nt},
-         {"(?:"_t, "RE"_nt, ")"_t, "repeat"_t, "?"_t},
-         {{3}, {}}},
-        // character set
-        {"OBJ"_nt,
-         {"set"_t, ":"_t, "string"_t},
-         {"["_t, "set"_t, "]"_t},
-         {{}, {}, {1}}},
-        // negated character set
-        {"OBJ"_nt,
-         {"!set"_t, ":"_t, "string"_t},
-         {"[^"_t, "set"_t, "]"_t},
-         {{}, {}, {1}}},
-        // alternation list
-        {"OBJ"_nt,
-         {"alternatives"_t, ":"_t, "["_t, "RE-AlistE"_nt, "]"_t},
-         {"RE-AlistE"_nt}},
-        // group
-        {"OBJ"_nt,
-         {"group"_t, ":"_t, "RE"_nt},
-         {"("_t, "group"_s, "RE"_nt, ")"_t}},
-        // group with identifier
-        {"OBJ"_nt,
-         {"named group"_t, ":"_t, "RE"_nt},
-         {"(?P<"_t, "named group"_t, ">"_t, "RE"_nt, ")"_t},
-         {{1}, {}}},
-        // reference
-        {"OBJ"_nt, {"match group"_t, ":"_t, "Ref"_nt}, {"Ref"_nt}},
-        // comment
-        {"OBJ"_nt,
-         {"comment"_t, ":"_t, "string"_t},
-         {"(?#"_t, "comment"_t, ")"_t},
-         {{}, {}, {1}}},
-        // lookahead
-        {"OBJ"_nt, {"lookahead"_t, ":"_t, "RE"_nt}, {"(?="_t, "RE"_nt, ")"_t}},
-        // negative lookahead
-        {"OBJ"_nt, {"!lookahead"_t, ":"_t, "RE"_nt}, {"(?!"_t, "RE"_nt, ")"_t}},
-        // lookbehind
-        {"OBJ"_nt,
-         {"lookbehind"_t, ":"_t, "RE"_nt},
-         {"(?<="_t, "fixed_length_check"_s, "RE"_nt, "end_check"_s, ")"_t}},
-        // negative lookbehind
-        {"OBJ"_nt,
-         {"!lookbehind"_t, ":"_t, "RE"_nt},
-         {"(?<!"_t, "fixed_length_check"_s, "RE"_nt, "end_check"_s, ")"_t}},
-        // if-then[-else]
-        {"OBJ"_nt,
-         {"if"_t, ":"_t, "IfRef"_nt, ","_t, "then"_t, ":"_t, "RE"_nt,
-          "Else"_nt},
-         {"(?("_t, "IfRef"_nt, ")"_t, "RE"_nt, "Else"_nt, ")"_t}},
-        // number reference
-        {"Ref"_nt, {"number"_t}, {"\\"_t, "nref"_t}, {{1}}},
-        // identifier reference
-        {"Ref"_nt, {"string"_t}, {"(?P="_t, "ref"_t, ")"_t}, {{1}}},
-        // number reference in if-then[-else]
-        {"IfRef"_nt, {"number"_t}, {"nref"_t}, {{0}}},
-        // identifier reference in if-then[-else]
-        {"IfRef"_nt, {"string"_t}, {"ref"_t}, {{0}}},
-        // no else
-        {"Else"_nt, {}},
-        // optional else
-        {"Else"_nt, {","_t, "else"_t, ":"_t, "RE"_nt}, {"|"_t, "RE"_nt}},
-        // empty append list
-        {"RE-listE"_nt, {}},
-        // first element in append list
-        {"RE-listE"_nt, {"REFULL"_nt, "RE-list"_nt}},
-        // no more elements in append list
-        {"RE-list"_nt, {}},
-        // elements in append list
-        {"RE-list"_nt, {","_t, "RE-list-comma"_nt}, {"RE-list-comma"_nt}},
-        // no element after trailing comma in append list
-        {"RE-list-comma"_nt, {}},
-        // element after last comma in append list
-        {"RE-list-comma"_nt, {"REFULL"_nt, "RE-list"_nt}},
-        // empty alternation list
-        {"RE-AlistE"_nt, {}},
-        // first element in alternation list
-        {"RE-AlistE"_nt,
-         {"REFULL"_nt, "RE-Alist"_nt},
-         {"(?:"_t, "REFULL"_nt, "RE-Alist"_nt, ")"_t}},
-        // no more elements in alternation list
-        {"RE-Alist"_nt, {}},
-        // elements in alternation list
-        {"RE-Alist"_nt, {","_t, "RE-Alist-comma"_nt}, {"RE-Alist-comma"_nt}},
-        // no element after trailing comma in alternation list
-        {"RE-Alist-comma"_nt, {}},
-        // element after comma in alternation list
-        {"RE-Alist-comma"_nt,
-         {"REFULL"_nt, "RE-Alist"_nt},
-         {"|"_t, "REFULL"_nt, "RE-Alist"_nt}},
-    },
-    // starting nonterminal
-    "E"_nt};
+constexpr Rule reonGrammar[ruleCount]{
+    // first derivation
+    {"E"_nt, {"RE"_nt}, {"variable"_s, " = r\"(?s)"_t, "RE"_nt, "\"\n"_t}},
+    // empty regular expression
+    {"RE"_nt, {}},
+    // regular expression with some reon content
+    {"RE"_nt, {"REFULL"_nt}},
+    // match empty string
+    {"REFULL"_nt, {"true"_t}, {"re"_t}},
+    // don't match ever
+    {"REFULL"_nt, {"false"_t}, {"(?!)"_t}},
+    // don't match ever
+    {"REFULL"_nt, {"null"_t}, {"(?!)"_t}},
+    // string only RE
+    {"REFULL"_nt, {"string"_t}, {"re"_t}, {{0}}},
+    // append list
+    {"REFULL"_nt, {"["_t, "RE-listE"_nt, "]"_t}, {"RE-listE"_nt}},
+    // object
+    {"REFULL"_nt, {"{"_t, "OBJ"_nt, "}"_t}, {"OBJ"_nt}},
+    // repeat object
+    {"OBJ"_nt,
+     {"repeat"_t, ":"_t, "RE"_nt},
+     {"(?:"_t, "RE"_nt, ")"_t, "repeat"_t},
+     {{3}, {}}},
+    // non-greedy repeat object
+    {"OBJ"_nt,
+     {"non-greedy repeat"_t, ":"_t, "RE"_nt},
+     {"(?:"_t, "RE"_nt, ")"_t, "repeat"_t, "?"_t},
+     {{3}, {}}},
+    // character set
+    {"OBJ"_nt,
+     {"set"_t, ":"_t, "string"_t},
+     {"["_t, "set"_t, "]"_t},
+     {{}, {}, {1}}},
+    // negated character set
+    {"OBJ"_nt,
+     {"!set"_t, ":"_t, "string"_t},
+     {"[^"_t, "set"_t, "]"_t},
+     {{}, {}, {1}}},
+    // alternation list
+    {"OBJ"_nt,
+     {"alternatives"_t, ":"_t, "["_t, "RE-AlistE"_nt, "]"_t},
+     {"RE-AlistE"_nt}},
+    // group
+    {"OBJ"_nt,
+     {"group"_t, ":"_t, "RE"_nt},
+     {"("_t, "group"_s, "RE"_nt, ")"_t}},
+    // group with identifier
+    {"OBJ"_nt,
+     {"named group"_t, ":"_t, "RE"_nt},
+     {"(?P<"_t, "named group"_t, ">"_t, "RE"_nt, ")"_t},
+     {{1}, {}}},
+    // reference
+    {"OBJ"_nt, {"match group"_t, ":"_t, "Ref"_nt}, {"Ref"_nt}},
+    // comment
+    {"OBJ"_nt,
+     {"comment"_t, ":"_t, "string"_t},
+     {"(?#"_t, "comment"_t, ")"_t},
+     {{}, {}, {1}}},
+    // lookahead
+    {"OBJ"_nt, {"lookahead"_t, ":"_t, "RE"_nt}, {"(?="_t, "RE"_nt, ")"_t}},
+    // negative lookahead
+    {"OBJ"_nt, {"!lookahead"_t, ":"_t, "RE"_nt}, {"(?!"_t, "RE"_nt, ")"_t}},
+    // lookbehind
+    {"OBJ"_nt,
+     {"lookbehind"_t, ":"_t, "RE"_nt},
+     {"(?<="_t, "fixed_length_check"_s, "RE"_nt, "end_check"_s, ")"_t}},
+    // negative lookbehind
+    {"OBJ"_nt,
+     {"!lookbehind"_t, ":"_t, "RE"_nt},
+     {"(?<!"_t, "fixed_length_check"_s, "RE"_nt, "end_check"_s, ")"_t}},
+    // if-then[-else]
+    {"OBJ"_nt,
+     {"if"_t, ":"_t, "IfRef"_nt, ","_t, "then"_t, ":"_t, "RE"_nt,
+      "Else"_nt},
+     {"(?("_t, "IfRef"_nt, ")"_t, "RE"_nt, "Else"_nt, ")"_t}},
+    // number reference
+    {"Ref"_nt, {"number"_t}, {"\\"_t, "nref"_t}, {{1}}},
+    // identifier reference
+    {"Ref"_nt, {"string"_t}, {"(?P="_t, "ref"_t, ")"_t}, {{1}}},
+    // number reference in if-then[-else]
+    {"IfRef"_nt, {"number"_t}, {"nref"_t}, {{0}}},
+    // identifier reference in if-then[-else]
+    {"IfRef"_nt, {"string"_t}, {"ref"_t}, {{0}}},
+    // no else
+    {"Else"_nt, {}},
+    // optional else
+    {"Else"_nt, {","_t, "else"_t, ":"_t, "RE"_nt}, {"|"_t, "RE"_nt}},
+    // empty append list
+    {"RE-listE"_nt, {}},
+    // first element in append list
+    {"RE-listE"_nt, {"REFULL"_nt, "RE-list"_nt}},
+    // no more elements in append list
+    {"RE-list"_nt, {}},
+    // elements in append list
+    {"RE-list"_nt, {","_t, "RE-list-comma"_nt}, {"RE-list-comma"_nt}},
+    // no element after trailing comma in append list
+    {"RE-list-comma"_nt, {}},
+    // element after last comma in append list
+    {"RE-list-comma"_nt, {"REFULL"_nt, "RE-list"_nt}},
+    // empty alternation list
+    {"RE-AlistE"_nt, {}},
+    // first element in alternation list
+    {"RE-AlistE"_nt,
+     {"REFULL"_nt, "RE-Alist"_nt},
+     {"(?:"_t, "REFULL"_nt, "RE-Alist"_nt, ")"_t}},
+    // no more elements in alternation list
+    {"RE-Alist"_nt, {}},
+    // elements in alternation list
+    {"RE-Alist"_nt, {","_t, "RE-Alist-comma"_nt}, {"RE-Alist-comma"_nt}},
+    // no element after trailing comma in alternation list
+    {"RE-Alist-comma"_nt, {}},
+    // element after comma in alternation list
+    {"RE-Alist-comma"_nt,
+     {"REFULL"_nt, "RE-Alist"_nt},
+     {"|"_t, "REFULL"_nt, "RE-Alist"_nt}},
+};
+
+namespace {
+
+/**
+\brief FIRST and FOLLOW sets of all nonterminals.
+*/
+struct GrammarSets {
+  bool nullable[nonterminalCount] = {};
+  bool first[nonterminalCount][terminalCount] = {};
+  bool follow[nonterminalCount][terminalCount] = {};
+};
+
+/**
+\brief Adds all terminals of from to to.
+\returns True if to changed.
+*/
+constexpr bool add_all(bool (&to)[terminalCount],
+                       const bool (&from)[terminalCount]) {
+  bool changed = false;
+  for (size_t t = 0; t < terminalCount; ++t) {
+    if (from[t] && !to[t]) {
+      to[t] = true;
+      changed = true;
+    }
+  }
+  return changed;
+}
+
+/**
+\brief Computes FIRST of a rule's input suffix.
+\param[in] sets Nullable and FIRST sets of nonterminals.
+\param[in] rule Rule.
+\param[in] begin Index of the first symbol of the suffix.
+\param[out] first FIRST of the suffix.
+\returns True if the suffix can derive the empty string.
+*/
+constexpr bool suffix_first(const GrammarSets &sets, const Rule &rule,
+                            size_t begin, bool (&first)[terminalCount]) {
+  for (size_t i = begin; i < rule.inputSize; ++i) {
+    const RuleSymbol &s = rule.input[i];
+    if (!s.nonterminal) {
+      first[s.id] = true;
+      return false;
+    }
+    add_all(first, sets.first[s.id]);
+    if (!sets.nullable[s.id])
+      return false;
+  }
+  return true;
+}
+
+/**
+\brief Computes nullable, FIRST and FOLLOW sets of a grammar.
+*/
+constexpr GrammarSets make_sets(const Rule (&rules)[ruleCount],
+                                NonterminalId start) {
+  GrammarSets sets;
+  sets.follow[static_cast<size_t>(start)]
+             [static_cast<size_t>(TerminalId::EOI)] = true;
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (auto &rule : rules) {
+      size_t nt = static_cast<size_t>(rule.nonterminal);
+      bool first[terminalCount] = {};
+      bool nullable = suffix_first(sets, rule, 0, first);
+      changed |= add_all(sets.first[nt], first);
+      if (nullable && !sets.nullable[nt]) {
+        sets.nullable[nt] = true;
+        changed = true;
+      }
+    }
+  }
+  changed = true;
+  while (changed) {
+    changed = false;
+    for (auto &rule : rules) {
+      size_t nt = static_cast<size_t>(rule.nonterminal);
+      for (size_t i = 0; i < rule.inputSize; ++i) {
+        if (!rule.input[i].nonterminal)
+          continue;
+        size_t target = rule.input[i].id;
+        bool first[terminalCount] = {};
+        bool nullable = suffix_first(sets, rule, i + 1, first);
+        changed |= add_all(sets.follow[target], first);
+        if (nullable)
+          changed |= add_all(sets.follow[target], sets.follow[nt]);
+      }
+    }
+  }
+  return sets;
+}
+
+/**
+\brief Computes the predictive table of a grammar.
+*/
+constexpr LLTable make_table(const Rule (&rules)[ruleCount],
+                             NonterminalId start) {
+  LLTable table;
+  for (auto &row : table.rules) {
+    for (auto &entry : row) {
+      entry = LLTable::noRule;
+    }
+  }
+  GrammarSets sets = make_sets(rules, start);
+  for (size_t r = 0; r < ruleCount; ++r) {
+    size_t nt = static_cast<size_t>(rules[r].nonterminal);
+    bool predict[terminalCount] = {};
+    if (suffix_first(sets, rules[r], 0, predict))
+      add_all(predict, sets.follow[nt]);
+    for (size_t t = 0; t < terminalCount; ++t) {
+      if (!predict[t])
+        continue;
+      if (table.rules[nt][t] != LLTable::noRule)
+        ++table.conflicts;
+      else
+        table.rules[nt][t] = static_cast<uint8_t>(r);
+    }
+  }
+  return table;
+}
+
+}  // namespace
+
+constexpr LLTable reonTable = make_table(reonGrammar, reonStart);
+
+static_assert(reonTable.conflicts == 0, "reonGrammar must be LL(1).");
+
+}  // namespace reon
 
 /*** End of file reon_translation_grammar.cpp ***/
\ No newline at end of file
@@ -0,0 +1,103 @@
+#!/bin/sh
+# Compares the lexing and output times of two revisions of reon on a
+# document of short items of every kind, which stresses keyword recognition
+# and the dispatch of output symbols.
+# usage: ./bench_dispatch.sh [before] [after] [items]
+# Builds both revisions in temporary worktrees with the ctf library of
+# lib/ctf. The harness fits revisions whose output generator writes to a
+# stream, up to 6e3f1f3; the defaults measure 5dc18a8, which interned the
+# grammar symbols.
+before=${1:-26db403}
+after=${2:-5dc18a8}
+items=${3:-400000}
+root=$(git rev-parse --show-toplevel) || exit 1
+dir=$(mktemp -d)
+cleanup() {
+  git -C "$root" worktree remove --force "$dir/before" 2> /dev/null
+  git -C "$root" worktree remove --force "$dir/after" 2> /dev/null
+  rm -rf "$dir"
+}
+trap cleanup EXIT
+
+python3 - "$dir/dense.reon" "$items" <<'PY'
+import sys
+items = ['{"repeat *": "a"}', '{"set": "a-z"}', '{"!set": "0-9"}',
+         '{"alternatives": ["b", "c"]}', '{"non-greedy repeat 2-3": "d"}',
+         '{"lookahead": "e"}', '{"group": "f"}', 'true', 'false', '"\\\\d"']
+n = int(sys.argv[2])
+with open(sys.argv[1], "w") as f:
+    f.write("[\n" + ",\n".join(items[i % len(items)] for i in range(n)) +
+            "\n]\n")
+PY
+
+cat > "$dir/phases.cpp" <<'CPP'
+#include <reon_translation.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+
+// defined by main.cpp, which is not linked
+namespace globals {
+std::string varname = "re";
+}
+
+using Clock = std::chrono::steady_clock;
+
+struct Translation : ReonTranslation {
+  using ReonTranslation::ReonTranslation;
+  using ReonTranslation::output_;
+  using ReonTranslation::terminals_;
+};
+
+double seconds(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+int main(int, char **argv) {
+  std::string path = argv[1];
+  double lex = 1e9, output = 1e9;
+  size_t tokens = 0;
+  for (int run = 0; run < 40; ++run) {
+    ReonLexer lexer;
+    lexer.set_file(path);
+    auto start = Clock::now();
+    tokens = 0;
+    while (lexer.get_token().id != reon::TerminalId::EOI) {
+      ++tokens;
+    }
+    lex = std::min(lex, seconds(start));
+  }
+  Translation t{std::make_unique<ReonLexer>(), std::make_unique<ReonOutput>()};
+  std::ofstream discarded("/dev/null");
+  t.run_file(path, discarded);
+  for (int run = 0; run < 40; ++run) {
+    std::ofstream sink("/dev/null");
+    t.output_->set_output(sink);
+    auto start = Clock::now();
+    t.output_->output(t.terminals_.begin(), t.terminals_.end());
+    output = std::min(output, seconds(start));
+  }
+  std::printf("tokens %zu symbols %zu lex %.1f ms output %.1f ms\n", tokens,
+              t.terminals_.size(), lex * 1e3, output * 1e3);
+}
+CPP
+
+for side in before after; do
+  rev=$(eval echo \$$side)
+  git -C "$root" worktree add -q --detach "$dir/$side" "$rev" || exit 1
+  rmdir "$dir/$side/lib/ctf" 2> /dev/null
+  ln -s "$root/lib/ctf" "$dir/$side/lib/ctf"
+  make -s -C "$dir/$side" deploy > /dev/null || exit 1
+  ${CXX:-c++} -std=c++17 -O3 -DNDEBUG -pthread -I "$dir/$side" \
+    -I "$dir/$side/include" -I "$root/lib/ctf/include" "$dir/phases.cpp" \
+    $(ls "$dir/$side"/obj/*.o | grep -v /main.o) -o "$dir/$side/phases" ||
+    exit 1
+done
+
+# interleaved, as the times of a shared machine drift
+for round in 1 2 3 4; do
+  for side in before after; do
+    echo "$side $(eval echo \$$side): $("$dir/$side/phases" "$dir/dense.reon")"
+  done
+done
@@ -0,0 +1,57 @@
+#!/bin/sh
+# Compares scanning a log with the native matching engine (reon -g) to
+# Python re with the emitted pattern.
+# usage: ./bench_scan.sh [lines]
+lines=${1:-1000000}
+dir=$(mktemp -d)
+trap 'rm -rf "$dir"' EXIT
+
+cat > "$dir/pattern.reon" <<'REON'
+[
+	{"alternatives": ["ERROR", "FATAL"]},
+	" ",
+	{"repeat +": {"set": "0-9"}},
+	" user=",
+	{"group user": {"repeat +": "\w"}},
+	{"repeat *": {"!set": "\n"}},
+	"timeout"
+]
+REON
+
+python3 - "$dir/log" "$lines" <<'PY'
+import random, sys
+random.seed(1)
+levels = ["INFO", "DEBUG", "WARN", "ERROR", "FATAL"]
+words = ["request", "served", "cache", "miss", "timeout", "retry", "ok"]
+with open(sys.argv[1], "w") as f:
+    for i in range(int(sys.argv[2])):
+        f.write("%s %d user=u%d %s\n" % (random.choice(levels), i,
+                random.randrange(1000),
+                " ".join(random.choice(words) for _ in range(6))))
+PY
+
+../reon -i "$dir/pattern.reon" -o "$dir/pattern.py" || exit 1
+
+start=$(date +%s.%N)
+../reon -i "$dir/pattern.reon" -g "$dir/log" > "$dir/native" || exit 1
+end=$(date +%s.%N)
+echo "reon -g: $(awk "BEGIN{print $end - $start}") s"
+
+start=$(date +%s.%N)
+python3 - "$dir/pattern.py" "$dir/log" > "$dir/python" <<'PY'
+import re, sys
+scope = {}
+exec(open(sys.argv[1]).read(), scope)
+search = re.compile(scope["re"]).search
+with open(sys.argv[2]) as f:
+    sys.stdout.writelines(line for line in f if search(line))
+PY
+end=$(date +%s.%N)
+echo "python re: $(awk "BEGIN{print $end - $start}") s"
+
+if cmp -s "$dir/native" "$dir/python"; then
+  echo "$(wc -l < "$dir/native") matching lines, outputs equal"
+else
+  echo "outputs differ"
+  exit 1
+fi
@@ -0,0 +1,354 @@
+/**
+\file reon_bench.cpp
+\brief Microbenchmarks of the reon lexer, parser and output generator over a
+synthetic corpus. Prints the results as JSON.
+\author Radek Vít
+*/
+#include <reon.h>
+#include <reon_translation.h>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+/**
+\brief Number of calls of operator new.
+*/
+std::atomic<size_t> allocations{0};
+
+}  // namespace
+
+void *operator new(std::size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void *p = std::malloc(size ? size : 1))
+    return p;
+  throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+
+/**
+\brief Shape of a synthetic reon document.
+*/
+struct Axes {
+  /**
+  \brief Minimal size of the document in bytes.
+  */
+  size_t size = 1 << 16;
+  /**
+  \brief Nesting depth of each item of the top level list.
+  */
+  size_t depth = 2;
+  /**
+  \brief Number of alternatives of each alternatives object.
+  */
+  size_t fanout = 4;
+  /**
+  \brief Number of characters of each string.
+  */
+  size_t stringLength = 16;
+  /**
+  \brief Escapes about every fourth character of strings.
+  */
+  bool escapes = false;
+  /**
+  \brief Number of named groups wrapping the top level items.
+  */
+  size_t groups = 0;
+};
+
+/**
+\brief Generates deterministic reon documents.
+*/
+class Generator {
+ public:
+  explicit Generator(const Axes &axes) : axes_(axes) {}
+
+  std::string document() {
+    std::string doc = "[\n";
+    size_t groups = 0;
+    for (size_t item = 0; item == 0 || doc.size() < axes_.size; ++item) {
+      if (item > 0)
+        doc += ",\n";
+      doc += '\t';
+      if (groups < axes_.groups) {
+        doc += "{\"group g" + std::to_string(groups++) + "\": ";
+        node(doc, axes_.depth);
+        doc += '}';
+      } else {
+        node(doc, axes_.depth);
+      }
+    }
+    doc += "\n]\n";
+    return doc;
+  }
+
+ protected:
+  Axes axes_;
+  std::mt19937 random_{1};
+  /**
+  \brief Selects the kind of the next inner node.
+  */
+  size_t next_ = 0;
+
+  void node(std::string &doc, size_t depth) {
+    if (depth == 0)
+      return string(doc);
+    switch (next_++ % 4) {
+      case 0:
+        doc += "{\"repeat *\": ";
+        node(doc, depth - 1);
+        doc += '}';
+        return;
+      case 1:
+        doc += "{\"alternatives\": [";
+        for (size_t i = 0; i < axes_.fanout; ++i) {
+          if (i > 0)
+            doc += ", ";
+          node(doc, depth - 1);
+        }
+        doc += "]}";
+        return;
+      case 2:
+        doc += "{\"set\": \"a-z0-9_\"}, ";
+        [[fallthrough]];
+      default:
+        doc += '[';
+        node(doc, depth - 1);
+        doc += ", ";
+        node(doc, depth - 1);
+        doc += ']';
+        return;
+    }
+  }
+
+  void string(std::string &doc) {
+    static constexpr const char *escapes[] = {"\\\"", "\\n", "\\.", "\\\\"};
+    doc += '"';
+    for (size_t i = 0; i < axes_.stringLength; ++i) {
+      if (axes_.escapes && random_() % 4 == 0)
+        doc += escapes[random_() % 4];
+      else
+        doc += static_cast<char>('a' + random_() % 26);
+    }
+    doc += '"';
+  }
+};
+
+using Clock = std::chrono::steady_clock;
+
+/**
+\brief Measurements of a single benchmark.
+*/
+struct Measurement {
+  /**
+  \brief Fastest run.
+  */
+  double seconds;
+  /**
+  \brief Allocations of a run after the first one.
+  */
+  size_t allocations;
+};
+
+/**
+\brief Runs a function until minTime passes, at least three times.
+*/
+template <typename F>
+Measurement measure(F f, double minTime) {
+  // the first run sizes the reused buffers
+  f();
+  size_t before = allocations.load();
+  f();
+  Measurement m{0, allocations.load() - before};
+  double total = 0;
+  for (size_t runs = 0; runs < 3 || total < minTime; ++runs) {
+    auto start = Clock::now();
+    f();
+    double s = std::chrono::duration<double>(Clock::now() - start).count();
+    total += s;
+    if (runs == 0 || s < m.seconds)
+      m.seconds = s;
+  }
+  return m;
+}
+
+void print(std::ostream &os, const char *name, const Measurement &m,
+           size_t bytes, size_t tokens) {
+  os << "\"" << name << "\": {\"seconds\": " << m.seconds
+     << ", \"mb_per_s\": " << bytes / m.seconds / 1e6
+     << ", \"tokens_per_s\": " << tokens / m.seconds
+     << ", \"allocs_per_token\": "
+     << static_cast<double>(m.allocations) / tokens << "}";
+}
+
+/**
+\brief Benchmarks a document and prints its JSON object.
+*/
+void bench(std::ostream &os, const char *axis, size_t value, const Axes &axes,
+           double minTime) {
+  std::string doc = Generator(axes).document();
+
+  ReonLexer lexer;
+  size_t tokens = 0;
+  auto lex = [&]() {
+    lexer.set_string(doc);
+    tokens = 0;
+    while (lexer.get_token().id != reon::TerminalId::EOI) {
+      ++tokens;
+    }
+  };
+
+  // parsing includes lexing
+  ReonTranslation translation{std::make_unique<ReonLexer>()};
+  auto parse = [&]() { translation.parse_string(doc); };
+
+  std::vector<ReonSymbol> symbols = translation.parse_string(doc);
+  ReonOutput output;
+  std::string generated;
+  auto generate = [&]() {
+    generated.clear();
+    output.set_output(generated);
+    output.output(symbols.begin(), symbols.end());
+  };
+
+  Measurement lexed = measure(lex, minTime);
+  Measurement parsed = measure(parse, minTime);
+  Measurement outputs = measure(generate, minTime);
+
+  os << "    {\"axis\": \"" << axis << "\", \"value\": " << value
+     << ", \"bytes\": " << doc.size() << ", \"tokens\": " << tokens
+     << ", \"symbols\": " << symbols.size() << ",\n     ";
+  print(os, "lex", lexed, doc.size(), tokens);
+  os << ",\n     ";
+  print(os, "parse", parsed, doc.size(), tokens);
+  os << ",\n     ";
+  print(os, "output", outputs, doc.size(), tokens);
+  os << "}";
+}
+
+/**
+\brief Parses a key=value argument of --generate.
+*/
+void set_axis(Axes &axes, const std::string &arg) {
+  size_t eq = arg.find('=');
+  if (eq == std::string::npos)
+    throw std::invalid_argument("Expected key=value, got " + arg + ".");
+  std::string key = arg.substr(0, eq);
+  size_t value = std::stoul(arg.substr(eq + 1));
+  if (key == "size")
+    axes.size = value;
+  else if (key == "depth")
+    axes.depth = value;
+  else if (key == "fanout")
+    axes.fanout = value;
+  else if (key == "length")
+    axes.stringLength = value;
+  else if (key == "escapes")
+    axes.escapes = value != 0;
+  else if (key == "groups")
+    axes.groups = value;
+  else
+    throw std::invalid_argument("Unknown axis " + key + ".");
+}
+
+void print_help() {
+  std::cout
+      << "reon_bench - benchmarks reon over a synthetic corpus.\n\n"
+         "usage: ./reon_bench [--quick] [--min-time seconds]\n"
+         "       ./reon_bench --generate [key=value...]\n\n"
+         "Prints a JSON object with the lexing, parsing and output throughput "
+         "of documents\nscaled along each axis. Parsing includes lexing.\n"
+         "--quick: Benchmarks fewer and smaller documents.\n"
+         "--min-time seconds: Minimal time of each benchmark, 0.2 s by "
+         "default.\n"
+         "--generate: Prints a document instead. Keys: size, depth, fanout, "
+         "length,\n  escapes (0 or 1), groups.\n";
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  try {
+    bool quick = false;
+    double minTime = 0.2;
+    for (int i = 1; i < argc; ++i) {
+      std::string arg{argv[i]};
+      if (arg == "--quick") {
+        quick = true;
+      } else if (arg == "--min-time" && i + 1 < argc) {
+        minTime = std::stod(argv[++i]);
+      } else if (arg == "--generate") {
+        Axes axes;
+        while (++i < argc) {
+          set_axis(axes, argv[i]);
+        }
+        std::cout << Generator(axes).document();
+        return 0;
+      } else if (arg == "-h" || arg == "--help") {
+        print_help();
+        return 0;
+      } else {
+        throw std::invalid_argument("Unknown argument " + arg + ".");
+      }
+    }
+
+    struct Sweep {
+      const char *axis;
+      std::vector<size_t> values;
+      void (*apply)(Axes &, size_t);
+    };
+    std::vector<Sweep> sweeps = {
+        {"size",
+         quick ? std::vector<size_t>{1 << 12, 1 << 16}
+               : std::vector<size_t>{1 << 12, 1 << 16, 1 << 20, 1 << 24},
+         [](Axes &a, size_t v) { a.size = v; }},
+        {"depth", {0, 2, 4, 6}, [](Axes &a, size_t v) { a.depth = v; }},
+        {"fanout", {1, 4, 16, 64}, [](Axes &a, size_t v) { a.fanout = v; }},
+        {"string_length",
+         {4, 64, 1024},
+         [](Axes &a, size_t v) { a.stringLength = v; }},
+        {"escaped_string_length",
+         {4, 64, 1024},
+         [](Axes &a, size_t v) {
+           a.stringLength = v;
+           a.escapes = true;
+         }},
+        {"groups", {0, 10, 100, 1000}, [](Axes &a, size_t v) { a.groups = v; }},
+    };
+
+    std::cout << "{\n  \"version\": \"" << reon::version
+              << "\",\n  \"min_time\": " << minTime
+              << ",\n  \"results\": [\n";
+    bool first = true;
+    for (auto &sweep : sweeps) {
+      for (size_t value : sweep.values) {
+        Axes axes;
+        if (quick)
+          axes.size = 1 << 14;
+        sweep.apply(axes, value);
+        if (!first)
+          std::cout << ",\n";
+        first = false;
+        bench(std::cout, sweep.axis, value, axes, minTime);
+      }
+    }
+    std::cout << "\n  ]\n}\n";
+  } catch (std::exception &e) {
+    std::cerr << "reon_bench: " << e.what() << "\n";
+    return 1;
+  }
+  return 0;
+}
+
+/*** End of file reon_bench.cpp ***/
@@ -0,0 +1,146 @@
+/**
+\file reon_incremental_test.cpp
+\brief Checks that edits of an incremental translation give the same results
+as translating the edited document again, with and without passes, and the
+same output as reon with passes. Prints a line for each edit and returns 1 if
+any of them differs.
+\author Radek Vít
+*/
+#include <reon.h>
+#include <reon_incremental.h>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+/**
+\brief Replaces the first occurrence of a string in the document.
+*/
+struct Edit {
+  std::string find;
+  std::string replacement;
+};
+
+struct Case {
+  const char *name;
+  std::string text;
+  std::vector<Edit> edits;
+};
+
+/**
+\brief Result of a translation: the output or the failure.
+*/
+struct Result {
+  bool valid;
+  std::string output;
+};
+
+Result translate(reon::IncrementalTranslation &t, const std::string &text) {
+  try {
+    return Result{true, t.set_text(text)};
+  } catch (TranslationException &) {
+    return Result{false, {}};
+  }
+}
+
+Result edit(reon::IncrementalTranslation &t, size_t offset, size_t length,
+            const std::string &replacement) {
+  try {
+    return Result{true, t.edit(offset, length, replacement)};
+  } catch (TranslationException &) {
+    return Result{false, {}};
+  }
+}
+
+const std::vector<Case> cases = {
+    {"string edits",
+     R"([{"repeat *": "x"}, {"set": "a-d"}, "end"])",
+     {{"\"x\"", "\"xyz\""}, {"a-d", "a-z0-9"}, {"end", "stop"}}},
+    {"edits rewritten by the passes",
+     R"([{"repeat *": "x"}, {"alternatives": ["ab", "ac", false]}])",
+     {{"\"x\"", "\"y\""}, {"\"ac\"", "\"ad\""}, {"\"y\"", "\"yz\""}}},
+    {"group defining edits",
+     R"([{"group": "a"}, {"group name": "b"}, {"match group": 1}])",
+     {{"{\"group\": \"a\"}", "{\"group\": [{\"group\": \"a\"}, \"c\"]}"},
+      {"\"b\"", "{\"group inner\": \"b\"}"},
+      {"{\"match group\": 1}", "{\"match group\": \"inner\"}"},
+      {"[{\"group\": [{\"group\": \"a\"}, \"c\"]}, ", "["}}},
+    {"lookbehind edits",
+     R"([{"lookbehind": {"alternatives": ["ab", "cd"]}}, "x"])",
+     {{"\"cd\"", "\"ef\""},
+      {"\"x\"", "{\"!lookbehind\": \"y\"}"},
+      {"\"y\"", "{\"repeat 3\": \"y\"}"}}},
+    {"edits that fail and fix the document",
+     R"([{"repeat 2-5": "a"}, {"group g": "b"}, {"match group": "g"}])",
+     {{"2-5", "5-2"},
+      {"5-2", "2-5"},
+      {"\"b\"}", "\"b\""},
+      {"\"b\"", "\"b\"}"},
+      {"\"g\"}", "\"h\"}"},
+      {"\"h\"}", "\"g\"}"},
+      {"\"a\"", "!\"a\""},
+      {"!\"a\"", "\"a\""}}},
+    {"lookbehind edits that fail and fix the document",
+     R"([{"lookbehind": {"alternatives": ["ab", "cd"]}}, "x"])",
+     {{"\"cd\"", "\"c\""}, {"\"c\"", "\"cd\""}}},
+};
+
+/**
+\brief Applies the edits of a case and compares their results.
+\returns False if a result differs.
+*/
+bool check(const Case &c, bool passes) {
+  bool ok = true;
+  reon::IncrementalTranslation incremental;
+  reon::IncrementalTranslation whole;
+  incremental.passes().enable_all(passes);
+  whole.passes().enable_all(passes);
+  std::string text = c.text;
+  translate(incremental, text);
+  for (size_t i = 0; i < c.edits.size(); ++i) {
+    const Edit &e = c.edits[i];
+    size_t offset = text.find(e.find);
+    std::cout << c.name << (passes ? "" : " without passes") << " " << i + 1
+              << ": ";
+    if (offset == std::string::npos) {
+      std::cout << "FAILED, edited text not found\n";
+      return false;
+    }
+    text.replace(offset, e.find.size(), e.replacement);
+    Result edited = edit(incremental, offset, e.find.size(), e.replacement);
+    Result expected = translate(whole, text);
+    // with passes, the output is the output of reon
+    if (passes && expected.valid)
+      expected.output = reon::compile(text).output;
+    if (incremental.text() != text || edited.valid != expected.valid ||
+        edited.output != expected.output ||
+        incremental.valid() != whole.valid()) {
+      std::cout << "FAILED\n";
+      std::cout << "  text:     " << text << "\n";
+      std::cout << "  edit:     " << (edited.valid ? edited.output : "error")
+                << "\n";
+      std::cout << "  expected: "
+                << (expected.valid ? expected.output : "error") << "\n";
+      ok = false;
+      continue;
+    }
+    std::cout << (edited.valid ? "success" : "success, fails") << "\n";
+  }
+  return ok;
+}
+
+}  // namespace
+
+int main() {
+  int ret = 0;
+  for (auto &c : cases) {
+    for (bool passes : {true, false}) {
+      if (!check(c, passes))
+        ret = 1;
+    }
+  }
+  return ret;
+}
+
+/*** End of file reon_incremental_test.cpp ***/
@@ -0,0 +1,64 @@
+# round trip of the compile server by Radek Vít
+# usage: serve_test.py socket tests
+# Sends pipelined requests on one connection and an oversized request on
+# another and checks the responses. Exits with 1 on a wrong response.
+import socket
+import struct
+import sys
+import time
+
+path, tf = sys.argv[1], sys.argv[2]
+
+
+def connect():
+    # the server creates the socket after it starts
+    for _ in range(500):
+        try:
+            s = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+            s.connect(path)
+            s.settimeout(10)
+            return s
+        except (FileNotFoundError, ConnectionRefusedError):
+            s.close()
+            time.sleep(0.01)
+    sys.exit("could not connect to " + path)
+
+
+def read(name):
+    with open(tf + "/" + name, "rb") as f:
+        return f.read()
+
+
+def request(data):
+    return struct.pack(">I", len(data)) + data
+
+
+def response(f):
+    code, length = struct.unpack(">II", f.read(8))
+    output = f.read(length)
+    (length,) = struct.unpack(">I", f.read(4))
+    return code, output, f.read(length)
+
+
+# requests sent at once are answered in order
+s = connect()
+s.sendall(request(read("test1_in")) + request(read("fail3_in")) +
+          request(read("test4_in")))
+f = s.makefile("rb")
+assert response(f) == (0, read("test1_expected"), b"")
+code, output, messages = response(f)
+assert code == int(read("fail3_retval")) and output == b"" and messages
+assert response(f) == (0, read("test4_expected"), b"")
+s.close()
+
+# a length over the limit closes the connection before the request is read
+s = connect()
+s.sendall(struct.pack(">I", 0xFFFFFFFF) + b"[")
+assert s.recv(1) == b""
+s.close()
+
+# the server keeps serving other connections
+s = connect()
+s.sendall(request(read("test8_in")))
+assert response(s.makefile("rb")) == (0, read("test8_expected"), b"")
+s.close()
@@ -59,6 +59,62 @@ TestFail() {
 	fi
 }
 
+# TestBatch()
+# $0: function name
+# $1: expected return code
+# $2: other arguments
+# $3...: test names translated in a single batch, fail tests produce no output
+TestBatch() {
+	expret=$1
+	args=$2
+	shift 2
+	echo "batch $args $*"
+	inputs=""
+	rm -f $tf/batch_expected
+	touch $tf/batch_expected
+	for t in "$@"; do
+		inputs="$inputs $tf/${t}_in"
+		if [ -f $tf/${t}_expected ] ; then
+			cat $tf/${t}_expected >> $tf/batch_expected
+		fi
+	done
+	.././reon $args $inputs > $tf/batch_out 2>> /dev/null
+	ret=$?
+	if [ $ret -eq $expret ] && diff $tf/batch_expected $tf/batch_out ; then
+		echo "success"
+		retval=0
+		rm $tf/batch_out $tf/batch_expected
+	else
+		echo "FAILED"
+		retval=1
+	fi
+
+	return $retval
+}
+
+# TestPython()
+# $0: function name
+# $1: test name
+# Runs the Python statements of $1_py after the output of the test; they
+# check the emitted pattern and metadata against Python re. Skipped without
+# python3.
+TestPython() {
+	echo "$1 python"
+	if ! command -v python3 > /dev/null ; then
+		echo "skipped"
+		return 0
+	fi
+	if { .././reon `cat $tf/$1_arg` < $tf/$1_in && cat $tf/$1_py ; } | python3 - ; then
+		echo "success"
+		retval=0
+	else
+		echo "FAILED"
+		retval=1
+	fi
+
+	return $retval
+}
+
 #success tests
 i=1
 testcount=`ls $tf/test*_in | wc -l`
@@ -76,6 +132,73 @@ while [ $i -le $testcount ]; do
 	i=$(( i + 1))
 done
 
+# members other than input and output are skipped, including nested values
+echo "batch --ndjson with nested members"
+printf '%s\n' \
+	'{"input": "tests/test4_in", "meta": {"x": 1, "y": [1, 2]}, "z": "a,}"}' \
+	'{"tags": ["a", {"b": "]"}], "input": "tests/test8_in"}' |
+	.././reon --ndjson > $tf/ndjson_out
+if [ $? -eq 0 ] && cat $tf/test4_expected $tf/test8_expected | diff - $tf/ndjson_out ; then
+	echo "success"
+else
+	echo "FAILED"
+	sretval=1
+fi
+rm -f $tf/ndjson_out
+
+# inputs with the same name must not overwrite the output of each other
+echo "batch -d with duplicate output names"
+mkdir -p $tf/dup/a $tf/dup/b $tf/dup/out
+cp $tf/test1_in $tf/dup/a/x.reon
+cp $tf/test4_in $tf/dup/b/x.reon
+.././reon -d $tf/dup/out $tf/dup/a/x.reon $tf/dup/b/x.reon 2>> /dev/null
+if [ $? -eq 2 ] && diff $tf/test1_expected $tf/dup/out/x.py ; then
+	echo "success"
+else
+	echo "FAILED"
+	sretval=1
+fi
+rm -rf $tf/dup
+
+# requests and responses of the compile server
+echo "compile server round trip"
+if command -v python3 > /dev/null ; then
+	rm -f $tf/serve.sock
+	.././reon --serve $tf/serve.sock 2>> /dev/null &
+	server=$!
+	python3 serve_test.py $tf/serve.sock $tf
+	ret=$?
+	kill -TERM $server
+	wait $server
+	stopped=$?
+	if [ $ret -eq 0 ] && [ $stopped -eq 0 ] && [ ! -e $tf/serve.sock ] ; then
+		echo "success"
+	else
+		echo "FAILED"
+		sretval=1
+	fi
+else
+	echo "skipped"
+fi
+
+#python tests
+for py in $tf/test*_py; do
+	[ -f "$py" ] || continue
+	TestPython `basename $py _py`
+	if [ $? -ne 0 ] ; then
+		sretval=1
+	fi
+done
+
+#incremental translation tests
+echo "incremental edits"
+if ! .././reon_incremental_test ; then
+	sretval=1
+fi
+
+# cache written by the tests
+rm -rf $tf/cache
+
 #fail tests
 i=1
 testcount=`ls $tf/fail*_in | wc -l`
@@ -90,6 +213,26 @@ while [ $i -le $testcount ]; do
 	i=$(( i + 1))
 done
 
+#batch tests
+TestBatch 0 "" test1 test2 test4
+if [ $? -ne 0 ] ; then
+	sretval=1
+fi
+TestBatch 7 "" test1 fail3 test2
+if [ $? -ne 0 ] ; then
+	sretval=1
+fi
+TestBatch 7 "-j 4" test1 test2 fail3 test4 test8 fail1 test9 test1 test2
+if [ $? -ne 0 ] ; then
+	sretval=1
+fi
+# statistics and the trace must not change the outputs
+TestBatch 0 "-j 2 --stats --trace $tf/trace.json" test1 test2 test4 test8
+if [ $? -ne 0 ] ; then
+	sretval=1
+fi
+rm -f $tf/trace.json
+
 if [ $retval -ne 0 ] ; then
 	echo "Tests failed."
 fi